@@ -29,6 +29,7 @@ import ipaddress
 from enum import IntEnum, unique
 import zmq
 from pynq.buffer import PynqBuffer
+from collections import namedtuple
 
 class SimMMIO():
     def __init__(self, zmqsocket):
@@ -174,6 +175,16 @@ class CCLOp(IntEnum):
     allreduce               = 10
     reduce_scatter          = 11
     ext_stream_krnl         = 12
+    scatterv                = 13
+    gatherv                 = 14
+    allgatherv              = 15
+    reduce_scatterv         = 16
+    sparse_allreduce        = 17
+    probe                   = 18
+    put                     = 19
+    get                     = 20
+    flush                   = 21
+    allreduce_dual_ring     = 22
     nop                     = 255
 
 @unique
@@ -185,10 +196,29 @@ class CCLOCfgFunc(IntEnum):
     open_con             = 4
     set_stack_type       = 5
     set_max_segment_size = 6
+    set_rndzv_threshold  = 7
+    set_pipeline_threshold = 8
+    set_sequencer        = 9
+    set_multicast        = 10
+
+@unique
+class CCLOProbeFunc(IntEnum):
+    blocking    = 0
+    nonblocking = 1
+
+class CCLORecvFunc(IntEnum):
+    exact       = 0
+    up_to       = 1
 
 @unique
 class ACCLReduceFunctions(IntEnum):
-    SUM = 0
+    SUM  = 0
+    MAX  = 1
+    MIN  = 2
+    PROD = 3
+    BAND = 4
+    BOR  = 5
+    BXOR = 6
 
 @unique
 class ACCLCompressionFlags(IntEnum):
@@ -245,15 +275,101 @@ class ACCLArithConfig():
             addr += 4
         return addr
 
+# arithmetic plugin TDESTs, indexed by ACCLReduceFunctions (SUM, MAX, MIN, PROD, BAND, BOR, BXOR)
+# bitwise functions are only available for integer types; floating point MAX/MIN return NaN
+# if either operand is NaN. The default configs only list SUM, the one function whose plugins
+# the block designs connect; the CCLO rejects other functions with ARITH_ERROR. Use
+# ACCL_EXTENDED_ARITH_CONFIG with the emulator, or with a design that connects the
+# reduce_sum plugins for the other functions at their TDESTs
+# bfloat16 and fp8 dtype names are those of the ml_dtypes numpy extension; compression lane
+# TDESTs 3/4 convert fp32<->bf16, 5/6 fp32<->fp8 E4M3 and 7/8 fp32<->fp8 E5M2
+# int8 compression is block-scaled (TDESTs 10/11): 64 int8 values plus one fp32 scale per
+# 64 elements, hence 68 bytes per 2^6 elements; counts must be multiples of 64
+# sparse collectives operate on buffers of (index, value) pairs sorted by index,
+# with unused capacity at the end marked by ACCL_SPARSE_EMPTY_INDEX;
+# arithmetic TDEST 28 merges two such buffers, summing values of equal indices
+ACCL_SPARSE_PAIR_DTYPE = np.dtype([('index', np.uint32), ('value', np.float32)])
+ACCL_SPARSE_EMPTY_INDEX = 0xFFFFFFFF
+# the merge replaces the last pair of a result by this marker if pairs did not fit;
+# capacity is limited to the buffers of the plugin
+ACCL_SPARSE_OVERFLOW_INDEX = 0xFFFFFFFE
+ACCL_SPARSE_MAX_PAIRS = 8192
+
 ACCL_DEFAULT_ARITH_CONFIG = {
     ('float16', 'float16'): ACCLArithConfig(2, 2, 0, 0, 0, 0, [4]),
     ('float32', 'float16'): ACCLArithConfig(4, 2, 0, 1, 1, 1, [4]),
+    ('bfloat16', 'bfloat16'): ACCLArithConfig(2, 2, 0, 0, 0, 0, [23]),
+    ('float32', 'bfloat16'): ACCLArithConfig(4, 2, 0, 3, 4, 1, [23]),
+    ('float32', 'float8_e4m3fn'): ACCLArithConfig(4, 1, 0, 5, 6, 0, [0]),
+    ('float32', 'float8_e5m2'): ACCLArithConfig(4, 1, 0, 7, 8, 0, [0]),
+    ('float32', 'int8'): ACCLArithConfig(4, 68, 6, 10, 11, 0, [0]),
     ('float32', 'float32'): ACCLArithConfig(4, 4, 0, 0, 0, 0, [0]),
+    (ACCL_SPARSE_PAIR_DTYPE.name, ACCL_SPARSE_PAIR_DTYPE.name): ACCLArithConfig(8, 8, 0, 0, 0, 0, [28]),
     ('float64', 'float64'): ACCLArithConfig(8, 8, 0, 0, 0, 0, [1]),
     ('int32'  , 'int32'  ): ACCLArithConfig(4, 4, 0, 0, 0, 0, [2]),
     ('int64'  , 'int64'  ): ACCLArithConfig(8, 8, 0, 0, 0, 0, [3]),
 }
 
+ACCL_EXTENDED_ARITH_CONFIG = dict(ACCL_DEFAULT_ARITH_CONFIG)
+ACCL_EXTENDED_ARITH_CONFIG[('bfloat16', 'bfloat16')] = ACCLArithConfig(2, 2, 0, 0, 0, 0, [23, 24, 25, 26])
+ACCL_EXTENDED_ARITH_CONFIG[('float32', 'bfloat16')] = ACCLArithConfig(4, 2, 0, 3, 4, 1, [23, 24, 25, 26])
+ACCL_EXTENDED_ARITH_CONFIG[('float32', 'float8_e4m3fn')] = ACCLArithConfig(4, 1, 0, 5, 6, 0, [0, 5, 9, 13])
+ACCL_EXTENDED_ARITH_CONFIG[('float32', 'float8_e5m2')] = ACCLArithConfig(4, 1, 0, 7, 8, 0, [0, 5, 9, 13])
+ACCL_EXTENDED_ARITH_CONFIG[('float32', 'int8')] = ACCLArithConfig(4, 68, 6, 10, 11, 0, [0, 5, 9, 13])
+ACCL_EXTENDED_ARITH_CONFIG[('float32', 'float32')] = ACCLArithConfig(4, 4, 0, 0, 0, 0, [0, 5, 9, 13])
+ACCL_EXTENDED_ARITH_CONFIG[('float64', 'float64')] = ACCLArithConfig(8, 8, 0, 0, 0, 0, [1, 6, 10, 14])
+ACCL_EXTENDED_ARITH_CONFIG[('int32'  , 'int32'  )] = ACCLArithConfig(4, 4, 0, 0, 0, 0, [2, 7, 11, 15, 17, 19, 21])
+ACCL_EXTENDED_ARITH_CONFIG[('int64'  , 'int64'  )] = ACCLArithConfig(8, 8, 0, 0, 0, 0, [3, 8, 12, 16, 18, 20, 22])
+
+# fp32 data reduced over a bf16 wire: partial sums are accumulated in fp32 and requantized
+# with stochastic rounding (compression lane TDEST 9) on every hop, avoiding the systematic
+# drift of round-to-nearest when many small contributions are added to a large partial sum
+ACCL_SR_ARITH_CONFIG = dict(ACCL_DEFAULT_ARITH_CONFIG)
+ACCL_SR_ARITH_CONFIG[('float32', 'bfloat16')] = ACCLArithConfig(4, 2, 0, 9, 4, 0, [0])
+
+# block-scaled int8 wire with reduction in the integer domain (arithmetic TDEST 27),
+# partial sums stay quantized between hops instead of being widened to fp32
+ACCL_Q8_INT_ARITH_CONFIG = dict(ACCL_DEFAULT_ARITH_CONFIG)
+ACCL_Q8_INT_ARITH_CONFIG[('float32', 'int8')] = ACCLArithConfig(4, 68, 6, 10, 11, 1, [27])
+
+def sparse_pack(buf, indices, values):
+    # write a sparse contribution into a pair buffer: sort by index, sum duplicates
+    # and mark the remaining capacity as empty
+    idx, inv = np.unique(np.asarray(indices, dtype=np.uint32), return_inverse=True)
+    assert idx.size <= buf.size, "Sparse contribution exceeds buffer capacity"
+    assert idx.size == 0 or idx[-1] < ACCL_SPARSE_OVERFLOW_INDEX, "Reserved sparse index"
+    val = np.zeros(idx.size, dtype=np.float32)
+    np.add.at(val, inv, np.asarray(values, dtype=np.float32))
+    buf['index'][:idx.size] = idx
+    buf['value'][:idx.size] = val
+    buf['index'][idx.size:] = ACCL_SPARSE_EMPTY_INDEX
+    buf['value'][idx.size:] = 0
+    return idx.size
+
+def sparse_densify(buf, size):
+    # scatter a pair buffer into a dense fp32 vector of the given size
+    valid = buf[buf['index'] != ACCL_SPARSE_EMPTY_INDEX]
+    dense = np.zeros(size, dtype=np.float32)
+    dense[valid['index']] = valid['value']
+    return dense
+
+def ring_order_from_topology(path, nranks):
+    # reads "<rank> <rack>" lines (# starts a comment) and returns a ring order visiting all ranks
+    # of a rack before moving to the next rack, so the ring crosses each inter-rack link once;
+    # racks and their ranks keep the order in which they are listed, unlisted ranks go last
+    racks = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split("#")[0].split()
+            if len(fields) == 0:
+                continue
+            rank, rack = int(fields[0]), fields[1]
+            assert 0 <= rank < nranks, f"Rank {rank} out of range in {path}"
+            racks.setdefault(rack, []).append(rank)
+    order = [r for rack in racks.values() for r in rack]
+    assert len(set(order)) == len(order), f"Duplicate rank in {path}"
+    return order + [r for r in range(nranks) if r not in order]
+
 @unique
 class ErrorCode(IntEnum):
     COLLECTIVE_OP_SUCCESS             = 0  
@@ -284,11 +400,25 @@ class ErrorCode(IntEnum):
     KRNL_STS_COUNT_ERROR              = 25
 
 TAG_ANY = 0xFFFF_FFFF
+SRC_ANY = 0xFFFF_FFFF
+RECEIVE_TRUNCATION_ERROR = 1 << 27
+RMA_WINDOW_ERROR = 1 << 28
+SPARSE_OVERFLOW_ERROR = 1 << 29
 EXCHANGE_MEM_OFFSET_ADDRESS= 0x0
 EXCHANGE_MEM_ADDRESS_RANGE = 0x2000
 RETCODE_OFFSET = 0x1FFC
 IDCODE_OFFSET = 0x1FF8
 CFGRDY_OFFSET = 0x1FF4
+# ranges open to direct writes by peers (rendezvous payload, RMA puts), base address and size each;
+# the first is the posted buffer of a rendezvous receive, managed by the CCLO, the others are windows,
+# which also hold the window handle; the CCLO serves RMA requests only for the windows listed here
+DIRECT_GRANT_OFFSET = 0x1F70
+DIRECT_GRANT_COUNT = 8
+DIRECT_GRANT_FIELDS = 4
+SESSION_INVALID = 0xFFFF_FFFF
+
+# pending message reported by a probe, nbytes is its size on the wire
+ACCLMessage = namedtuple("ACCLMessage", ["src", "tag", "nbytes"])
 
 class accl():
     """
@@ -300,6 +430,17 @@ class accl():
         #define supported types and corresponding arithmetic config
         self.arith_config = {}
         self.arithcfg_addr = 0
+        #address of the probe status and of the counts/displacements table for vector collectives
+        self.probe_addr = 0
+        self.vtable_addr = 0
+        #one-sided access windows by key
+        self.windows = {}
+        #window descriptors and communicators created at runtime are allocated downwards from the top of exchange memory,
+        #below the direct write grants, the first of which belongs to the CCLO
+        self.exchmem_top = DIRECT_GRANT_OFFSET
+        self.next_grant = 1
+        #id of the next communicator created at runtime, the world communicator has id 0
+        self.next_comm_id = 1
         #define an empty list of RX spare buffers
         self.rx_buffer_spares = []
         self.rx_buffer_size = 0
@@ -440,6 +581,9 @@ class accl():
         for key in self.arith_config.keys():
             #write configuration into exchange memory
             addr = self.arith_config[key].write(self.cclo.mmio, addr)
+        #the probe status (flag, src, tag, byte count) and the vector collective table go after the arithmetic configs
+        self.probe_addr = addr
+        self.vtable_addr = addr + 16
 
     def setup_rx_buffers(self, nbufs, bufsize, devicemem):
         addr = self.rx_buffers_adr
@@ -467,9 +611,12 @@ class accl():
             addr += 4
             self.cclo.write(addr, bufsize)
             # clear remaining fields
-            for _ in range(4,8):
+            for _ in range(4,12):
                 addr += 4
                 self.cclo.write(addr, 0)
+        #no range is open to direct writes until a rendezvous receive or a window opens it
+        for i in range(DIRECT_GRANT_COUNT*DIRECT_GRANT_FIELDS):
+            self.cclo.write(DIRECT_GRANT_OFFSET + 4*i, 0)
         #NOTE: the buffer count HAS to be written last (offload checks for this) 
         self.cclo.write(self.rx_buffers_adr, nbufs)
 
@@ -504,6 +651,12 @@ class accl():
             rxsrc   = self.cclo.read(addr)
             addr   += 4
             seq     = self.cclo.read(addr)
+            addr   += 4
+            msglen  = self.cclo.read(addr)
+            addr   += 4
+            msgtype = self.cclo.read(addr)
+            #skip the rendezvous address
+            addr   += 8
             
             if rstatus == 0 :
                 status =  "NOT USED"
@@ -523,7 +676,7 @@ class accl():
             except Exception :
                 content= "xxread failedxx"
             buf_phys_addr = addrh*(2**32)+addrl
-            print(f"SPARE RX BUFFER{i}:\t ADDR: {hex(buf_phys_addr)} \t STATUS: {status} \t OCCUPANCY: {rxlen}/{maxsize} \t  MPI TAG:{hex(rxtag)} \t SEQ: {seq} \t SRC:{rxsrc} \t DATA: {content}")
+            print(f"SPARE RX BUFFER{i}:\t ADDR: {hex(buf_phys_addr)} \t STATUS: {status} \t OCCUPANCY: {rxlen}/{maxsize} \t MSG: {msglen} \t TYPE: {msgtype} \t  MPI TAG:{hex(rxtag)} \t SEQ: {seq} \t SRC:{rxsrc} \t DATA: {content}")
 
     def prepare_call(self, addr_0, addr_1, addr_2, compress_dtype=None):
         # no addresses, this is a config call
@@ -607,7 +760,8 @@ class accl():
     def self_check_return_value(call):
         def wrapper(self, *args, **kwargs):
             handle = call(self, *args, **kwargs)
-            if self.check_return_value_flag and handle is None: # if handle is none it means that the execution was synchronous
+            # synchronous calls return nothing, or the status of the message they received or probed
+            if self.check_return_value_flag and (handle is None or isinstance(handle, ACCLMessage)):
                 self.check_return_value(call.__name__)
             else: #not possible to check return code if invoked async
                 pass
@@ -646,7 +800,14 @@ class accl():
     
     @self_check_return_value
     def open_con(self, comm_id=0):
+        # opens sessions to all other ranks, failed connections are retried by the CCLO
         self.call_sync(scenario=CCLOp.config, comm=self.communicators[comm_id]["addr"], function=CCLOCfgFunc.open_con)
+
+    def get_connection_state(self, comm_id=0):
+        # session of each rank of the communicator, None for the local rank and where no connection is open
+        addr = self.communicators[comm_id]["addr"]
+        sessions = [self.cclo.read(addr + 4*(2 + 6*i + 4)) for i in range(len(self.communicators[comm_id]["ranks"]))]
+        return [None if s == SESSION_INVALID else s for s in sessions]
     
     @self_check_return_value
     def use_udp(self, comm_id=0):
@@ -666,6 +827,33 @@ class accl():
         self.call_sync(scenario=CCLOp.config, function=CCLOCfgFunc.set_max_segment_size, count=value)   
         self.segment_size = value
 
+    @self_check_return_value
+    def set_rendezvous_threshold(self, value=0xFFFF_FFFF):
+        # uncompressed memory-to-memory send/recv above value bytes use the rendezvous protocol on TCP,
+        # writing the payload directly into the receive buffer instead of going through the RX buffers;
+        # must be set identically on all ranks, the default disables rendezvous
+        self.call_sync(scenario=CCLOp.config, function=CCLOCfgFunc.set_rndzv_threshold, count=value)
+
+    @self_check_return_value
+    def set_pipeline_threshold(self, value=0):
+        # uncompressed allreduces above value bytes, spanning at least two blocks of one segment per rank,
+        # overlap the reduce-scatter of a block with the allgather of the previous one;
+        # must be set identically on all ranks, 0xFFFF_FFFF disables pipelining
+        self.call_sync(scenario=CCLOp.config, function=CCLOCfgFunc.set_pipeline_threshold, count=value)
+
+    @self_check_return_value
+    def set_sequencer(self, enable=True):
+        # ring allgather, reduce-scatter and non-pipelined allreduce are expanded into moves
+        # by the collective sequencer instead of the firmware; enabled by default
+        self.call_sync(scenario=CCLOp.config, function=CCLOCfgFunc.set_sequencer, count=int(enable))
+
+    @self_check_return_value
+    def set_multicast(self, enable=True):
+        # broadcast roots read each segment once and replay it to all ranks from the fan-out block
+        # in front of the packetizer; segments are capped at its buffer, so this must be set
+        # identically on all ranks; enabled by default
+        self.call_sync(scenario=CCLOp.config, function=CCLOCfgFunc.set_multicast, count=int(enable))
+
     @self_check_return_value
     def set_max_dma_in_flight(self, value=0):
      
@@ -681,9 +869,17 @@ class accl():
         else:
             addr = self.communicators[-1]["addr"]
         communicator = {"local_rank": local_rank, "addr": addr, "ranks": ranks}
+        addr = self.write_communicator(addr, ranks, local_rank)
+        self.communicators.append(communicator)
+        self.arithcfg_addr = addr + 4
+
+    def write_communicator(self, addr, ranks, local_rank, comm_id=0, ring_order=None):
+        # writes a communicator block into exchange memory at addr, returns the address of its last word
+        # the id goes in the upper half of the local rank word, it tells apart messages of communicators sharing sessions
+        # the block ends with the ring order of ring collectives, by default the rank order
         self.cclo.write(addr,len(ranks))
         addr += 4
-        self.cclo.write(addr,local_rank)
+        self.cclo.write(addr,(comm_id << 16) | local_rank)
         for i in range(len(ranks)):
             addr += 4
             #ip string to int conversion from here:
@@ -700,18 +896,30 @@ class accl():
             if "session_id" in ranks[i]:
                 sess_id = ranks[i]["session_id"]
             else:
-                sess_id = 0xFFFFFFFF
+                sess_id = SESSION_INVALID
             self.cclo.write(addr, sess_id)
             addr += 4
             self.cclo.write(addr, ranks[i]["max_segment_size"])
-        self.communicators.append(communicator)
-        self.arithcfg_addr = addr + 4
+        for r in (range(len(ranks)) if ring_order is None else ring_order):
+            addr += 4
+            self.cclo.write(addr, r)
+        return addr
+
+    def set_ring_order(self, comm_id, order):
+        # ring collectives on comm_id send to the rank after the local one in order and receive from the
+        # one before; must be called identically on all ranks of the communicator, between collectives
+        p = len(self.communicators[comm_id]["ranks"])
+        assert sorted(order) == list(range(p)), "Ring order must be a permutation of the ranks"
+        addr = self.communicators[comm_id]["addr"] + 4*(2 + 6*p)
+        for r in order:
+            self.cclo.write(addr, r)
+            addr += 4
         
     def dump_communicator(self):
         addr    = self.communicators_addr
         nr_ranks    = self.cclo.read(addr)
         addr +=4
-        local_rank  = self.cclo.read(addr)
+        local_rank  = self.cclo.read(addr) & 0xFFFF
         print(f"Communicator. local_rank: {local_rank} \t number of ranks: {nr_ranks}.")
         for i in range(nr_ranks):
             addr +=4
@@ -733,8 +941,24 @@ class accl():
             addr += 4
             max_seg_size = self.cclo.read(addr)
             print(f"> rank {i} (ip {ip_addr_rank}:{port} ; session {session} ; max segment size {max_seg_size}) : <- inbound_seq_number {inbound_seq_number}, -> outbound_seq_number {outbound_seq_number}")
+        print(f"Ring order: {[self.cclo.read(addr + 4*(i+1)) for i in range(nr_ranks)]}")
    
 
+    def write_vtable(self, comm_id, counts, displs=None):
+        # writes per-rank counts and displacements (in elements) for vector collectives
+        # into exchange memory; displacements default to the packed layout
+        p = len(self.communicators[comm_id]["ranks"])
+        assert len(counts) == p, "Vector collectives require one count per rank"
+        if displs is None:
+            displs = [sum(counts[:i]) for i in range(p)]
+        assert len(displs) == p, "Vector collectives require one displacement per rank"
+        assert self.vtable_addr + 8*p <= self.exchmem_top, "Vector collective table does not fit in exchange memory"
+        addr = self.vtable_addr
+        for val in list(counts) + list(displs):
+            self.cclo.write(addr, val)
+            addr += 4
+        return self.dummy_address(self.vtable_addr), displs
+
     @self_check_return_value
     def nop(self, run_async=False, waitfor=[]):
         #calls the accelerator with no work. Useful for measuring call latency
@@ -766,6 +990,252 @@ class accl():
         if not to_fpga:
             dstbuf.sync_from_device()
 
+    @self_check_return_value
+    def recv_up_to(self, comm_id, dstbuf, max_count=None, src=SRC_ANY, tag=TAG_ANY, to_fpga=False):
+        # receives the next message from src with a matching tag, of at most max_count elements
+        # (by default the size of dstbuf); returns the ACCLMessage actually received, with its
+        # byte count as reported by probe(). A longer message stays pending
+        if max_count is None:
+            max_count = dstbuf.size
+        self.call_sync(scenario=CCLOp.recv, count=max_count, comm=self.communicators[comm_id]["addr"], root_src_dst=src, function=CCLORecvFunc.up_to, tag=tag, addr_1=self.dummy_address(self.probe_addr), addr_2=dstbuf)
+        msg = ACCLMessage(self.cclo.read(self.probe_addr+4), self.cclo.read(self.probe_addr+8), self.cclo.read(self.probe_addr+12))
+        if msg.nbytes > max_count*dstbuf.dtype.itemsize:
+            raise Exception(f"CCLO @{hex(self.cclo.mmio.base_addr)}: during recv_up_to message of {msg.nbytes} bytes exceeds max_count {max_count}")
+        if not to_fpga:
+            dstbuf.sync_from_device()
+        return msg
+
+    @self_check_return_value
+    def probe(self, comm_id, src=SRC_ANY, tag=TAG_ANY, blocking=True):
+        # reports the next pending message from src with a matching tag without receiving it;
+        # only the oldest pending message of each source can match, since messages are received in order
+        # returns None if non-blocking and no message matched
+        func = CCLOProbeFunc.blocking if blocking else CCLOProbeFunc.nonblocking
+        self.call_sync(scenario=CCLOp.probe, comm=self.communicators[comm_id]["addr"], root_src_dst=src, function=func, tag=tag, addr_1=self.dummy_address(self.probe_addr))
+        if self.cclo.read(self.probe_addr) == 0:
+            return None
+        return ACCLMessage(self.cclo.read(self.probe_addr+4), self.cclo.read(self.probe_addr+8), self.cclo.read(self.probe_addr+12))
+
+    def iprobe(self, comm_id, src=SRC_ANY, tag=TAG_ANY):
+        return self.probe(comm_id, src, tag, blocking=False)
+
+    def exchange_words(self, comm_id, words):
+        # allgathers a list of 32-bit words from each rank of the communicator through the CCLO,
+        # returns the concatenation in rank order
+        n = len(words)
+        p = len(self.communicators[comm_id]["ranks"])
+        if not self.sim_mode:
+            sbuf = pynq.allocate((n,), dtype=np.int32, target=self.devicemem)
+            rbuf = pynq.allocate((n*p,), dtype=np.int32, target=self.devicemem)
+            sbuf[:] = np.array(words, dtype=np.uint32).view(np.int32)
+        else:
+            sbuf = SimBuffer(np.array(words, dtype=np.uint32).view(np.int32), self.cclo.socket)
+            rbuf = SimBuffer(np.zeros((n*p,), dtype=np.int32), self.cclo.socket)
+        self.allgather(comm_id, sbuf, rbuf, n)
+        ret = [int(x) for x in (rbuf.buf if self.sim_mode else rbuf).view(np.uint32)]
+        sbuf.freebuffer()
+        rbuf.freebuffer()
+        return ret
+
+    def split(self, comm_id, color, key=0):
+        # collectively creates communicators from the ranks of comm_id with the same color, ordered by key
+        # and then by rank in comm_id; ranks passing color None are not part of any. Ranks of the new
+        # communicator keep the sessions of comm_id, so no connections are opened
+        # returns the id of the new communicator or None
+        comm = self.communicators[comm_id]
+        p = len(comm["ranks"])
+        table = self.exchange_words(comm_id, [0xFFFF_FFFF if color is None else color, key, self.next_comm_id])
+        colors, keys, ids = table[0::3], table[1::3], table[2::3]
+        # the new id is one that no rank of comm_id has used, so it is unique among communicators sharing sessions
+        new_id = max(ids)
+        assert new_id < (1 << 16), "Communicator ids exhausted"
+        self.next_comm_id = new_id + 1
+        if color is None:
+            return None
+        members = sorted([r for r in range(p) if colors[r] == colors[comm["local_rank"]]], key=lambda r: (keys[r], r))
+        sessions = self.get_connection_state(comm_id)
+        ranks = []
+        for r in members:
+            rank = dict(comm["ranks"][r])
+            if sessions[r] is None:
+                rank.pop("session_id", None)
+            else:
+                rank["session_id"] = sessions[r]
+            ranks.append(rank)
+        addr = self.exchmem_top - 4*(2 + 7*len(ranks))
+        assert addr >= self.vtable_addr, "Communicator does not fit in exchange memory"
+        local_rank = members.index(comm["local_rank"])
+        self.write_communicator(addr, ranks, local_rank, new_id)
+        self.exchmem_top = addr
+        self.communicators.append({"local_rank": local_rank, "addr": addr, "ranks": ranks, "id": new_id})
+        return len(self.communicators) - 1
+
+    def dup(self, comm_id):
+        # same ranks in the same order, with a separate message space
+        return self.split(comm_id, 0, self.communicators[comm_id]["local_rank"])
+
+    def create(self, comm_id, group):
+        # collectively creates a communicator from the listed ranks of comm_id, in the given order;
+        # all ranks pass the same group, those not in it get None
+        local_rank = self.communicators[comm_id]["local_rank"]
+        if local_rank not in group:
+            return self.split(comm_id, None)
+        return self.split(comm_id, 0, group.index(local_rank))
+
+    def set_topology(self, comm_id, nodes):
+        # collectively describes which ranks of comm_id share a node (e.g. several CCLOs of one host),
+        # nodes[r] is any hashable node label of rank r; creates a communicator per node and one of
+        # the node leaders (the lowest rank of each node), used by the hierarchical collectives
+        comm = self.communicators[comm_id]
+        p = len(comm["ranks"])
+        assert len(nodes) == p, "Topology requires one node label per rank"
+        labels = list(dict.fromkeys(nodes))
+        node_of = [labels.index(n) for n in nodes]
+        leaders = [node_of.index(n) for n in range(len(labels))]
+        local_rank = comm["local_rank"]
+        node_comm = self.split(comm_id, node_of[local_rank], local_rank)
+        leader_comm = self.split(comm_id, 0 if local_rank in leaders else None, local_rank)
+        comm["topology"] = {"node_of": node_of, "leaders": leaders, "node_comm": node_comm, "leader_comm": leader_comm}
+
+    def hierarchical_allreduce(self, comm_id, sbuf, rbuf, count, func, from_fpga=False, to_fpga=False):
+        # reduce within each node to its leader, allreduce among leaders, then broadcast within nodes;
+        # only one rank per node sends across the network
+        topo = self.communicators[comm_id]["topology"]
+        node_comm, leader_comm = topo["node_comm"], topo["leader_comm"]
+        if not from_fpga:
+            sbuf[0:count].sync_to_device()
+        if len(self.communicators[node_comm]["ranks"]) > 1:
+            self.reduce(node_comm, sbuf, rbuf, count, 0, func, from_fpga=True, to_fpga=True)
+        else:
+            self.copy(sbuf, rbuf, count, from_fpga=True, to_fpga=True)
+        if leader_comm is not None and len(self.communicators[leader_comm]["ranks"]) > 1:
+            # the ring allreduce reads every source chunk before writing it, so it can run in place
+            self.allreduce(leader_comm, rbuf, rbuf, count, func, from_fpga=True, to_fpga=True)
+        if len(self.communicators[node_comm]["ranks"]) > 1:
+            self.bcast(node_comm, rbuf, count, 0, from_fpga=True, to_fpga=True)
+        if not to_fpga:
+            rbuf[0:count].sync_from_device()
+
+    def hierarchical_bcast(self, comm_id, buf, count, root, from_fpga=False, to_fpga=False):
+        # the root hands the data to its node leader, which broadcasts among leaders, then within nodes
+        comm = self.communicators[comm_id]
+        topo = comm["topology"]
+        node_comm, leader_comm = topo["node_comm"], topo["leader_comm"]
+        local_rank = comm["local_rank"]
+        root_node = topo["node_of"][root]
+        root_leader = topo["leaders"][root_node]
+        if not from_fpga and local_rank == root:
+            buf[0:count].sync_to_device()
+        if root != root_leader:
+            if local_rank == root:
+                self.send(node_comm, buf, count, 0, from_fpga=True)
+            elif local_rank == root_leader:
+                self.recv(node_comm, buf, count, topo["node_of"][:root].count(root_node), to_fpga=True)
+        if leader_comm is not None and len(self.communicators[leader_comm]["ranks"]) > 1:
+            self.bcast(leader_comm, buf, count, root_node, from_fpga=True, to_fpga=True)
+        if len(self.communicators[node_comm]["ranks"]) > 1:
+            self.bcast(node_comm, buf, count, 0, from_fpga=True, to_fpga=True)
+        if not to_fpga and local_rank != root:
+            buf[0:count].sync_from_device()
+
+    def hierarchical_allgather(self, comm_id, sbuf, rbuf, count, from_fpga=False, to_fpga=False):
+        # gather within each node to its leader, allgather node blocks among leaders, then broadcast
+        # within nodes; node blocks must be contiguous in rbuf, otherwise this falls back to allgather
+        comm = self.communicators[comm_id]
+        topo = comm["topology"]
+        node_of = topo["node_of"]
+        p = len(comm["ranks"])
+        if any(node_of[r] > node_of[r+1] for r in range(p-1)):
+            return self.allgather(comm_id, sbuf, rbuf, count, from_fpga=from_fpga, to_fpga=to_fpga)
+        node_comm, leader_comm = topo["node_comm"], topo["leader_comm"]
+        first = topo["leaders"][node_of[comm["local_rank"]]]
+        if not from_fpga:
+            sbuf[0:count].sync_to_device()
+        if len(self.communicators[node_comm]["ranks"]) > 1:
+            self.gather(node_comm, sbuf, rbuf[first*count:], count, 0, from_fpga=True, to_fpga=True)
+        else:
+            self.copy(sbuf, rbuf[first*count:], count, from_fpga=True, to_fpga=True)
+        if leader_comm is not None and len(self.communicators[leader_comm]["ranks"]) > 1:
+            counts = [count*node_of.count(n) for n in range(len(topo["leaders"]))]
+            displs = [count*l for l in topo["leaders"]]
+            local_node = node_of[comm["local_rank"]]
+            self.allgatherv(leader_comm, rbuf[displs[local_node]:], rbuf, counts, displs, from_fpga=True, to_fpga=True)
+        if len(self.communicators[node_comm]["ranks"]) > 1:
+            self.bcast(node_comm, rbuf, count*p, 0, from_fpga=True, to_fpga=True)
+        if not to_fpga:
+            rbuf[0:count*p].sync_from_device()
+
+    def create_window(self, comm_id, buf, key):
+        # collectively registers buf as a window for one-sided access by the ranks of comm_id;
+        # all ranks exchange base address, size and their handle of the window (the offset of
+        # its descriptor in exchange memory), puts and gets address it by key and element displacement
+        assert key not in self.windows, "Window key already in use"
+        assert self.next_grant < DIRECT_GRANT_COUNT, "Too many windows open to direct writes"
+        comm = self.communicators[comm_id]
+        p = len(comm["ranks"])
+        addr = self.exchmem_top - 4*(3 + 4*p)
+        assert addr >= self.vtable_addr, "Window descriptor does not fit in exchange memory"
+        table = self.exchange_words(comm_id, [buf.physical_address & 0xffffffff, (buf.physical_address>>32) & 0xffffffff, buf.size*buf.dtype.itemsize, addr])
+        words = [key, self.arith_config[(buf.dtype.name, buf.dtype.name)].addr, comm["addr"]] + table
+        for i, val in enumerate(words):
+            self.cclo.write(addr + 4*i, val)
+        self.exchmem_top = addr
+        #open the local window to puts from the other ranks
+        grant = DIRECT_GRANT_OFFSET + 4*DIRECT_GRANT_FIELDS*self.next_grant
+        self.cclo.write(grant, buf.physical_address & 0xffffffff)
+        self.cclo.write(grant + 4, (buf.physical_address>>32) & 0xffffffff)
+        self.cclo.write(grant + 8, buf.size*buf.dtype.itemsize)
+        self.cclo.write(grant + 12, addr)
+        self.next_grant += 1
+        self.windows[key] = {"addr": addr, "comm_id": comm_id, "buf": buf}
+        return key
+
+    @self_check_return_value
+    def put(self, key, srcbuf, count, dst, displ=0, from_fpga=False, run_async=False, waitfor=[]):
+        # writes count elements of srcbuf into the window of rank dst, at displ elements from its base;
+        # completes locally, the data is visible at the target after a flush
+        win = self.windows[key]
+        if not from_fpga:
+            srcbuf[0:count].sync_to_device()
+        handle = self.call_async(scenario=CCLOp.put, count=count, comm=self.communicators[win["comm_id"]]["addr"], root_src_dst=dst, addr_0=srcbuf, addr_1=self.dummy_address(win["addr"]), addr_2=self.dummy_address(displ*win["buf"].dtype.itemsize), waitfor=waitfor)
+        if run_async:
+            return handle
+        else:
+            handle.wait()
+
+    @self_check_return_value
+    def get(self, key, dstbuf, count, src, displ=0, to_fpga=False, run_async=False, waitfor=[]):
+        # reads count elements from the window of rank src, at displ elements from its base, into dstbuf;
+        # the target serves the request without a matching call
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        win = self.windows[key]
+        handle = self.call_async(scenario=CCLOp.get, count=count, comm=self.communicators[win["comm_id"]]["addr"], root_src_dst=src, addr_0=self.dummy_address(displ*win["buf"].dtype.itemsize), addr_1=self.dummy_address(win["addr"]), addr_2=dstbuf, waitfor=waitfor)
+        if run_async:
+            return handle
+        else:
+            handle.wait()
+        if not to_fpga:
+            dstbuf[0:count].sync_from_device()
+
+    @self_check_return_value
+    def flush(self, key, dst=SRC_ANY, run_async=False, waitfor=[]):
+        # completes all puts issued to the window of rank dst; with the default SRC_ANY
+        # this is a fence over all ranks of the window
+        win = self.windows[key]
+        handle = self.call_async(scenario=CCLOp.flush, comm=self.communicators[win["comm_id"]]["addr"], root_src_dst=dst, addr_1=self.dummy_address(win["addr"]), waitfor=waitfor)
+        if run_async:
+            return handle
+        else:
+            handle.wait()
+
+    # matched receive of a probed message: it stays the next message from its source
+    # until received, so receiving from that source with its tag and size gets exactly this message
+    def mrecv(self, comm_id, dstbuf, msg, to_fpga=False, run_async=False, waitfor=[]):
+        assert msg.nbytes % dstbuf.dtype.itemsize == 0, "Message size is not a multiple of the buffer element size"
+        assert msg.nbytes // dstbuf.dtype.itemsize <= dstbuf.size, "Buffer too small for message"
+        return self.recv(comm_id, dstbuf, msg.nbytes // dstbuf.dtype.itemsize, msg.src, tag=msg.tag, to_fpga=to_fpga, run_async=run_async, waitfor=waitfor)
+
     @self_check_return_value
     def copy(self, srcbuf, dstbuf, count, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
         if not to_fpga and run_async:
@@ -942,7 +1412,10 @@ class accl():
             rbuf[0:count].sync_from_device()
  
     @self_check_return_value
-    def allreduce(self, comm_id, sbuf, rbuf, count, func, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+    def allreduce(self, comm_id, sbuf, rbuf, count, func, from_fpga=False, to_fpga=False, compress_dtype=None, dual_ring=False, run_async=False, waitfor=[]):
+        # dual_ring reduces the two halves of the buffer around the ring in opposite directions,
+        # using both directions of each link; it falls back to a single ring for two ranks,
+        # fewer than two elements per rank, or compressed buffers
         if not to_fpga and run_async:
             warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
         if count == 0:
@@ -951,7 +1424,8 @@ class accl():
         if not from_fpga:
             sbuf[0:count].sync_to_device()
 
-        prevcall = [self.call_async(scenario=CCLOp.allreduce, count=count, comm=self.communicators[comm_id]["addr"], function=func, addr_0=sbuf, addr_2=rbuf, waitfor=waitfor)]
+        scenario = CCLOp.allreduce_dual_ring if dual_ring else CCLOp.allreduce
+        prevcall = [self.call_async(scenario=scenario, count=count, comm=self.communicators[comm_id]["addr"], function=func, compress_dtype=compress_dtype, addr_0=sbuf, addr_2=rbuf, waitfor=waitfor)]
 
         if run_async:
             return prevcall[0]
@@ -983,3 +1457,121 @@ class accl():
         prevcall[0].wait()
         if not to_fpga:
             rbuf[0:count].sync_from_device()
+
+    # vector collectives take per-rank counts and displacements (in elements), as MPI *v variants;
+    # the table is written into exchange memory before each call, so async vector calls must not overlap
+    @self_check_return_value
+    def scatterv(self, comm_id, sbuf, rbuf, counts, root, displs=None, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        comm        = self.communicators[comm_id]
+        local_rank  = comm["local_rank"]
+        vtable, displs = self.write_vtable(comm_id, counts, displs)
+
+        if not from_fpga and local_rank == root:
+            sbuf[:max(d+c for d, c in zip(displs, counts))].sync_to_device()
+
+        prevcall = [self.call_async(scenario=CCLOp.scatterv, count=counts[local_rank], comm=comm["addr"], root_src_dst=root, addr_0=sbuf, addr_1=vtable, addr_2=rbuf, waitfor=waitfor)]
+
+        if run_async:
+            return prevcall[0]
+
+        prevcall[0].wait()
+        if not to_fpga and counts[local_rank] > 0:
+            rbuf[0:counts[local_rank]].sync_from_device()
+
+    @self_check_return_value
+    def gatherv(self, comm_id, sbuf, rbuf, counts, root, displs=None, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        comm        = self.communicators[comm_id]
+        local_rank  = comm["local_rank"]
+        p           = len(comm["ranks"])
+
+        if not self.ignore_safety_checks and sum((c + self.segment_size-1)//self.segment_size for c in counts) > len(self.rx_buffer_spares):
+            warnings.warn("gatherv can't be executed safely with this number of spare buffers")
+            return
+
+        vtable, displs = self.write_vtable(comm_id, counts, displs)
+
+        if not from_fpga and counts[local_rank] > 0:
+            sbuf[0:counts[local_rank]].sync_to_device()
+
+        prevcall = [self.call_async(scenario=CCLOp.gatherv, count=counts[local_rank], comm=comm["addr"], root_src_dst=root, addr_0=sbuf, addr_1=vtable, addr_2=rbuf, waitfor=waitfor)]
+
+        if run_async:
+            return prevcall[0]
+
+        prevcall[0].wait()
+        if not to_fpga and local_rank == root:
+            rbuf[:max(d+c for d, c in zip(displs, counts))].sync_from_device()
+
+    @self_check_return_value
+    def allgatherv(self, comm_id, sbuf, rbuf, counts, displs=None, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        comm        = self.communicators[comm_id]
+        local_rank  = comm["local_rank"]
+
+        if not self.ignore_safety_checks and sum((c + self.segment_size-1)//self.segment_size for c in counts) > len(self.rx_buffer_spares):
+            warnings.warn("allgatherv can't be executed safely with this number of spare buffers")
+            return
+
+        vtable, displs = self.write_vtable(comm_id, counts, displs)
+
+        if not from_fpga and counts[local_rank] > 0:
+            sbuf[0:counts[local_rank]].sync_to_device()
+
+        prevcall = [self.call_async(scenario=CCLOp.allgatherv, count=counts[local_rank], comm=comm["addr"], addr_0=sbuf, addr_1=vtable, addr_2=rbuf, waitfor=waitfor)]
+
+        if run_async:
+            return prevcall[0]
+
+        prevcall[0].wait()
+        if not to_fpga:
+            rbuf[:max(d+c for d, c in zip(displs, counts))].sync_from_device()
+
+    # count is the pair capacity of sbuf and rbuf, which must hold the union of all contributions;
+    # the result is left in sparse form in rbuf on all ranks, see sparse_densify
+    @self_check_return_value
+    def sparse_allreduce(self, comm_id, sbuf, rbuf, count, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        if count == 0:
+            return
+        assert sbuf.dtype == ACCL_SPARSE_PAIR_DTYPE and rbuf.dtype == ACCL_SPARSE_PAIR_DTYPE, "Sparse buffers must hold ACCL_SPARSE_PAIR_DTYPE"
+        assert count <= min(sbuf.size, rbuf.size, ACCL_SPARSE_MAX_PAIRS), "Sparse capacity exceeds buffers or plugin"
+
+        if not from_fpga:
+            sbuf[0:count].sync_to_device()
+
+        prevcall = [self.call_async(scenario=CCLOp.sparse_allreduce, count=count, comm=self.communicators[comm_id]["addr"], function=ACCLReduceFunctions.SUM, addr_0=sbuf, addr_2=rbuf, waitfor=waitfor)]
+
+        if run_async:
+            return prevcall[0]
+
+        prevcall[0].wait()
+        if not to_fpga:
+            rbuf[0:count].sync_from_device()
+            if rbuf['index'][count-1] == ACCL_SPARSE_OVERFLOW_INDEX:
+                raise Exception(f"CCLO @{hex(self.cclo.mmio.base_addr)}: during sparse_allreduce SPARSE_OVERFLOW_ERROR ({SPARSE_OVERFLOW_ERROR}), union of contributions exceeds capacity of {count} pairs")
+
+    @self_check_return_value
+    def reduce_scatterv(self, comm_id, sbuf, rbuf, counts, func, displs=None, from_fpga=False, to_fpga=False, run_async=False, waitfor=[]):
+        if not to_fpga and run_async:
+            warnings.warn("ACCL: async run returns data on FPGA, user must sync_from_device() after waiting")
+        comm        = self.communicators[comm_id]
+        local_rank  = comm["local_rank"]
+        vtable, displs = self.write_vtable(comm_id, counts, displs)
+
+        if not from_fpga:
+            sbuf[:max(d+c for d, c in zip(displs, counts))].sync_to_device()
+
+        prevcall = [self.call_async(scenario=CCLOp.reduce_scatterv, count=counts[local_rank], comm=comm["addr"], function=func, addr_0=sbuf, addr_1=vtable, addr_2=rbuf, waitfor=waitfor)]
+
+        if run_async:
+            return prevcall[0]
+
+        prevcall[0].wait()
+        if not to_fpga and counts[local_rank] > 0:
+            rbuf[0:counts[local_rank]].sync_from_device()
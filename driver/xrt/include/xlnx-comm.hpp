@@ -18,65 +18,264 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <stdexcept>
+#include <vector>
 
 #include "experimental/xrt_aie.h"
 #include "experimental/xrt_device.h"
 #include "experimental/xrt_kernel.h"
+#include "xlnx-consts.hpp"
 #include <arpa/inet.h>
 #include <mpi.h>
 
 using namespace std;
 
+struct rank_t {
+  string ip;
+  int port;
+  uint32_t session_id;
+  uint32_t max_segment_size;
+};
+
 class communicator {
 private:
   string base_ipaddr = "197.11.27.";
   int start_ip = 1;
-  int _world_size;
+  int start_port = 5001;
+  int _world_size = 0;
   int _local_rank;
   int _rank;
   bool _vnx;
   map<int, string> rank_to_ip;
   uint64_t _comm_addr;
+  // id in the upper half of the local rank word, it tells apart messages of
+  // communicators sharing sessions
+  uint32_t _id = 0;
+  vector<rank_t> _ranks;
+  // MPI counterpart holding the same ranks in the same order, used to agree
+  // on sub-communicators
+  MPI_Comm _mpi_comm = MPI_COMM_WORLD;
+
+  // next communicator id not used by this process
+  static uint32_t &next_id() {
+    static uint32_t id = 1;
+    return id;
+  }
+
+  communicator(const vector<rank_t> &ranks, int local_rank, uint32_t id,
+               uint64_t comm_addr, MPI_Comm mpi_comm, xrt::kernel krnl,
+               bool vnx)
+      : _world_size(ranks.size()), _local_rank(local_rank),
+        _vnx(vnx), _comm_addr(comm_addr), _id(id), _ranks(ranks),
+        _mpi_comm(mpi_comm) {
+    MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    for (int i = 0; i < _world_size; i++) {
+      rank_to_ip[i] = _ranks[i].ip;
+    }
+    write(krnl);
+  }
+
+  void write(xrt::kernel krnl) {
+    uint64_t addr = _comm_addr;
+
+    krnl.write_register(addr, _world_size);
+    addr += 4;
+    krnl.write_register(addr, (_id << 16) | _local_rank);
+    for (int i = 0; i < _world_size; i++) {
+      addr += 4;
+      krnl.write_register(addr, ip_encode(_ranks[i].ip));
+      addr += 4;
+      krnl.write_register(addr, _ranks[i].port);
+      // inbound and outbound sequence numbers
+      addr += 4;
+      krnl.write_register(addr, 0);
+      addr += 4;
+      krnl.write_register(addr, 0);
+      addr += 4;
+      krnl.write_register(addr, _ranks[i].session_id);
+      addr += 4;
+      krnl.write_register(addr, _ranks[i].max_segment_size);
+    }
+    // ring order of ring collectives, the rank order by default
+    for (int i = 0; i < _world_size; i++) {
+      addr += 4;
+      krnl.write_register(addr, i);
+    }
+  }
 
 public:
   communicator() {}
 
+  // rank i of the world communicator is at ipaddr + (start + i), port
+  // start_port + i
   communicator(int world_size, uint64_t comm_addr, xrt::kernel krnl,
-               bool vnx = false)
-      : _world_size(world_size), _comm_addr(comm_addr), _vnx(vnx) {
+               bool vnx = false, int max_segment_size = 1024,
+               string ipaddr = "197.11.27.", int start = 1,
+               int port = 5001)
+      : base_ipaddr(ipaddr), start_ip(start), start_port(port),
+        _world_size(world_size), _vnx(vnx), _comm_addr(comm_addr) {
 
     MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
-    char *local_rank_string = getenv("OMPI_COMM_WORLD_LOCAL_RANK");
-    _local_rank = atoi(local_rank_string);
+    // the rank table lists all processes in MPI_COMM_WORLD order, so this
+    // process is at its world rank; OMPI_COMM_WORLD_LOCAL_RANK is the rank
+    // within the node, which only matches on a single node
+    _local_rank = _rank;
 
-    uint64_t addr = _comm_addr;
-
-    krnl.write_register(addr, world_size);
-    addr += 4;
-    krnl.write_register(addr, _local_rank);
     for (int i = 0; i < _world_size; i++) {
       string ip = base_ipaddr + to_string(i + start_ip);
-      rank_to_ip.insert(pair<int, string>(_rank, ip));
-      addr += 4;
-      krnl.write_register(addr, ip_encode(ip_from_rank(i)));
+      rank_to_ip.insert(pair<int, string>(i, ip));
+      // with the VNx UDP stack the port register holds the rank, the actual
+      // port is programmed into the stack itself
+      _ranks.push_back({ip, _vnx ? i : port_from_rank(i), SESSION_INVALID,
+                        (uint32_t)max_segment_size});
+    }
+    write(krnl);
+  }
+
+  // size in bytes of the communicator block in exchange memory
+  static uint64_t block_size(int nranks) { return 4 * (2 + 7 * nranks); }
+
+  uint64_t addr() const { return _comm_addr; }
+
+  uint64_t size_bytes() const { return block_size(_world_size); }
+
+  int size() const { return _world_size; }
+
+  int local_rank() const { return _local_rank; }
+
+  uint32_t id() const { return _id; }
+
+  // session of each rank as currently set by the CCLO, SESSION_INVALID for the
+  // local rank and where no connection is open
+  vector<uint32_t> get_connection_state(xrt::kernel krnl) {
+    vector<uint32_t> sessions;
+    for (int i = 0; i < _world_size; i++) {
+      sessions.push_back(krnl.read_register(_comm_addr + 4 * (2 + 6 * i + 4)));
+    }
+    return sessions;
+  }
+
+  // ring collectives send to the rank after the local one in order and
+  // receive from the one before; must be set identically on all ranks
+  void set_ring_order(const vector<int> &order, xrt::kernel krnl) {
+    vector<int> sorted_order(order);
+    sort(sorted_order.begin(), sorted_order.end());
+    for (int i = 0; i < _world_size; i++) {
+      if ((int)sorted_order.size() != _world_size || sorted_order[i] != i) {
+        throw std::invalid_argument("Ring order must be a permutation of the ranks");
+      }
+    }
+    uint64_t addr = _comm_addr + 4 * (2 + 6 * _world_size);
+    for (int r : order) {
+      krnl.write_register(addr, r);
       addr += 4;
-      if (_vnx) {
-        krnl.write_register(addr, i);
-      } else {
-        krnl.write_register(addr, port_from_rank(i));
+    }
+  }
+
+  // collectively creates communicators from the ranks of this one with the
+  // same color, ordered by key and then by rank. The new block is allocated
+  // downward from exchmem_top, which is updated, and may not go below
+  // exchmem_bottom. Ranks keep the sessions of this communicator, so no
+  // connections are opened. Ranks passing a negative color are not part of
+  // any, and get an empty communicator back
+  communicator split(int color, int key, uint64_t &exchmem_top,
+                     uint64_t exchmem_bottom, xrt::kernel krnl) {
+    uint32_t mine[3] = {(uint32_t)color, (uint32_t)key, next_id()};
+    vector<uint32_t> table(3 * _world_size);
+    MPI_Allgather(mine, 3, MPI_UINT32_T, table.data(), 3, MPI_UINT32_T,
+                  _mpi_comm);
+    // the new id is one that no rank has used, so it is unique among
+    // communicators sharing sessions
+    uint32_t new_id = 0;
+    for (int i = 0; i < _world_size; i++) {
+      new_id = max(new_id, table[3 * i + 2]);
+    }
+    if (new_id >= (1 << 16)) {
+      throw std::runtime_error("Communicator ids exhausted");
+    }
+    next_id() = new_id + 1;
+
+    MPI_Comm mpi_comm;
+    MPI_Comm_split(_mpi_comm, color < 0 ? MPI_UNDEFINED : color, key,
+                   &mpi_comm);
+    if (color < 0) {
+      return communicator();
+    }
+    vector<int> members;
+    for (int i = 0; i < _world_size; i++) {
+      if (table[3 * i] == (uint32_t)color) {
+        members.push_back(i);
       }
     }
-    //  self.communicators.append(communicator)
+    // same order as MPI_Comm_split, so both agree on sub-ranks
+    stable_sort(members.begin(), members.end(), [&](int a, int b) {
+      return (int)table[3 * a + 1] < (int)table[3 * b + 1];
+    });
+    return subset(members, new_id, exchmem_top, exchmem_bottom, mpi_comm,
+                  krnl);
+  }
+
+  // same ranks in the same order, with a separate message space
+  communicator dup(uint64_t &exchmem_top, uint64_t exchmem_bottom,
+                   xrt::kernel krnl) {
+    return split(0, _local_rank, exchmem_top, exchmem_bottom, krnl);
   }
 
-  int port_from_rank(int rank) {
-    throw std::logic_error("Function not yet implemented");
-    return 0;
+  // collectively creates a communicator from the listed ranks of this one, in
+  // the given order; all ranks must call it with the same group, ranks not in
+  // the group get an empty communicator back
+  communicator create(const vector<int> &group, uint64_t &exchmem_top,
+                      uint64_t exchmem_bottom, xrt::kernel krnl) {
+    uint32_t new_id = next_id();
+    MPI_Allreduce(MPI_IN_PLACE, &new_id, 1, MPI_UINT32_T, MPI_MAX, _mpi_comm);
+    if (new_id >= (1 << 16)) {
+      throw std::runtime_error("Communicator ids exhausted");
+    }
+    next_id() = new_id + 1;
+
+    auto pos = find(group.begin(), group.end(), _local_rank);
+    bool member = pos != group.end();
+    MPI_Comm mpi_comm;
+    MPI_Comm_split(_mpi_comm, member ? 0 : MPI_UNDEFINED,
+                   member ? pos - group.begin() : 0, &mpi_comm);
+    if (!member) {
+      return communicator();
+    }
+    return subset(group, new_id, exchmem_top, exchmem_bottom, mpi_comm, krnl);
   }
 
+  int port_from_rank(int rank) { return start_port + rank; }
+
   uint32_t ip_encode(string ip) { return inet_addr(ip.c_str()); }
 
   string ip_from_rank(int rank) { return rank_to_ip[rank]; }
+
+private:
+  communicator subset(const vector<int> &members, uint32_t id,
+                      uint64_t &exchmem_top, uint64_t exchmem_bottom,
+                      MPI_Comm mpi_comm, xrt::kernel krnl) {
+    if (exchmem_top < exchmem_bottom + block_size(members.size())) {
+      throw std::runtime_error("Communicator does not fit in exchange memory");
+    }
+    vector<uint32_t> sessions = get_connection_state(krnl);
+    vector<rank_t> ranks;
+    int local_rank = 0;
+    for (size_t i = 0; i < members.size(); i++) {
+      if (members[i] < 0 || members[i] >= _world_size) {
+        throw std::out_of_range("Rank not in communicator");
+      }
+      rank_t r = _ranks[members[i]];
+      r.session_id = sessions[members[i]];
+      ranks.push_back(r);
+      if (members[i] == _local_rank) {
+        local_rank = i;
+      }
+    }
+    exchmem_top -= block_size(ranks.size());
+    return communicator(ranks, local_rank, id, exchmem_top, mpi_comm, krnl,
+                        _vnx);
+  }
 };
@@ -22,6 +22,18 @@ const auto TAG_ANY = 0xFFFFFFFF;
 const auto EXCHANGE_MEM_OFFSET_ADDRESS = 0x1000;
 const auto EXCHANGE_MEM_ADDRESS_RANGE = 0x1000;
 const auto HOST_CTRL_ADDRESS_RANGE = 0x800;
+// last words of exchange memory
+const auto CFGRDY_OFFSET = EXCHANGE_MEM_OFFSET_ADDRESS + EXCHANGE_MEM_ADDRESS_RANGE - 0xC;
+// ranges open to direct writes by peers (base low, base high, size, window handle each),
+// communicators are allocated below
+const auto DIRECT_GRANT_OFFSET = EXCHANGE_MEM_OFFSET_ADDRESS + EXCHANGE_MEM_ADDRESS_RANGE - 0x90;
+const auto DIRECT_GRANT_COUNT = 8;
+const auto DIRECT_GRANT_FIELDS = 4;
+// RX buffer table: the buffer count, then per buffer the status, address low,
+// address high and maximum length, followed by fields the firmware fills in
+const auto RX_BUFFER_COUNT_OFFSET = 0x800;
+const auto SPARE_BUFFER_FIELDS = 12;
+const auto SESSION_INVALID = 0xFFFFFFFF;
 
 enum accl_fgFunc {
   enable_irq = 0,
@@ -56,10 +56,15 @@ private:
   xrt::bo _utility_spare; 
   xrt::device _device;
   xrt::kernel _krnl;
- // std::vector<communicator> _comm;
-  const uint64_t _base_addr = 0x800;
+  std::vector<communicator> _comm;
+  const uint64_t _base_addr = RX_BUFFER_COUNT_OFFSET;
   uint64_t _exchange_mem = _base_addr;
   uint64_t _comm_addr = 0;
+  // end of the static allocations (RX buffer table, world communicator),
+  // which grow upward from _base_addr
+  uint64_t _exchmem_floor = _base_addr;
+  // communicators created at runtime are allocated downward from here
+  uint64_t _exchmem_top = DIRECT_GRANT_OFFSET;
   enum mode _mode;
   int _rank;
 
@@ -97,7 +102,41 @@ public:
     return 0; // XXX Implement this
   }
 
-  //void config_comm(int ranks) { _comm = {ranks, _comm_addr, _krnl}; }
+  // the world communicator follows the RX buffer table, call after
+  // prep_rx_buffers
+  void config_comm(int ranks, bool vnx = false) {
+    if (_comm_addr + communicator::block_size(ranks) > _exchmem_top) {
+      throw std::runtime_error("Communicator does not fit in exchange memory");
+    }
+    _comm = {communicator(ranks, _comm_addr, _krnl, vnx)};
+    _exchmem_floor = _comm_addr + _comm[0].size_bytes();
+  }
+
+  uint64_t comm_floor() { return _exchmem_floor; }
+
+  // collectively creates communicators from the ranks of comm_id with the same
+  // color, ordered by key; sub-ranks reuse the open sessions of comm_id.
+  // Returns the id of the new communicator, -1 for ranks with negative color
+  int split_comm(int comm_id, int color, int key = 0) {
+    communicator c = _comm.at(comm_id).split(color, key, _exchmem_top, comm_floor(), _krnl);
+    if (color < 0) {
+      return -1;
+    }
+    _comm.push_back(c);
+    return _comm.size() - 1;
+  }
+
+  // collectively creates a communicator from the listed ranks of comm_id
+  int create_comm(int comm_id, const std::vector<int> &group) {
+    communicator c = _comm.at(comm_id).create(group, _exchmem_top, comm_floor(), _krnl);
+    if (c.size() == 0) {
+      return -1;
+    }
+    _comm.push_back(c);
+    return _comm.size() - 1;
+  }
+
+  communicator &get_comm(int comm_id) { return _comm.at(comm_id); }
 
   void load_bitstream(const std::string xclbin) {
     char *local_rank_string = getenv("OMPI_COMM_WORLD_LOCAL_RANK");
@@ -141,55 +180,29 @@ public:
 
 
   void dump_rx_buffers() {
+    const char *fields[SPARE_BUFFER_FIELDS] = {
+        "STATUS", "ADDRL",     "ADDRH",       "MAXSIZE",
+        "RX_TAG", "RX_LEN",    "RX_SRC",      "SEQUENCE_NUMBER",
+        "MSG_COUNT", "MSG_TYPE", "RNDZV_ADDRL", "RNDZV_ADDRH"};
     int64_t addr = _base_addr;
     for (int i = 0; i < _nbufs; i++) {
       std::cout << "===========================" << std::endl;
       std::cout << "Dumping spare RX buffer: " << i << std::endl;
       std::cout << "===========================" << std::endl;
-      int8_t res;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "ADDRL: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "ADDRH: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "MAXSIZE: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "DMA TAG: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "ENQUEUED: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "RX_TAG: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "RESERVED: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "RX_LEN: " << static_cast<int32_t>(res) << std::endl;
-
-      addr += 4;
-      res = read_reg(addr);
-      std::cout << "RX_SRC: " << static_cast<int32_t>(res) << std::endl;
+      for (int j = 0; j < SPARE_BUFFER_FIELDS; j++) {
+        addr += 4;
+        std::cout << fields[j] << ": " << read_reg(addr) << std::endl;
+      }
     }
   }
 
   void prep_rx_buffers(int bank_id = 1) {
     const auto SIZE = _rx_buffer_size / sizeof(int8_t);
     int64_t addr = _base_addr;
-    write_reg(addr, _nbufs);
+    // no range is open to direct writes until a rendezvous receive opens it
+    for (int i = 0; i < DIRECT_GRANT_COUNT * DIRECT_GRANT_FIELDS; i++) {
+      write_reg(DIRECT_GRANT_OFFSET + 4 * i, 0);
+    }
     for (int i = 0; i < _nbufs; i++) {
       // Alloc and fill buffer
       const xrtMemoryGroup bank_grp_idx = bank_id;
@@ -199,7 +212,10 @@ public:
       bo.sync(XCL_BO_SYNC_BO_TO_DEVICE, SIZE, 0);
       _rx_buffer_spares.insert(_rx_buffer_spares.cbegin() + i, bo);
 
-      // Write meta data
+      // Write meta data, in the layout of the firmware
+      addr += 4;
+      write_reg(addr, 0);
+
       addr += 4;
       write_reg(addr, bo.address() & 0xffffffff);
 
@@ -209,17 +225,21 @@ public:
       addr += 4;
       write_reg(addr, _rx_buffer_size);
 
-      for (int i = 3; i < 9; i++) {
+      for (int j = 4; j < SPARE_BUFFER_FIELDS; j++) {
         addr += 4;
         write_reg(addr, 0);
       }
-      _comm_addr = addr + 4;
-      // Start irq-driven RX buffer scheduler and (de)packetizer
-      execute_kernel(true, config, 0, 0, 0, enable_irq, 0, 0, 0, _rx_buffer_spares[0],
-                     _rx_buffer_spares[0]);
-      execute_kernel(true, config, 0, 0, 0, enable_pkt, 0, 0, 0, _rx_buffer_spares[0],
-                     _rx_buffer_spares[0]);
     }
+    // the buffer count has to be written last, the firmware checks for it
+    write_reg(_base_addr, _nbufs);
+    // the world communicator follows the table, where the firmware looks for it
+    _comm_addr = _base_addr + 4 * (1 + _nbufs * SPARE_BUFFER_FIELDS);
+    _exchmem_floor = _comm_addr;
+    // Start irq-driven RX buffer scheduler and (de)packetizer
+    execute_kernel(true, config, 0, 0, 0, enable_irq, 0, 0, 0, _rx_buffer_spares[0],
+                   _rx_buffer_spares[0]);
+    execute_kernel(true, config, 0, 0, 0, enable_pkt, 0, 0, 0, _rx_buffer_spares[0],
+                   _rx_buffer_spares[0]);
   }
   uint64_t get_retcode() { return read_reg(0xFFC); }
 
@@ -0,0 +1,139 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "xlnx-dac.hpp"
+
+#include <mpi.h>
+#include <vector>
+
+int check_usage(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0] << " <bitstream> <device_idx> <bank_id>"
+              << std::endl;
+    exit(-1);
+  }
+  return 0;
+}
+
+// compares a communicator with the MPI communicator built from the same
+// ranks, and with the block the driver wrote to exchange memory; blocks of
+// communicators created at runtime must lie above the static allocations
+int check_comm(ACCL &f, int comm_id, MPI_Comm mpi_comm, const char *label) {
+  int size, rank;
+  MPI_Comm_size(mpi_comm, &size);
+  MPI_Comm_rank(mpi_comm, &rank);
+  communicator &c = f.get_comm(comm_id);
+  int nerrors = 0;
+  if (c.size() != size || c.local_rank() != rank) {
+    std::cerr << label << ": rank " << c.local_rank() << " of " << c.size()
+              << ", expected " << rank << " of " << size << std::endl;
+    nerrors++;
+  }
+  if (f.read_reg(c.addr()) != size ||
+      (f.read_reg(c.addr() + 4) & 0xffff) != rank) {
+    std::cerr << label << ": exchange memory block does not match"
+              << std::endl;
+    nerrors++;
+  }
+  if (comm_id != 0 && c.addr() < f.comm_floor()) {
+    std::cerr << label << ": block overlaps the static allocations"
+              << std::endl;
+    nerrors++;
+  }
+  return nerrors;
+}
+
+// the firmware finds the world communicator right after the RX buffer table,
+// whose size it takes from the buffer count (COMM_OFFSET)
+int check_world(ACCL &f, int size, int rank) {
+  uint64_t comm_offset =
+      RX_BUFFER_COUNT_OFFSET +
+      4 * (1 + f.read_reg(RX_BUFFER_COUNT_OFFSET) * SPARE_BUFFER_FIELDS);
+  int nerrors = 0;
+  if (f.get_comm(0).addr() != comm_offset) {
+    std::cerr << "world: written at " << std::hex << f.get_comm(0).addr()
+              << ", firmware reads " << comm_offset << std::dec << std::endl;
+    nerrors++;
+  }
+  if (f.read_reg(comm_offset) != size ||
+      (f.read_reg(comm_offset + 4) & 0xffff) != rank) {
+    std::cerr << "world: firmware reads a different communicator" << std::endl;
+    nerrors++;
+  }
+  return nerrors;
+}
+
+int main(int argc, char *argv[]) {
+
+  MPI_Init(&argc, &argv);
+
+  check_usage(argc, argv);
+
+  const std::string bitstream_f = argv[1];
+  const auto device_idx = atoi(argv[2]);
+  const auto bank_idx = atoi(argv[3]);
+
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  ACCL f(size, 16 * 1024, device_idx, DUAL);
+  f.load_bitstream(bitstream_f);
+  f.prep_rx_buffers(bank_idx);
+  f.config_comm(size);
+
+  int nerrors = check_comm(f, 0, MPI_COMM_WORLD, "world");
+  nerrors += check_world(f, size, rank);
+
+  // even and odd ranks, in reverse order
+  MPI_Comm mpi_split;
+  MPI_Comm_split(MPI_COMM_WORLD, rank % 2, size - rank, &mpi_split);
+  int split_id = f.split_comm(0, rank % 2, size - rank);
+  nerrors += check_comm(f, split_id, mpi_split, "split");
+
+  // ranks in the lower half, listed in reverse order
+  std::vector<int> group;
+  for (int i = (size + 1) / 2 - 1; i >= 0; i--) {
+    group.push_back(i);
+  }
+  MPI_Comm mpi_group;
+  bool member = rank < (size + 1) / 2;
+  MPI_Comm_split(MPI_COMM_WORLD, member ? 0 : MPI_UNDEFINED,
+                 (size + 1) / 2 - 1 - rank, &mpi_group);
+  int group_id = f.create_comm(0, group);
+  if (member != (group_id >= 0)) {
+    std::cerr << "create: membership does not match" << std::endl;
+    nerrors++;
+  } else if (member) {
+    nerrors += check_comm(f, group_id, mpi_group, "create");
+  }
+
+  // ranks with a negative color are left out
+  if (f.split_comm(0, rank == 0 ? -1 : 0) >= 0 && rank == 0) {
+    std::cerr << "split: negative color got a communicator" << std::endl;
+    nerrors++;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &nerrors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (rank == 0) {
+    std::cout << (nerrors == 0 ? "Communicator test passed"
+                               : "Communicator test failed")
+              << std::endl;
+  }
+  MPI_Finalize();
+  return nerrors == 0 ? 0 : 1;
+}
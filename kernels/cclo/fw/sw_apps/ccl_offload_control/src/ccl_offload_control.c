@@ -37,11 +37,30 @@ static volatile int 		 dma_tag;
 static volatile unsigned int timeout = 1 << 28;
 static volatile unsigned int dma_tag_lookup [MAX_DMA_TAGS]; //index of the spare buffer that has been issued with that dma tag. -1 otherwise
 static volatile	unsigned int max_segment_size = DMA_MAX_BTT;
+static volatile	unsigned int rndzv_threshold = 0xFFFFFFFF; //rendezvous disabled by default
+static volatile	unsigned int pipeline_threshold = 0; //allreduce pipelined whenever it spans two blocks
+static volatile	unsigned int use_sequencer = 1; //ring collectives expanded into moves by the collective sequencer
+static volatile	unsigned int use_multicast = 1; //broadcast segments replayed by the fan-out block, must match on all ranks
 
 static datapath_arith_config arcfg;
 static communicator world;
-static bool comm_cached = false;
-static bool comm_cache_adr;
+//recently used communicators, by exchange memory address, replaced round-robin
+static communicator comm_cache[COMM_CACHE_SIZE];
+static unsigned int comm_cache_adr[COMM_CACHE_SIZE];
+static unsigned int comm_cache_count = 0;
+static unsigned int comm_cache_next = 0;
+//move flow control: credits left in the dma mover queues, and a FIFO of the results
+//of moves retired early to free credits; a slot holds the merged result of one or more moves
+static unsigned int move_credits = 0;
+static unsigned int move_backlog_err[MOVE_BACKLOG_SIZE];
+static unsigned int move_backlog_moves[MOVE_BACKLOG_SIZE];
+static unsigned int move_backlog_head = 0;
+static unsigned int move_backlog_count = 0;
+//moves issued and not yet ended; RMA requests are only served when this is zero
+static unsigned int moves_outstanding = 0;
+//offsets last sent to the dma mover in a MOVE_CONTEXT instruction, implicit in compact moves
+static unsigned int move_ctx_arcfg = 0xFFFFFFFF;
+static unsigned int move_ctx_comm = 0xFFFFFFFF;
 
 #ifdef MB_FW_EMULATION
 //uint32_t sim_cfgmem[END_OF_EXCHMEM/4];
@@ -68,17 +87,61 @@ inline int max(int x, int y){
 static inline communicator find_comm(unsigned int adr){
 	communicator ret;
 	ret.size 		= Xil_In32(adr);
-	ret.local_rank 	= Xil_In32(adr+4);
+	ret.local_rank 	= MSG_SRC_RANK(Xil_In32(adr+4));
+	ret.id 			= Xil_In32(adr+4) >> COMM_ID_SHIFT;
 	if(ret.size != 0 && ret.local_rank < ret.size){
-		ret.ranks = (comm_rank*)(cfgmem+adr/4+2);
+		ret.ranks = (comm_rank*)(cfgmem+adr/4+COMM_RANKS_OFFSET);
+		ret.ring = (unsigned int*)(cfgmem+adr/4+COMM_RING_OFFSET(ret.size));
 	} else {
 		ret.size = 0;
 		ret.local_rank = 0;
+		ret.id = 0;
 		ret.ranks = NULL;
+		ret.ring = NULL;
 	}
 	return ret;
 }
 
+//returns the communicator at adr, parsing it only if it is not among the recently used ones
+//if refresh is set, the communicator is parsed again, e.g. after the host rewrote it
+static inline communicator lookup_comm(unsigned int adr, bool refresh){
+	unsigned int i;
+	for(i = 0; i < comm_cache_count; i++){
+		if(comm_cache_adr[i] == adr) break;
+	}
+	if(i == comm_cache_count){
+		i = comm_cache_next;
+		comm_cache_next = (comm_cache_next + 1) % COMM_CACHE_SIZE;
+		if(comm_cache_count < COMM_CACHE_SIZE) comm_cache_count++;
+		comm_cache_adr[i] = adr;
+		refresh = true;
+	}
+	if(refresh){
+		comm_cache[i] = find_comm(adr);
+	}
+	return comm_cache[i];
+}
+
+//message source identifying a rank of the current communicator, as found in rx buffers
+static inline unsigned int msg_src(unsigned int rank){
+	return (world.id << COMM_ID_SHIFT) | rank;
+}
+
+//rank at a position of the ring of the current communicator, positions wrap around
+static inline unsigned int ring_rank(unsigned int pos){
+	return world.ring[pos % world.size];
+}
+
+//position of a rank in the ring of the current communicator
+//not cached, since the host may reorder the ring without rewriting the communicator
+static inline unsigned int ring_pos(unsigned int rank){
+	unsigned int i;
+	for(i = 0; i < world.size-1; i++){
+		if(world.ring[i] == rank) break;
+	}
+	return i;
+}
+
 //Packetizer/Depacketizer
 static inline void start_packetizer(unsigned int max_pktsize) {
     //get number of DATAPATH_WIDTH_BYTES transfers corresponding to max_pktsize (rounded down)
@@ -105,63 +168,102 @@ static inline void start_offload_engines(){
 
 //connection management
 
+//(ip, port) to rank lookup, to match connection statuses to ranks in constant time
+static unsigned short con_lookup[CON_LOOKUP_SIZE];
+
+static inline unsigned int con_hash(unsigned int ip, unsigned int port){
+    return ((ip ^ (port << 16) ^ port) * 0x9E3779B1) >> (32 - CON_LOOKUP_LOG);
+}
+
+static inline void con_lookup_insert(unsigned int rank){
+    unsigned int h = con_hash(world.ranks[rank].ip, world.ranks[rank].port);
+    while(con_lookup[h] != CON_LOOKUP_EMPTY){
+        h = (h + 1) & (CON_LOOKUP_SIZE - 1);
+    }
+    con_lookup[h] = rank;
+}
+
+//returns the rank with the given ip and port or -1 if none
+static inline int con_lookup_find(unsigned int ip, unsigned int port){
+    unsigned int h = con_hash(ip, port);
+    unsigned int rank;
+    while(con_lookup[h] != CON_LOOKUP_EMPTY){
+        rank = con_lookup[h];
+        if((world.ranks[rank].ip == ip) && (world.ranks[rank].port == port)){
+            return rank;
+        }
+        h = (h + 1) & (CON_LOOKUP_SIZE - 1);
+    }
+    return -1;
+}
+
 //establish connection with every other rank in the communicator
+//all requests are issued before any status is awaited, failed opens are retried with
+//exponential backoff. On return the session of each rank reports its connection state,
+//SESSION_INVALID if no connection could be opened
 int openCon()
 {
     unsigned int session 	= 0;
     unsigned int dst_ip 	= 0;
     unsigned int dst_port 	= 0;
     unsigned int success	= 0;
-    int ret = 0;
-
-    unsigned int cur_rank_ip	= 0;
-    unsigned int cur_rank_port 	= 0;
+    unsigned int issued, pending, attempt;
+    unsigned int backoff = OPEN_CON_BACKOFF;
+    volatile unsigned int spin;
+    int i, rank;
 
     unsigned int size 		= world.size;
     unsigned int local_rank = world.local_rank;
 
-    //open connection to all the ranks except for the local rank
-    for (int i = 0; i < size; i++)
-    {
-        if (i != local_rank)
-        {
-            cur_rank_ip 	= world.ranks[i].ip;
-            cur_rank_port 	= world.ranks[i].port;
-            //send open connection request to the packetizer
-            putd(CMD_NET_CON, cur_rank_ip);
-            putd(CMD_NET_CON, cur_rank_port);
+    if(2*size > CON_LOOKUP_SIZE){
+        return OPEN_CON_NOT_SUCCEEDED;
+    }
+    for(i = 0; i < CON_LOOKUP_SIZE; i++){
+        con_lookup[i] = CON_LOOKUP_EMPTY;
+    }
+    for(i = 0; i < size; i++){
+        if(i != local_rank){
+            con_lookup_insert(i);
+            world.ranks[i].session = SESSION_INVALID;
         }
     }
-    ret = NO_ERROR;
-    //wait until the connections status are all returned
-    for (int i = 0; i < size -1 ; i++)
-    {	
-        //ask: tngetd or the stack will return a non-success? 
-        session 	= getd(STS_NET_CON);
-        dst_ip 		= getd(STS_NET_CON);
-        dst_port 	= getd(STS_NET_CON);
-        success 	= getd(STS_NET_CON);
-
-        if (success)
-        {
-            //store the session ID into corresponding rank
-            for (int j = 0; j < size ; ++j)
-            {
-                cur_rank_ip 	= world.ranks[j].ip;
-                cur_rank_port 	= world.ranks[j].port;
-                if ((dst_ip == cur_rank_ip) && (dst_port == cur_rank_port))
-                {
-                    world.ranks[j].session = session;
-                    break;
-                }
+
+    for(attempt = 0; ; attempt++){
+        //send open connection requests to the session handler, for all ranks not connected yet
+        issued = 0;
+        for(i = 0; i < size; i++){
+            if((i == local_rank) || (world.ranks[i].session != SESSION_INVALID)) continue;
+            putd(CMD_NET_CON, world.ranks[i].ip);
+            putd(CMD_NET_CON, world.ranks[i].port);
+            issued++;
+        }
+        //wait until the connection statuses are all returned
+        for(i = 0; i < issued; i++){
+            session 	= getd(STS_NET_CON);
+            dst_ip 		= getd(STS_NET_CON);
+            dst_port 	= getd(STS_NET_CON);
+            success 	= getd(STS_NET_CON);
+            rank = con_lookup_find(dst_ip, dst_port);
+            if(success && (rank >= 0)){
+                //store the session ID into corresponding rank
+                world.ranks[rank].session = session;
             }
         }
-        else
-        {
-            ret = OPEN_CON_NOT_SUCCEEDED;
+        pending = 0;
+        for(i = 0; i < size; i++){
+            if((i != local_rank) && (world.ranks[i].session == SESSION_INVALID)){
+                pending++;
+            }
+        }
+        if(pending == 0){
+            return NO_ERROR;
         }
+        if(attempt == OPEN_CON_RETRIES){
+            return OPEN_CON_NOT_SUCCEEDED;
+        }
+        for(spin = 0; spin < backoff; spin++);
+        backoff <<= 1;
     }
-    return ret;
 }
 
 //open local port for listening
@@ -184,10 +286,67 @@ static inline unsigned int segment(unsigned int number_of_bytes,unsigned int seg
     return  (number_of_bytes + segment_size - 1) / segment_size;
 } 
 
+//ask the dma mover how many moves it can queue; must be called with no moves outstanding
+static inline void init_move_credits(void){
+    putd(CMD_DMA_MOVE, MOVE_CREDIT_QUERY);
+    putd(CMD_DMA_MOVE, 0);
+    putd(CMD_DMA_MOVE, 0);
+    move_credits = getd(STS_DMA_MOVE);
+    move_backlog_head = 0;
+    move_backlog_count = 0;
+    moves_outstanding = 0;
+    move_ctx_arcfg = 0xFFFFFFFF;
+    move_ctx_comm = 0xFFFFFFFF;
+}
+
+//strides of compact moves are 16-bit
+static inline bool short_stride(uint32_t opcode, int32_t stride){
+    return (opcode != MOVE_STRIDE) || (stride == (int16_t)stride);
+}
+
+//take a credit for a new move; if the mover queues are full, wait for the oldest
+//move and keep its result for end_move, so the mover never stalls on unread results
+//and any number of moves can be issued ahead of their end_move
+static inline void acquire_move_credit(void){
+    unsigned int tail;
+    if(move_credits == 0){
+        tail = (move_backlog_head + move_backlog_count) % MOVE_BACKLOG_SIZE;
+        if(move_backlog_count < MOVE_BACKLOG_SIZE){
+            move_backlog_err[tail] = getd(STS_DMA_MOVE);
+            move_backlog_moves[tail] = 1;
+            move_backlog_count++;
+        } else{
+            //backlog full, merge into the newest slot; every move it covers reports the merged result
+            tail = (tail + MOVE_BACKLOG_SIZE - 1) % MOVE_BACKLOG_SIZE;
+            move_backlog_err[tail] |= getd(STS_DMA_MOVE);
+            move_backlog_moves[tail]++;
+        }
+        move_credits++;
+    }
+    move_credits--;
+    moves_outstanding++;
+}
+
+//appends the loop word and stride of a move repeated by the dma mover
+static inline void put_move_loop(
+    uint32_t iterations,
+    uint32_t op0_loop_opcode,
+    uint32_t op1_loop_opcode,
+    uint32_t res_loop_opcode,
+    uint32_t rank_step,
+    int32_t  loop_stride
+){
+    putd(CMD_DMA_MOVE, iterations | (op0_loop_opcode << 16) | (op1_loop_opcode << 19) | (res_loop_opcode << 22) | (rank_step << 25));
+    putd(CMD_DMA_MOVE, (uint32_t)loop_stride);
+}
+
 //configure datapath before calling this method
-//instructs the data plane to move data
+//instructs the data plane to move data, repeated the given number of times:
+//iterations after the first use the loop opcodes, with MOVE_STRIDE operands advancing by
+//loop_stride and the destination rank by rank_step; all iterations take one end_move.
+//multicast loops send data read once, see MOVE_MULTICAST
 //use MOVE_IMMEDIATE
-void start_move(
+void start_move_loop(
     uint32_t op0_opcode,
     uint32_t op1_opcode,
     uint32_t res_opcode,
@@ -206,9 +365,17 @@ void start_move(
     uint32_t rx_src_rank,
     uint32_t rx_tag,
     uint32_t tx_dst_rank,
-    uint32_t tx_tag
+    uint32_t tx_tag,
+    uint32_t iterations,
+    uint32_t op0_loop_opcode,
+    uint32_t op1_loop_opcode,
+    uint32_t res_loop_opcode,
+    uint32_t rank_step,
+    int32_t  loop_stride,
+    uint32_t multicast
 ) {
     uint32_t opcode = 0;
+    acquire_move_credit();
     opcode |= op0_opcode;
     opcode |= op1_opcode << 3;
     opcode |= res_opcode << 6;
@@ -216,6 +383,72 @@ void start_move(
     bool res_is_remote = (remote_flags == RES_REMOTE);
     opcode |= compression_flags << 10;
     opcode |= func_id << 13;
+    if(iterations > 1){
+        opcode |= MOVE_LOOP;
+        if(multicast){
+            opcode |= MOVE_MULTICAST;
+        }
+    }
+
+    //use the compact encoding whenever the strides fit
+    if(short_stride(op0_opcode, op0_stride) && short_stride(op1_opcode, op1_stride) && short_stride(res_opcode, res_stride)){
+        bool has_rx = (op1_opcode == MOVE_ON_RECV);
+        bool has_tx_tag = res_is_remote || (res_opcode == MOVE_STREAM);
+        uint32_t strides[3];
+        int i, nstrides = 0;
+        //update the offsets implicit in compact moves, the communicator only if this move uses it
+        if((move_ctx_arcfg != arcfg_offset/4) || ((res_is_remote || has_rx) && (move_ctx_comm != comm_offset/4))){
+            move_ctx_arcfg = arcfg_offset/4;
+            if(res_is_remote || has_rx){
+                move_ctx_comm = comm_offset/4;
+            }
+            putd(CMD_DMA_MOVE, MOVE_CONTEXT);
+            putd(CMD_DMA_MOVE, move_ctx_arcfg);
+            putd(CMD_DMA_MOVE, move_ctx_comm);
+        }
+        if((!has_rx || rx_tag == TAG_ANY) && (!has_tx_tag || tx_tag == TAG_ANY)){
+            opcode |= MOVE_TAG_ANY;
+        }
+        putd(CMD_DMA_MOVE, opcode | MOVE_COMPACT);
+        putd(CMD_DMA_MOVE, count);
+        if(op0_opcode == MOVE_IMMEDIATE){
+            putd(CMD_DMA_MOVE, (uint32_t)op0_addr);
+            putd(CMD_DMA_MOVE, (uint32_t)(op0_addr>>32));
+        } else if(op0_opcode == MOVE_STRIDE){
+            strides[nstrides++] = (uint32_t)op0_stride & 0xFFFF;
+        }
+        if(op1_opcode == MOVE_IMMEDIATE){
+            putd(CMD_DMA_MOVE, (uint32_t)op1_addr);
+            putd(CMD_DMA_MOVE, (uint32_t)(op1_addr>>32));
+        } else if(op1_opcode == MOVE_STRIDE){
+            strides[nstrides++] = (uint32_t)op1_stride & 0xFFFF;
+        }
+        if(res_opcode == MOVE_IMMEDIATE){
+            putd(CMD_DMA_MOVE, (uint32_t)res_addr);
+            putd(CMD_DMA_MOVE, (uint32_t)(res_addr>>32));
+        } else if(res_opcode == MOVE_STRIDE){
+            strides[nstrides++] = (uint32_t)res_stride & 0xFFFF;
+        }
+        for(i = 0; i < nstrides; i += 2){
+            putd(CMD_DMA_MOVE, strides[i] | ((i+1 < nstrides) ? (strides[i+1] << 16) : 0));
+        }
+        if(res_is_remote || has_rx){
+            putd(CMD_DMA_MOVE, (tx_dst_rank << 16) | (rx_src_rank & 0xFFFF));
+        }
+        if(!(opcode & MOVE_TAG_ANY)){
+            if(has_rx){
+                putd(CMD_DMA_MOVE, rx_tag);
+            }
+            if(has_tx_tag){
+                putd(CMD_DMA_MOVE, tx_tag);
+            }
+        }
+        if(iterations > 1){
+            put_move_loop(iterations, op0_loop_opcode, op1_loop_opcode, res_loop_opcode, rank_step, loop_stride);
+        }
+        return;
+    }
+
     putd(CMD_DMA_MOVE, opcode);
     putd(CMD_DMA_MOVE, count);
 
@@ -256,9 +489,60 @@ void start_move(
     if(res_is_remote){
         putd(CMD_DMA_MOVE, tx_dst_rank);
     }
+    if(iterations > 1){
+        put_move_loop(iterations, op0_loop_opcode, op1_loop_opcode, res_loop_opcode, rank_step, loop_stride);
+    }
+}
+
+//configure datapath before calling this method
+//instructs the data plane to move data
+//use MOVE_IMMEDIATE
+void start_move(
+    uint32_t op0_opcode,
+    uint32_t op1_opcode,
+    uint32_t res_opcode,
+    uint32_t compression_flags,
+    uint32_t remote_flags,
+    uint32_t func_id,
+    uint32_t count,
+    uint32_t comm_offset,
+    uint32_t arcfg_offset,
+    uint64_t op0_addr,
+    uint64_t op1_addr,
+    uint64_t res_addr,
+    int32_t  op0_stride,
+    int32_t  op1_stride,
+    int32_t  res_stride,
+    uint32_t rx_src_rank,
+    uint32_t rx_tag,
+    uint32_t tx_dst_rank,
+    uint32_t tx_tag
+) {
+    start_move_loop(
+        op0_opcode, op1_opcode, res_opcode,
+        compression_flags, remote_flags,
+        func_id, count,
+        comm_offset, arcfg_offset,
+        op0_addr, op1_addr, res_addr,
+        op0_stride, op1_stride, res_stride,
+        rx_src_rank, rx_tag,
+        tx_dst_rank, tx_tag,
+        1, MOVE_NONE, MOVE_NONE, MOVE_NONE, 0, 0, 0
+    );
 }
 
-inline int end_move(){
+static inline int end_move(){
+    int err;
+    moves_outstanding--;
+    if(move_backlog_count > 0){
+        err = move_backlog_err[move_backlog_head];
+        if(--move_backlog_moves[move_backlog_head] == 0){
+            move_backlog_head = (move_backlog_head + 1) % MOVE_BACKLOG_SIZE;
+            move_backlog_count--;
+        }
+        return err;
+    }
+    move_credits++;
     return getd(STS_DMA_MOVE);
 }
 
@@ -296,6 +580,31 @@ int move(
     return end_move();
 }
 
+//hands a whole ring collective to the collective sequencer in front of the dma mover,
+//which generates the same moves as the firmware and returns a single merged result
+static inline int sequence(
+    unsigned int op,
+    unsigned int count,
+    unsigned int func,
+    uint64_t src_addr,
+    uint64_t dst_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression
+){
+    acquire_move_credit();
+    putd(CMD_DMA_MOVE, MOVE_SEQUENCE | op | (compression << 10) | (func << 13));
+    putd(CMD_DMA_MOVE, count);
+    putd(CMD_DMA_MOVE, arcfg_offset/4);
+    putd(CMD_DMA_MOVE, comm_offset/4);
+    putd(CMD_DMA_MOVE, ring_pos(world.local_rank));
+    putd(CMD_DMA_MOVE, (uint32_t)src_addr);
+    putd(CMD_DMA_MOVE, (uint32_t)(src_addr>>32));
+    putd(CMD_DMA_MOVE, (uint32_t)dst_addr);
+    putd(CMD_DMA_MOVE, (uint32_t)(dst_addr>>32));
+    return end_move();
+}
+
 //performs a copy using DMA0. DMA0 rx reads while DMA1 tx overwrites
 //use MOVE_IMMEDIATE
 static inline int copy(	unsigned int count,
@@ -379,61 +688,422 @@ int recv(	unsigned int src_rank,
     );
 }
 
-//iterates over rx buffers until match is found or a timeout expires
-//matches count, src and tag if tag is not ANY
+//looks up the next in-order message from a rank in the rx buffers, without consuming it
+//messages are consumed in sequence order, so only the first pending segment from 
+//the source can match; matches tag unless either side is TAG_ANY
 //returns the index of the spare_buffer or -1 if not found
 int seek_rx_buffer(
     unsigned int src_rank,
-    unsigned int count,
     unsigned int src_tag
 ){
-    unsigned int seq_num; //src_port TODO: use this variable to choose depending on session id or port
     int i;
-    seq_num = world.ranks[src_rank].inbound_seq + 1;
-
-    //TODO: use a list to store recent message received to avoid scanning in the entire spare_buffer_struct.
-    //parse rx buffers until match is found
-    //matches count, src
-    //matches tag or tag is ANY
-    //return buffer index 
+    //the dma mover advances the expected sequence number as it consumes segments
+    unsigned int seq_num = ((volatile comm_rank*)world.ranks)[src_rank].inbound_seq;
     unsigned int nbufs = Xil_In32(RX_BUFFER_COUNT_OFFSET);
-    rx_buffer *rx_buf_list = (rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+    //TODO: use a list to store recent message received to avoid scanning in the entire spare_buffer_struct.
     for(i=0; i<nbufs; i++){	
-        if(rx_buf_list[i].status == STATUS_RESERVED)
-        {
-            if((rx_buf_list[i].rx_src == src_rank) && (rx_buf_list[i].rx_len == count))
-            {
-                if(((rx_buf_list[i].rx_tag == src_tag) || (src_tag == TAG_ANY)) && (rx_buf_list[i].sequence_number == seq_num) )
-                {
-                    //only now advance sequence number
-                    world.ranks[src_rank].inbound_seq++;
-                    return i;
-                }
+        //rendezvous CTS and FIN are out of band, skip them
+        if((rx_buf_list[i].msg_type != MSG_EAGER) && (rx_buf_list[i].msg_type != MSG_RNDZV_RTS)) continue;
+        if((rx_buf_list[i].status == STATUS_RESERVED) && (rx_buf_list[i].rx_src == msg_src(src_rank)) && (rx_buf_list[i].sequence_number == seq_num)){
+            if((rx_buf_list[i].rx_tag == src_tag) || (src_tag == TAG_ANY) || (rx_buf_list[i].rx_tag == TAG_ANY)){
+                return i;
             }
+            //the head of line message from this source has a different tag
+            return -1;
         }
     }
     return -1;
 }
 
-//iterates over rx buffers until match is found or a timeout expires
-//matches count, src and tag if tag is not ANY
-//returns the index of the spare_buffer
-//timeout is jumps to exception handler
-//useful as infrastructure for [I]MProbe/[I]MRecv
+//iterates over the sources (all of them if SRC_ANY) until a matching message is found
+//or, if blocking, until a timeout expires, in which case we jump to the exception handler
+//returns the index of the spare_buffer or -1 if not found
 int wait_on_rx(
     unsigned int src_rank,
-    unsigned int count,
-    unsigned int src_tag
+    unsigned int src_tag,
+    bool blocking
 ){
     int idx, i;
+    unsigned int src;
+    for(i = 0; timeout == 0 || i < timeout; i++){
+        for(src = 0; src < world.size; src++){
+            if(src_rank != SRC_ANY && src != src_rank) continue;
+            idx = seek_rx_buffer(src, src_tag);
+            if(idx >= 0) return idx;
+        }
+        if(!blocking) return -1;
+    }
+    longjmp(excp_handler, RECEIVE_TIMEOUT_ERROR);
+    return -1;
+}
+
+//[I]Probe: report source, tag and total byte count of the next message matching
+//src_rank and src_tag in the probe status, without receiving it
+//a subsequent recv from the reported source, with the reported tag and count,
+//receives exactly the probed message, since messages from a source are consumed in order
+int probe(
+    unsigned int src_rank,
+    unsigned int src_tag,
+    unsigned int blocking,
+    unsigned int status_offset
+){
+    int idx;
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    idx = wait_on_rx(src_rank, src_tag, blocking == PROBE_BLOCKING);
+    if(idx >= 0){
+        Xil_Out32(status_offset + 4*PROBE_SRC_OFFSET, MSG_SRC_RANK(rx_buf_list[idx].rx_src));
+        Xil_Out32(status_offset + 4*PROBE_TAG_OFFSET, rx_buf_list[idx].rx_tag);
+        Xil_Out32(status_offset + 4*PROBE_COUNT_OFFSET, rx_buf_list[idx].msg_count);
+    }
+    Xil_Out32(status_offset + 4*PROBE_FLAG_OFFSET, (idx >= 0) ? 1 : 0);
+    return NO_ERROR;
+}
+
+//rendezvous is used for uncompressed memory-to-memory send/recv above the threshold, over TCP,
+//where the rx buffer session handler can steer payload to the address announced in the CTS
+static inline bool rndzv_eligible(unsigned int count, unsigned int arcfg_offset, unsigned int compression, unsigned int stream){
+    return use_tcp && (compression == NO_COMPRESSION) && (stream == NO_STREAM) &&
+            (count * Xil_In32(arcfg_offset) > rndzv_threshold);
+}
+
+//sends one step of the rendezvous protocol to a rank
+//same encoding as start_move for an immediate-to-remote move, with the message type in the
+//opcode and its 64-bit argument appended
+int rndzv_move(
+    unsigned int dst_rank,
+    unsigned int count,
+    uint64_t src_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int dst_tag,
+    unsigned int msg_type,
+    uint64_t arg
+){
+    uint32_t opcode = MOVE_IMMEDIATE | (MOVE_NONE << 3) | (MOVE_IMMEDIATE << 6) | (RES_REMOTE << 9) | (msg_type << 17);
+    acquire_move_credit();
+    putd(CMD_DMA_MOVE, opcode);
+    putd(CMD_DMA_MOVE, count);
+    putd(CMD_DMA_MOVE, arcfg_offset/4);
+    putd(CMD_DMA_MOVE, (uint32_t)src_addr);
+    putd(CMD_DMA_MOVE, (uint32_t)(src_addr>>32));
+    putd(CMD_DMA_MOVE, 0);
+    putd(CMD_DMA_MOVE, 0);
+    putd(CMD_DMA_MOVE, dst_tag);
+    putd(CMD_DMA_MOVE, comm_offset/4);
+    putd(CMD_DMA_MOVE, dst_rank);
+    putd(CMD_DMA_MOVE, (uint32_t)arg);
+    putd(CMD_DMA_MOVE, (uint32_t)(arg>>32));
+    return end_move();
+}
+
+//reads a field of the entry of a rank in a RMA window
+static inline unsigned int win_field(unsigned int win_offset, unsigned int rank, unsigned int field){
+    return Xil_In32(win_offset + 4*(WIN_RANKS_OFFSET + rank*WIN_RANK_SIZE + field));
+}
+
+static inline uint64_t win_base(unsigned int win_offset, unsigned int rank){
+    return ((uint64_t)win_field(win_offset, rank, WIN_BASEH_OFFSET) << 32) | win_field(win_offset, rank, WIN_BASEL_OFFSET);
+}
+
+//finds the local window with the given handle among those the driver opened to direct writes,
+//returns the size of its local range, 0 if there is no such window
+static inline unsigned int win_grant_size(unsigned int win){
+    unsigned int i, offset;
+    for(i = DIRECT_GRANT_RNDZV+1; i < DIRECT_GRANT_COUNT; i++){
+        offset = DIRECT_GRANT_OFFSET + 4*i*DIRECT_GRANT_FIELDS;
+        if(Xil_In32(offset + 4*DIRECT_GRANT_WIN_OFFSET) == win){
+            return Xil_In32(offset + 4*DIRECT_GRANT_SIZE_OFFSET);
+        }
+    }
+    return 0;
+}
+
+//answers RMA requests addressed to windows of this rank: a get request with the window contents,
+//a flush request with an acknowledgement, which follows all puts the origin issued before it
+//called while the CCLO waits for a call and while it waits on out of band messages,
+//so a target makes progress without posting anything. Also discards rendezvous payload
+//which was outside of the direct write grants and landed in a rx buffer instead.
+//Answers take moves of their own, whose results would mix with those of a caller's
+//moves in flight, so requests wait until no moves are outstanding. Requests come from the
+//network: a handle which is not a local window, a rank outside of its communicator or
+//a range past the end of the local window drops the request, and the origin times out
+void service_rma(void){
+    int i;
+    unsigned int type, src, win, comm_offset, arcfg_offset, local_rank, count, displ, win_size;
+    unsigned int nbufs = Xil_In32(RX_BUFFER_COUNT_OFFSET);
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+    if(moves_outstanding > 0) return;
+    for(i=0; i<nbufs; i++){
+        if(rx_buf_list[i].status != STATUS_RESERVED) continue;
+        type = rx_buf_list[i].msg_type;
+        if(type == MSG_RNDZV_DATA){
+            rx_buf_list[i].status = STATUS_IDLE;
+            continue;
+        }
+        if((type != MSG_RMA_GET) && (type != MSG_RMA_FLUSH)) continue;
+        //requests carry the target's handle of the window in place of the tag
+        src = MSG_SRC_RANK(rx_buf_list[i].rx_src);
+        win = rx_buf_list[i].rx_tag;
+        count = rx_buf_list[i].rndzv_addrh;
+        displ = rx_buf_list[i].rndzv_addrl;
+        rx_buf_list[i].status = STATUS_IDLE;
+        win_size = win_grant_size(win);
+        if(win_size == 0) continue;
+        comm_offset = Xil_In32(win + 4*WIN_COMM_OFFSET);
+        arcfg_offset = Xil_In32(win + 4*WIN_ARCFG_OFFSET);
+        local_rank = MSG_SRC_RANK(Xil_In32(comm_offset + 4));
+        if(src >= Xil_In32(comm_offset) || src == local_rank) continue;
+        if(type == MSG_RMA_GET){
+            if((uint64_t)displ + (uint64_t)count * Xil_In32(arcfg_offset) > win_size) continue;
+            rndzv_move(src, count, win_base(win, local_rank) + displ, comm_offset, arcfg_offset,
+                        win_field(win, src, WIN_HANDLE_OFFSET), MSG_RMA_GET_RESP, displ);
+        } else{
+            rndzv_move(src, 1, win_base(win, local_rank), comm_offset, arcfg_offset,
+                        win_field(win, src, WIN_HANDLE_OFFSET), MSG_RMA_FLUSH_ACK, 0);
+        }
+    }
+}
+
+//waits for an out of band control message (rendezvous CTS or FIN, RMA response) from a rank
+//returns the index of the spare_buffer holding it; the caller releases it
+int wait_rndzv_ctrl(
+    unsigned int src_rank,
+    unsigned int msg_type
+){
+    int i, j;
+    unsigned int nbufs = Xil_In32(RX_BUFFER_COUNT_OFFSET);
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
     for(i = 0; timeout == 0 || i < timeout; i++){
-        idx = seek_rx_buffer(src_rank, count, src_tag);
-        if(idx >= 0) return idx;
+        for(j=0; j<nbufs; j++){
+            if((rx_buf_list[j].status == STATUS_RESERVED) && (rx_buf_list[j].msg_type == msg_type) && (rx_buf_list[j].rx_src == msg_src(src_rank))){
+                return j;
+            }
+        }
+        //the peer may itself be waiting on us
+        service_rma();
     }
     longjmp(excp_handler, RECEIVE_TIMEOUT_ERROR);
     return -1;
 }
 
+//rendezvous send: announce the message with a RTS, which takes its place in the in-order
+//message stream and carries the first element, then wait for the receiver's CTS with the
+//address of the posted buffer and write the payload directly there, followed by a FIN
+int rndzv_send(
+    unsigned int dst_rank,
+    unsigned int count,
+    uint64_t src_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int dst_tag
+){
+    int idx, err;
+    uint64_t dst_addr;
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    err = rndzv_move(dst_rank, 1, src_addr, comm_offset, arcfg_offset, dst_tag, MSG_RNDZV_RTS, count * Xil_In32(arcfg_offset));
+    idx = wait_rndzv_ctrl(dst_rank, MSG_RNDZV_CTS);
+    dst_addr = ((uint64_t)rx_buf_list[idx].rndzv_addrh << 32) | rx_buf_list[idx].rndzv_addrl;
+    rx_buf_list[idx].status = STATUS_IDLE;
+    err |= rndzv_move(dst_rank, count, src_addr, comm_offset, arcfg_offset, dst_tag, MSG_RNDZV_DATA, dst_addr);
+    err |= rndzv_move(dst_rank, 1, src_addr, comm_offset, arcfg_offset, dst_tag, MSG_RNDZV_FIN, 0);
+    return err;
+}
+
+//opens or closes the posted buffer of a rendezvous receive to direct writes
+static inline void rndzv_grant(uint64_t addr, unsigned int size){
+    unsigned int offset = DIRECT_GRANT_OFFSET + 4*DIRECT_GRANT_RNDZV*DIRECT_GRANT_FIELDS;
+    Xil_Out32(offset + 4*DIRECT_GRANT_BASEL_OFFSET, (uint32_t)addr);
+    Xil_Out32(offset + 4*DIRECT_GRANT_BASEH_OFFSET, (uint32_t)(addr >> 32));
+    Xil_Out32(offset + 4*DIRECT_GRANT_SIZE_OFFSET, size);
+}
+
+//rendezvous receive: if the next matching message is a RTS, consume it into the posted buffer,
+//answer with a CTS carrying the buffer address and wait for the FIN which follows the payload;
+//an eager message is received as usual. The message is matched first, so src_rank may be SRC_ANY
+int rndzv_recv(
+    unsigned int src_rank,
+    unsigned int count,
+    uint64_t dst_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int src_tag,
+    unsigned int compression
+){
+    int idx, err;
+    unsigned int src, tag, bytes;
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    idx = wait_on_rx(src_rank, src_tag, true);
+    src = MSG_SRC_RANK(rx_buf_list[idx].rx_src);
+    tag = rx_buf_list[idx].rx_tag;
+    if(rx_buf_list[idx].msg_type != MSG_RNDZV_RTS){
+        return recv(src, count, dst_addr, comm_offset, arcfg_offset, tag, compression);
+    }
+    bytes = rx_buf_list[idx].msg_count;
+    if(bytes > count * Xil_In32(arcfg_offset)){
+        return RECEIVE_TRUNCATION_ERROR;
+    }
+    //the payload overwrites the element carried by the RTS
+    err = recv(src, 1, dst_addr, comm_offset, arcfg_offset, tag, NO_COMPRESSION);
+    //only the announced payload size is open to the sender
+    rndzv_grant(dst_addr, bytes);
+    err |= rndzv_move(src, 1, dst_addr, comm_offset, arcfg_offset, tag, MSG_RNDZV_CTS, dst_addr);
+    //the FIN is written to its rx buffer after the payload, so the payload has landed once it shows up
+    idx = wait_rndzv_ctrl(src, MSG_RNDZV_FIN);
+    rx_buf_list[idx].status = STATUS_IDLE;
+    rndzv_grant(0, 0);
+    return err;
+}
+
+//receives the next message matching src_rank and src_tag, of at most max_count elements
+//the message is matched before the move is issued, so src_rank may be SRC_ANY and the
+//count comes from the message header; source, tag and byte count are reported in the
+//status, as by probe(). A message longer than max_count stays pending and
+//RECEIVE_TRUNCATION_ERROR is returned, with its byte count reported so the caller can retry
+int recv_up_to(	unsigned int src_rank,
+                unsigned int max_count,
+                uint64_t dst_addr,
+                unsigned int comm_offset,
+                unsigned int arcfg_offset,
+                unsigned int src_tag,
+                unsigned int compression,
+                unsigned int status_offset){
+    int idx;
+    unsigned int elem_bytes, elem_ratio_log, count;
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    Xil_Out32(status_offset + 4*PROBE_FLAG_OFFSET, 0);
+    idx = wait_on_rx(src_rank, src_tag, true);
+    //convert the message length on the wire to elements, as in get_len() of the dma mover
+    if(compression & (OP1_COMPRESSED | ETH_COMPRESSED)){
+        elem_bytes = Xil_In32(arcfg_offset + 4);
+        elem_ratio_log = Xil_In32(arcfg_offset + 8);
+    } else{
+        elem_bytes = Xil_In32(arcfg_offset);
+        elem_ratio_log = 0;
+    }
+    count = (rx_buf_list[idx].msg_count / elem_bytes) << elem_ratio_log;
+    Xil_Out32(status_offset + 4*PROBE_SRC_OFFSET, MSG_SRC_RANK(rx_buf_list[idx].rx_src));
+    Xil_Out32(status_offset + 4*PROBE_TAG_OFFSET, rx_buf_list[idx].rx_tag);
+    Xil_Out32(status_offset + 4*PROBE_COUNT_OFFSET, rx_buf_list[idx].msg_count);
+    if(count > max_count){
+        return RECEIVE_TRUNCATION_ERROR;
+    }
+    //receive with the matched tag, which the rx buffer lookup accepts even if it is TAG_ANY
+    int err;
+    if(rx_buf_list[idx].msg_type == MSG_RNDZV_RTS){
+        err = rndzv_recv(MSG_SRC_RANK(rx_buf_list[idx].rx_src), count, dst_addr, comm_offset, arcfg_offset, rx_buf_list[idx].rx_tag, compression);
+    } else{
+        err = recv(MSG_SRC_RANK(rx_buf_list[idx].rx_src), count, dst_addr, comm_offset, arcfg_offset, rx_buf_list[idx].rx_tag, compression);
+    }
+    Xil_Out32(status_offset + 4*PROBE_FLAG_OFFSET, 1);
+    return err;
+}
+
+//one-sided put: write count elements from src_addr at byte displacement displ of the window
+//of dst_rank, as rendezvous payload, without any action by the target; the data is only
+//guaranteed to have landed after a subsequent flush. Requires the direct writes of TCP sessions
+int rma_put(
+    unsigned int dst_rank,
+    unsigned int count,
+    uint64_t src_addr,
+    uint64_t displ,
+    unsigned int win_offset
+){
+    unsigned int comm_offset = Xil_In32(win_offset + 4*WIN_COMM_OFFSET);
+    unsigned int arcfg_offset = Xil_In32(win_offset + 4*WIN_ARCFG_OFFSET);
+    uint64_t bytes = (uint64_t)count * Xil_In32(arcfg_offset);
+
+    if(displ + bytes > win_field(win_offset, dst_rank, WIN_SIZE_OFFSET)){
+        return RMA_WINDOW_ERROR;
+    }
+    if(bytes == 0){
+        return NO_ERROR;
+    }
+    if(dst_rank == MSG_SRC_RANK(Xil_In32(comm_offset + 4))){
+        return copy(count, src_addr, win_base(win_offset, dst_rank) + displ, arcfg_offset, NO_COMPRESSION, NO_STREAM);
+    }
+    if(!use_tcp){
+        return COLLECTIVE_NOT_IMPLEMENTED;
+    }
+    return rndzv_move(dst_rank, count, src_addr, comm_offset, arcfg_offset,
+                        win_field(win_offset, dst_rank, WIN_HANDLE_OFFSET), MSG_RNDZV_DATA,
+                        win_base(win_offset, dst_rank) + displ);
+}
+
+//one-sided get: read count elements at byte displacement displ of the window of src_rank
+//into dst_addr. The request is served by the target firmware, the response arrives in
+//segments through the rx buffers, each tagged with its window offset, and is copied out
+int rma_get(
+    unsigned int src_rank,
+    unsigned int count,
+    uint64_t dst_addr,
+    uint64_t displ,
+    unsigned int win_offset
+){
+    int idx, err;
+    unsigned int comm_offset = Xil_In32(win_offset + 4*WIN_COMM_OFFSET);
+    unsigned int arcfg_offset = Xil_In32(win_offset + 4*WIN_ARCFG_OFFSET);
+    unsigned int elem_bytes = Xil_In32(arcfg_offset);
+    uint64_t bytes = (uint64_t)count * elem_bytes;
+    uint64_t received, seg_addr;
+    unsigned int seg_len;
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    if(displ + bytes > win_field(win_offset, src_rank, WIN_SIZE_OFFSET)){
+        return RMA_WINDOW_ERROR;
+    }
+    if(bytes == 0){
+        return NO_ERROR;
+    }
+    if(src_rank == MSG_SRC_RANK(Xil_In32(comm_offset + 4))){
+        return copy(count, win_base(win_offset, src_rank) + displ, dst_addr, arcfg_offset, NO_COMPRESSION, NO_STREAM);
+    }
+    err = rndzv_move(src_rank, 1, dst_addr, comm_offset, arcfg_offset,
+                        win_field(win_offset, src_rank, WIN_HANDLE_OFFSET), MSG_RMA_GET,
+                        ((uint64_t)count << 32) | (uint32_t)displ);
+    for(received = 0; received < bytes; received += seg_len){
+        idx = wait_rndzv_ctrl(src_rank, MSG_RMA_GET_RESP);
+        seg_addr = ((uint64_t)rx_buf_list[idx].addrh << 32) | rx_buf_list[idx].addrl;
+        seg_len = rx_buf_list[idx].rx_len;
+        err |= copy(seg_len / elem_bytes, seg_addr, dst_addr + (rx_buf_list[idx].rndzv_addrl - (uint32_t)displ),
+                    arcfg_offset, NO_COMPRESSION, NO_STREAM);
+        rx_buf_list[idx].status = STATUS_IDLE;
+    }
+    return err;
+}
+
+//completes all puts issued to the window of dst_rank, or of every rank if SRC_ANY:
+//a flush request to each target follows the payload on the same session,
+//so its acknowledgement means all preceding puts have landed
+int rma_flush(
+    unsigned int dst_rank,
+    unsigned int win_offset
+){
+    int idx, err = NO_ERROR;
+    unsigned int i;
+    unsigned int comm_offset = Xil_In32(win_offset + 4*WIN_COMM_OFFSET);
+    unsigned int arcfg_offset = Xil_In32(win_offset + 4*WIN_ARCFG_OFFSET);
+    unsigned int size = Xil_In32(comm_offset);
+    unsigned int local_rank = MSG_SRC_RANK(Xil_In32(comm_offset + 4));
+    volatile rx_buffer *rx_buf_list = (volatile rx_buffer*)(cfgmem+RX_BUFFER_COUNT_OFFSET/4+1);
+
+    for(i = 0; i < size; i++){
+        if(i == local_rank || (dst_rank != SRC_ANY && i != dst_rank)) continue;
+        err |= rndzv_move(i, 1, win_base(win_offset, local_rank), comm_offset, arcfg_offset,
+                            win_field(win_offset, i, WIN_HANDLE_OFFSET), MSG_RMA_FLUSH, 0);
+    }
+    for(i = 0; i < size; i++){
+        if(i == local_rank || (dst_rank != SRC_ANY && i != dst_rank)) continue;
+        idx = wait_rndzv_ctrl(i, MSG_RMA_FLUSH_ACK);
+        rx_buf_list[idx].status = STATUS_IDLE;
+    }
+    return err;
+}
+
 //1) receives from a rank
 //2) sums with a a buffer 
 //3) the result is saved in (possibly another) local buffer
@@ -504,6 +1174,8 @@ int fused_recv_reduce_send(
 //root reads multiple times the same segment and send it to each rank before 
 //moving to the next part of the buffer to be transmitted.
 //use MOVE_IMMEDIATE and MOVE_INCREMENTING and MOVE_REPEATING in sequence 
+//with multicast the segment is read once and replayed to the other ranks by the
+//fan-out block, so segments are capped at its buffer size on all ranks
 int broadcast(  unsigned int count,
                 unsigned int src_rank,
                 uint64_t buf_addr,
@@ -513,7 +1185,7 @@ int broadcast(  unsigned int count,
                 unsigned int stream){
 
     int err = NO_ERROR;
-    unsigned int max_seg_count; 
+    unsigned int max_seg_count, seg_count; 
     int elems_remaining = count;
     //convert max segment size to max segment count
     //if pulling from a stream, segment size is irrelevant and we use the 
@@ -525,6 +1197,9 @@ int broadcast(  unsigned int count,
         //instead of Xil_In32 we could use:
         //(datapath_arith_config*)(arcfg_offset)->uncompressed_elem_bytes;
         max_seg_count = max_segment_size / Xil_In32(arcfg_offset);
+        if(use_multicast){
+            max_seg_count = min(max_seg_count, MULTICAST_MAX_BYTES / Xil_In32(arcfg_offset));
+        }
     }
 
     while(elems_remaining > 0){
@@ -534,20 +1209,21 @@ int broadcast(  unsigned int count,
             //so replace RES_COMPRESSED with ETH_COMPRESSED
             compression = compression | (compression >> 1);
 
-            //send a segment to each of the ranks (excluding self)
-            for(int i=0; i < world.size; i++){
-                start_move(
-                    (i==0) ? ((elems_remaining == count) ? MOVE_IMMEDIATE : MOVE_INCREMENT) : MOVE_REPEAT, 
-                    MOVE_NONE, 
-                    MOVE_IMMEDIATE, 
+            //send a segment to each of the ranks (excluding self) in one loop, starting after self
+            //and wrapping around the communicator; the first move addresses the segment,
+            //the others repeat its address, or replay it from the fan-out block if multicasting
+            seg_count = min(max_seg_count, elems_remaining);
+            if(world.size > 1){
+                start_move_loop(
+                    (elems_remaining == count) ? MOVE_IMMEDIATE : MOVE_INCREMENT, MOVE_NONE, MOVE_IMMEDIATE, 
                     compression, RES_REMOTE, 0,
-                    (i == src_rank) ? 0 : min(max_seg_count, elems_remaining), 
+                    seg_count, 
                     comm_offset, arcfg_offset, 
                     buf_addr, 0, 0, 0, 0, 0,
-                    0, 0, i, TAG_ANY
+                    0, 0, src_rank+1, TAG_ANY,
+                    world.size-1, MOVE_REPEAT, MOVE_NONE, MOVE_IMMEDIATE, 1, 0,
+                    use_multicast && !(stream & OP0_STREAM)
                 );
-            }
-            for(int i=0; i < world.size; i++){
                 err |= end_move();
             }
         } else{
@@ -592,19 +1268,45 @@ int scatter(unsigned int count,
         //so replace RES_COMPRESSED with ETH_COMPRESSED
         compression = compression | (compression >> 1);
 
-        for(int i=0; i < world.size; i++){
-            start_move(
-                (i==0) ? MOVE_IMMEDIATE : MOVE_INCREMENT, 
-                MOVE_NONE,
-                MOVE_IMMEDIATE, 
-                compression, (i==src_rank) ? RES_LOCAL : RES_REMOTE, 0,
+        //consecutive chunks go to the ranks before self in one loop, to self, then to the ranks
+        //after self in another loop
+        unsigned int nmoves = 0;
+        if(src_rank > 0){
+            start_move_loop(
+                MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE, 
+                compression, RES_REMOTE, 0,
                 count, 
                 comm_offset, arcfg_offset, 
                 src_buf_addr, 0, dst_buf_addr, 0, 0, 0,
-                0, 0, i, TAG_ANY
+                0, 0, 0, TAG_ANY,
+                src_rank, MOVE_INCREMENT, MOVE_NONE, MOVE_IMMEDIATE, 1, 0, 0
+            );
+            nmoves++;
+        }
+        start_move(
+            (src_rank == 0) ? MOVE_IMMEDIATE : MOVE_INCREMENT, 
+            MOVE_NONE,
+            MOVE_IMMEDIATE, 
+            compression, RES_LOCAL, 0,
+            count, 
+            comm_offset, arcfg_offset, 
+            src_buf_addr, 0, dst_buf_addr, 0, 0, 0,
+            0, 0, src_rank, TAG_ANY
+        );
+        nmoves++;
+        if(src_rank < world.size-1){
+            start_move_loop(
+                MOVE_INCREMENT, MOVE_NONE, MOVE_IMMEDIATE, 
+                compression, RES_REMOTE, 0,
+                count, 
+                comm_offset, arcfg_offset, 
+                src_buf_addr, 0, dst_buf_addr, 0, 0, 0,
+                0, 0, src_rank+1, TAG_ANY,
+                world.size-1-src_rank, MOVE_INCREMENT, MOVE_NONE, MOVE_IMMEDIATE, 1, 0, 0
             );
+            nmoves++;
         }
-        for(int i=0; i < world.size; i++){
+        for(int i=0; i < nmoves; i++){
             err |= end_move();
         }
     } else{
@@ -638,11 +1340,13 @@ int gather( unsigned int count,
             unsigned int compression,
             unsigned int stream){
     uint64_t tmp_buf_addr;
-    unsigned int i, curr_pos, next_in_ring, prev_in_ring, number_of_shift;
+    unsigned int i, local_pos, curr_pos, next_in_ring, prev_in_ring, number_of_shift;
+    int curr_slot, prev_slot = 0;
     int err = NO_ERROR;
 
-    next_in_ring = (world.local_rank + 1) % world.size;
-    prev_in_ring = (world.local_rank + world.size - 1) % world.size;
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
     
     //TODO: compute compression
 
@@ -664,9 +1368,10 @@ int gather( unsigned int count,
             0, 0, 0, 0
         );
 
-        //receive from all members of the communicator
-        curr_pos = world.local_rank;
+        //receive from all members of the communicator, into the slot of the originating rank
+        curr_pos = local_pos;
         for(i=0; i<world.size; i++){
+            curr_slot = ring_rank(curr_pos);
             start_move(
                 (i==0) ? MOVE_IMMEDIATE : MOVE_NONE,
                 (i==0) ? MOVE_NONE : MOVE_ON_RECV, 
@@ -674,9 +1379,10 @@ int gather( unsigned int count,
                 NO_COMPRESSION, RES_LOCAL, NO_STREAM,
                 count,
                 comm_offset, arcfg_offset,
-                src_buf_addr, 0, 0, 0, 0, count*((i==0) ? curr_pos : ((curr_pos==(world.size-1)) ? (world.size-1) : -1)),
+                src_buf_addr, 0, 0, 0, 0, count*(curr_slot - prev_slot),
                 prev_in_ring, TAG_ANY, 0, 0
             );
+            prev_slot = curr_slot;
             //update current position
             curr_pos = (curr_pos + world.size - 1) % world.size;
         }
@@ -703,7 +1409,7 @@ int gather( unsigned int count,
             0, 0, next_in_ring, TAG_ANY
         );
         //next relay a number of times depending on our position in the ring
-        number_of_shift = ((world.size+world.local_rank-root_rank)%world.size) - 1 ; //distance to the root
+        number_of_shift = ((world.size+local_pos-ring_pos(root_rank))%world.size) - 1 ; //distance to the root
         for (i=0; i<number_of_shift; i++){	
             start_move(
                 MOVE_NONE, 
@@ -733,7 +1439,7 @@ int allgather(
     unsigned int compression,
     unsigned int stream
 ){
-    int i, curr_pos, rel_stride, abs_stride, next_in_ring, prev_in_ring;
+    int i, local_pos, curr_pos, rel_stride, abs_stride, next_in_ring, prev_in_ring;
     int err = NO_ERROR;
 
     //compression is tricky for the relay: we've already received into the destination buffer 
@@ -742,8 +1448,13 @@ int allgather(
     unsigned int relay_compression = (compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression;
     relay_compression &= ~(RES_COMPRESSED);
 
-    next_in_ring = (world.local_rank + 1) % world.size;
-    prev_in_ring = (world.local_rank + world.size - 1) % world.size;
+    if(use_sequencer && world.size > 1){
+        return sequence(SEQUENCE_ALLGATHER, count, 0, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression);
+    }
+
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
 
     //prime the address slot for the destination, so we can subsequently stride against it
     start_move(
@@ -780,10 +1491,11 @@ int allgather(
     err |= end_move();
 
     //receive and forward from all other members of the communicator
-    curr_pos = world.local_rank;
+    //each chunk goes to the slot of its originating rank, one position further back in the ring
+    curr_pos = local_pos;
     for(i=0; i<world.size-1; i++){
-        rel_stride = count*((curr_pos == 0) ? (world.size-1) : -1);
-        abs_stride = count*((curr_pos == 0) ? (world.size-1) : curr_pos-1);
+        abs_stride = count*ring_rank(curr_pos + world.size - 1);
+        rel_stride = abs_stride - count*ring_rank(curr_pos);
 
         //we use a blocking move here, because we want to avoid a race condition with the relay below
         //TODO: avoid this; we either need to solve the RAW dependency in hardware (the generic approach),
@@ -839,8 +1551,9 @@ int reduce( unsigned int count,
             unsigned int compression,
             unsigned int stream){
 
-    unsigned int next_in_ring = (world.local_rank + 1) % world.size;
-    unsigned int prev_in_ring = (world.local_rank + world.size-1) % world.size;
+    unsigned int local_pos = ring_pos(world.local_rank);
+    unsigned int next_in_ring = ring_rank(local_pos + 1);
+    unsigned int prev_in_ring = ring_rank(local_pos + world.size - 1);
 
     //determine if we're sending or receiving
     if( prev_in_ring == root_rank){ 
@@ -867,7 +1580,7 @@ int reduce_scatter(
     unsigned int compression,
     unsigned int stream
 ){
-    int i, curr_pos, rel_stride, abs_stride, next_in_ring, prev_in_ring;
+    int i, local_pos, curr_pos, rel_stride, abs_stride, next_in_ring, prev_in_ring;
     int err = NO_ERROR;
 
     //compression is tricky for the relay: we've already received into the destination buffer 
@@ -876,8 +1589,13 @@ int reduce_scatter(
     unsigned int relay_compression = (compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression;
     relay_compression &= ~(RES_COMPRESSED);
 
-    next_in_ring = (world.local_rank + 1) % world.size;
-    prev_in_ring = (world.local_rank + world.size - 1) % world.size;
+    if(use_sequencer && world.size > 1){
+        return sequence(SEQUENCE_REDUCE_SCATTER, count, func, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression);
+    }
+
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
 
     //preamble: send our data to next in ring
     //prime the address slot for the source, so we can subsequently stride against it
@@ -901,9 +1619,10 @@ int reduce_scatter(
     );
 
     //receive and reduce+forward from all other members of the communicator
-    curr_pos = world.local_rank;
+    //the chunk of the rank one position further back in the ring, we end with the chunk of next in ring
+    curr_pos = local_pos;
     for(i=0; i<world.size-1; i++){
-        rel_stride = count*((curr_pos == 0) ? (world.size-1) : -1);
+        rel_stride = count*(ring_rank(curr_pos + world.size - 1) - ring_rank(curr_pos));
 
         //simultaneous receive, reduce and send for the received chunk,
         //unless it is the last step, in which case we don't send, but save locally
@@ -919,7 +1638,7 @@ int reduce_scatter(
         } else{
             start_move(
                 MOVE_STRIDE, MOVE_ON_RECV, MOVE_IMMEDIATE, 
-                compression & ~(OP0_COMPRESSED), RES_LOCAL, 0,
+                compression & ~(OP0_COMPRESSED), RES_LOCAL, func,
                 count, 
                 comm_offset, arcfg_offset, 
                 0, 0, dst_buf_addr, rel_stride, 0, 0,
@@ -927,13 +1646,142 @@ int reduce_scatter(
             ); 
         }
         curr_pos = (curr_pos + world.size - 1) % world.size;
-        //pop one result here to keep the result FIFO not full
+    }
+
+    //pop results of the preamble, the initial send and all steps
+    for(i=0; i<world.size+1; i++){
         err |= end_move();
     }
 
-    //pop final two results
-    err |= end_move();
-    err |= end_move();
+    return err;
+}
+
+//chunks of a ring direction are addressed directly rather than by strides,
+//since the moves of several directions or blocks are interleaved
+static inline unsigned int dir_count(ring_direction *d, unsigned int chunk){
+    return (chunk == world.size-1) ? d->tail_count : d->bulk_count;
+}
+
+static inline uint64_t dir_offset(ring_direction *d, unsigned int chunk, unsigned int elem_bytes){
+    return (uint64_t)chunk*d->bulk_count*elem_bytes;
+}
+
+//allreduce as a pipeline of ring allreduces over blocks of one segment per rank; each block
+//starts world.size-1 steps after the previous one, so that its reduce-scatter overlaps the
+//allgather of the previous block. A block goes through 2*world.size-1 stages: stage 0 sends
+//our chunk, stages up to world.size-1 receive and reduce (the last one keeps the result),
+//later stages receive into the destination, and stages world.size-1 to 2*world.size-3 send
+//from the destination. In every step, receives are issued in the order in which the previous
+//in ring sent in the previous step: first those of stages sending from the source, then the rest
+static int allreduce_pipelined(
+    unsigned int count,
+    unsigned int func,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int block_count
+){
+    unsigned int t, b, k, chunk, first, last, nmoves, i;
+    unsigned int elem_bytes = Xil_In32(arcfg_offset);
+    unsigned int nblocks = count / block_count;
+    unsigned int lag = world.size - 1;
+    unsigned int nstages = 2*world.size - 1;
+    unsigned int local_pos = ring_pos(world.local_rank);
+    uint64_t block_bytes;
+    ring_direction blk[3];
+    int err = NO_ERROR;
+
+    for(t=0; t < (nblocks-1)*lag + nstages; t++){
+        //blocks in flight, at most three since nstages <= 2*lag+1
+        first = (t >= nstages) ? (t - nstages + lag) / lag : 0;
+        last = min(nblocks-1, t / lag);
+        for(b=first; b<=last; b++){
+            //the last block takes the remainder
+            ring_direction *d = &blk[b-first];
+            unsigned int n = (b == nblocks-1) ? count - b*block_count : block_count;
+            d->next_in_ring = ring_rank(local_pos + 1);
+            d->prev_in_ring = ring_rank(local_pos + world.size - 1);
+            d->pos = local_pos;
+            d->bulk_count = n / world.size;
+            d->tail_count = n - d->bulk_count*(world.size-1);
+            block_bytes = (uint64_t)b*block_count*elem_bytes;
+            d->src_addr = src_buf_addr + block_bytes;
+            d->dst_addr = dst_buf_addr + block_bytes;
+        }
+
+        //stages reading the source
+        nmoves = 0;
+        for(b=first; b<=last; b++){
+            ring_direction *d = &blk[b-first];
+            k = t - b*lag;
+            if(k >= world.size) continue;
+            if(k == 0){
+                chunk = d->pos;
+                start_move(
+                    MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+                    compression, RES_REMOTE, 0,
+                    dir_count(d, chunk),
+                    comm_offset, arcfg_offset,
+                    d->src_addr + dir_offset(d, chunk, elem_bytes), 0, 0, 0, 0, 0,
+                    0, 0, d->next_in_ring, TAG_ANY
+                );
+            } else{
+                chunk = (d->pos + world.size - k) % world.size;
+                start_move(
+                    MOVE_IMMEDIATE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                    compression, (k < world.size-1) ? RES_REMOTE : RES_LOCAL, func,
+                    dir_count(d, chunk),
+                    comm_offset, arcfg_offset,
+                    d->src_addr + dir_offset(d, chunk, elem_bytes), 0, d->dst_addr + dir_offset(d, chunk, elem_bytes), 0, 0, 0,
+                    d->prev_in_ring, TAG_ANY, d->next_in_ring, TAG_ANY
+                );
+            }
+            nmoves++;
+        }
+        //stages receiving into the destination
+        for(b=first; b<=last; b++){
+            ring_direction *d = &blk[b-first];
+            k = t - b*lag;
+            if(k < world.size) continue;
+            chunk = (d->pos + 2*world.size - k) % world.size;
+            start_move(
+                MOVE_NONE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                compression, RES_LOCAL, 0,
+                dir_count(d, chunk),
+                comm_offset, arcfg_offset,
+                0, 0, d->dst_addr + dir_offset(d, chunk, elem_bytes), 0, 0, 0,
+                d->prev_in_ring, TAG_ANY, 0, 0
+            );
+            nmoves++;
+        }
+        //sends from the destination read what was just stored, see allgather()
+        for(i=0; i<nmoves; i++){
+            err |= end_move();
+        }
+
+        //stages sending from the destination
+        nmoves = 0;
+        for(b=first; b<=last; b++){
+            ring_direction *d = &blk[b-first];
+            k = t - b*lag;
+            if(k < world.size-1 || k > 2*world.size-3) continue;
+            chunk = (d->pos + 2*world.size - k) % world.size;
+            start_move(
+                MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+                compression, RES_REMOTE, 0,
+                dir_count(d, chunk),
+                comm_offset, arcfg_offset,
+                d->dst_addr + dir_offset(d, chunk, elem_bytes), 0, 0, 0, 0, 0,
+                0, 0, d->next_in_ring, TAG_ANY
+            );
+            nmoves++;
+        }
+        for(i=0; i<nmoves; i++){
+            err |= end_move();
+        }
+    }
 
     return err;
 }
@@ -949,7 +1797,7 @@ int allreduce(
     unsigned int compression,
     unsigned int stream
 ){
-    int i, curr_pos, curr_count, rel_stride, abs_stride, next_in_ring, prev_in_ring;
+    int i, local_pos, next_pos, curr_pos, curr_count, rel_stride, abs_stride, next_in_ring, prev_in_ring;
     int err = NO_ERROR;
 
     //compression is tricky for the relay: we've already received into the destination buffer 
@@ -958,11 +1806,26 @@ int allreduce(
     unsigned int relay_compression = (compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression;
     relay_compression &= ~(RES_COMPRESSED);
 
-    next_in_ring = (world.local_rank + 1) % world.size;
-    prev_in_ring = (world.local_rank + world.size - 1) % world.size;
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
+    next_pos = (local_pos + 1) % world.size;
+
+    //large buffers are pipelined in blocks of one segment per rank, which needs uncompressed
+    //buffers to address chunks directly
+    unsigned int block_count = world.size * (max_segment_size / Xil_In32(arcfg_offset));
+    if(world.size > 1 && block_count > 0 && count >= 2*block_count && (uint64_t)count*Xil_In32(arcfg_offset) > pipeline_threshold &&
+            !(compression & (OP0_COMPRESSED | RES_COMPRESSED))){
+        return allreduce_pipelined(count, func, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression, block_count);
+    }
+
+    if(use_sequencer && world.size > 1){
+        return sequence(SEQUENCE_ALLREDUCE, count, func, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression);
+    }
 
     //we need to break the input into world.size chunks of equal size
     //if count does not divide by world.size, the chunk with the largest index (tail) will be smaller
+    //chunks are indexed by ring position rather than rank, every rank ends up with all of them
     unsigned int bulk_count = (count + world.size -1) / world.size;//equivalent to ceil(count/world.size)
     unsigned int tail_count = count - bulk_count*(world.size-1);
 
@@ -982,14 +1845,14 @@ int allreduce(
     start_move(
         MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE, 
         compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
-        (world.local_rank == world.size-1) ? tail_count: bulk_count, 
+        (local_pos == world.size-1) ? tail_count: bulk_count, 
         comm_offset, arcfg_offset, 
-        0, 0, 0, bulk_count*world.local_rank, 0, 0,
+        0, 0, 0, bulk_count*local_pos, 0, 0,
         0, 0, next_in_ring, TAG_ANY
     );
 
     //receive and reduce+forward from all other members of the communicator
-    curr_pos = world.local_rank;
+    curr_pos = local_pos;
     for(i=0; i<world.size-1; i++){
         rel_stride = bulk_count*((curr_pos == 0) ? (world.size-1) : -1);
         curr_count = (curr_pos == 0) ? tail_count : bulk_count;
@@ -1010,10 +1873,10 @@ int allreduce(
         } else{
             start_move(
                 MOVE_STRIDE, MOVE_ON_RECV, MOVE_STRIDE, 
-                compression & ~(OP0_COMPRESSED), RES_LOCAL, 0,
+                compression & ~(OP0_COMPRESSED), RES_LOCAL, func,
                 curr_count, 
                 comm_offset, arcfg_offset, 
-                0, 0, 0, rel_stride, 0, bulk_count*next_in_ring,
+                0, 0, 0, rel_stride, 0, bulk_count*next_pos,
                 prev_in_ring, TAG_ANY, 0, 0
             ); 
         }
@@ -1040,9 +1903,9 @@ int allreduce(
     start_move(
         MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE, 
         compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
-        (next_in_ring == world.size-1) ? tail_count : bulk_count, 
+        (next_pos == world.size-1) ? tail_count : bulk_count, 
         comm_offset, arcfg_offset, 
-        0, 0, 0, bulk_count*next_in_ring, 0, 0,
+        0, 0, 0, bulk_count*next_pos, 0, 0,
         0, 0, next_in_ring, TAG_ANY
     );
 
@@ -1050,7 +1913,7 @@ int allreduce(
     err |= end_move();
 
     //receive and forward from all other members of the communicator
-    curr_pos = next_in_ring;
+    curr_pos = next_pos;
     for(i=0; i<world.size-1; i++){
         rel_stride = bulk_count*((curr_pos == 0) ? (world.size-1) : -1);
         curr_count = (curr_pos == 0) ? tail_count : bulk_count;
@@ -1097,6 +1960,524 @@ int allreduce(
     return err;
 }
 
+//allreduce with the first half of the buffer going around the ring forward and the second half
+//backward, so that both directions of every link carry data; moves of the two directions are
+//issued back to back and kept in flight together
+int allreduce_dual_ring(
+    unsigned int count,
+    unsigned int func,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int i, d, err = NO_ERROR;
+    unsigned int chunk, local_pos, elem_bytes, dir_total;
+    ring_direction dir[2];
+
+    //with two ranks the single ring already uses both directions; chunks of compressed
+    //buffers can't be addressed in elements, and every chunk of a half must be non-empty
+    if(world.size <= 2 || count < 2*world.size || (compression & (OP0_COMPRESSED | RES_COMPRESSED))){
+        return allreduce(count, func, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression, stream);
+    }
+
+    elem_bytes = Xil_In32(arcfg_offset);
+    local_pos = ring_pos(world.local_rank);
+
+    dir[0].next_in_ring = ring_rank(local_pos + 1);
+    dir[0].prev_in_ring = ring_rank(local_pos + world.size - 1);
+    dir[0].pos = local_pos;
+    dir[0].src_addr = src_buf_addr;
+    dir[0].dst_addr = dst_buf_addr;
+    //the reverse ring, numbered such that our next in it is our previous in the forward ring
+    dir[1].next_in_ring = dir[0].prev_in_ring;
+    dir[1].prev_in_ring = dir[0].next_in_ring;
+    dir[1].pos = world.size - 1 - local_pos;
+    dir[1].src_addr = src_buf_addr + (uint64_t)(count/2)*elem_bytes;
+    dir[1].dst_addr = dst_buf_addr + (uint64_t)(count/2)*elem_bytes;
+    for(d=0; d<2; d++){
+        dir_total = (d == 0) ? count/2 : count - count/2;
+        //round down, so the tail chunk is never empty
+        dir[d].bulk_count = dir_total / world.size;
+        dir[d].tail_count = dir_total - dir[d].bulk_count*(world.size-1);
+    }
+
+    //reduce-scatter: send our chunk both ways
+    for(d=0; d<2; d++){
+        start_move(
+            MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+            compression, RES_REMOTE, 0,
+            dir_count(&dir[d], dir[d].pos),
+            comm_offset, arcfg_offset,
+            dir[d].src_addr + dir_offset(&dir[d], dir[d].pos, elem_bytes), 0, 0, 0, 0, 0,
+            0, 0, dir[d].next_in_ring, TAG_ANY
+        );
+    }
+
+    //receive, reduce and forward the chunk one position further back in each ring,
+    //in the last step keep the result, which is the chunk of the next position
+    for(i=0; i<world.size-1; i++){
+        for(d=0; d<2; d++){
+            chunk = (dir[d].pos + 2*world.size - 1 - i) % world.size;
+            start_move(
+                MOVE_IMMEDIATE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                compression, (i < world.size-2) ? RES_REMOTE : RES_LOCAL, func,
+                dir_count(&dir[d], chunk),
+                comm_offset, arcfg_offset,
+                dir[d].src_addr + dir_offset(&dir[d], chunk, elem_bytes), 0, dir[d].dst_addr + dir_offset(&dir[d], chunk, elem_bytes), 0, 0, 0,
+                dir[d].prev_in_ring, TAG_ANY, dir[d].next_in_ring, TAG_ANY
+            );
+        }
+        //pop the moves of the previous step to keep the result FIFO not full
+        err |= end_move();
+        err |= end_move();
+    }
+    err |= end_move();
+    err |= end_move();
+
+    //allgather: send the chunk we hold both ways, then receive and relay the others
+    for(d=0; d<2; d++){
+        chunk = (dir[d].pos + 1) % world.size;
+        start_move(
+            MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+            compression, RES_REMOTE, 0,
+            dir_count(&dir[d], chunk),
+            comm_offset, arcfg_offset,
+            dir[d].dst_addr + dir_offset(&dir[d], chunk, elem_bytes), 0, 0, 0, 0, 0,
+            0, 0, dir[d].next_in_ring, TAG_ANY
+        );
+    }
+    err |= end_move();
+    err |= end_move();
+
+    for(i=0; i<world.size-1; i++){
+        for(d=0; d<2; d++){
+            chunk = (dir[d].pos + world.size - i) % world.size;
+            start_move(
+                MOVE_NONE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                compression, RES_LOCAL, 0,
+                dir_count(&dir[d], chunk),
+                comm_offset, arcfg_offset,
+                0, 0, dir[d].dst_addr + dir_offset(&dir[d], chunk, elem_bytes), 0, 0, 0,
+                dir[d].prev_in_ring, TAG_ANY, 0, 0
+            );
+        }
+        //the relay reads what was just received, see allgather()
+        err |= end_move();
+        err |= end_move();
+        if(i < world.size-2){
+            for(d=0; d<2; d++){
+                chunk = (dir[d].pos + world.size - i) % world.size;
+                start_move(
+                    MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+                    compression, RES_REMOTE, 0,
+                    dir_count(&dir[d], chunk),
+                    comm_offset, arcfg_offset,
+                    dir[d].dst_addr + dir_offset(&dir[d], chunk, elem_bytes), 0, 0, 0, 0, 0,
+                    0, 0, dir[d].next_in_ring, TAG_ANY
+                );
+            }
+            err |= end_move();
+            err |= end_move();
+        }
+    }
+
+    return err;
+}
+
+//VECTOR COLLECTIVES
+//per-rank counts and displacements are read from a table in exchange memory
+//ranks with a zero count are skipped consistently on all members of the communicator
+
+static inline unsigned int vcount(unsigned int vtable, unsigned int rank){
+    return Xil_In32(vtable + 4*(VTABLE_COUNTS_OFFSET + rank));
+}
+
+static inline int vdispl(unsigned int vtable, unsigned int rank){
+    return Xil_In32(vtable + 4*(VTABLE_DISPLS_OFFSET(world.size) + rank));
+}
+
+//root sends each rank its chunk, located at the rank's displacement in the source buffer
+//use MOVE_IMMEDIATE then MOVE_STRIDE in sequence
+int scatterv(
+    unsigned int src_rank,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int vtable,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int i, prev_displ = 0;
+    unsigned int curr_count, nmoves = 0;
+    int err = NO_ERROR;
+
+    //determine if we're sending or receiving
+    if(src_rank == world.local_rank){
+        //on the root we only care about ETH_COMPRESSED and OP0_COMPRESSED
+        //so replace RES_COMPRESSED with ETH_COMPRESSED
+        compression = compression | (compression >> 1);
+
+        //prime the address slot for the source, so we can subsequently stride against it
+        start_move(
+            MOVE_IMMEDIATE, MOVE_NONE, MOVE_NONE,
+            compression, RES_LOCAL, 0,
+            0,
+            0, arcfg_offset,
+            src_buf_addr, 0, 0, 0, 0, 0,
+            0, 0, 0, 0
+        );
+        nmoves++;
+
+        for(i=0; i < world.size; i++){
+            curr_count = vcount(vtable, i);
+            if(curr_count == 0) continue;
+            start_move(
+                MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE,
+                compression, (i==src_rank) ? RES_LOCAL : RES_REMOTE, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                0, 0, dst_buf_addr, vdispl(vtable, i)-prev_displ, 0, 0,
+                0, 0, i, TAG_ANY
+            );
+            prev_displ = vdispl(vtable, i);
+            nmoves++;
+        }
+        for(i=0; i < nmoves; i++){
+            err |= end_move();
+        }
+    } else{
+        //on non-root odes we only care about ETH_COMPRESSED and RES_COMPRESSED
+        //so replace OP0_COMPRESSED with the value of ETH_COMPRESSED
+        compression = compression | (compression >> 3);
+        curr_count = vcount(vtable, world.local_rank);
+        if(curr_count > 0){
+            err |= move(
+                MOVE_NONE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                compression, RES_LOCAL, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                0, 0, dst_buf_addr, 0, 0, 0,
+                src_rank, TAG_ANY, 0, 0
+            );
+        }
+    }
+
+    return err;
+}
+
+//ring gather with per-rank counts: non root relay data to the root, 
+//root places each chunk at the displacement of its originating rank
+int gatherv(
+    unsigned int root_rank,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int vtable,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int i, origin, prev_displ = 0;
+    unsigned int curr_count, local_pos, next_in_ring, prev_in_ring, number_of_shift, nmoves = 0;
+    int err = NO_ERROR;
+
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
+
+    if(root_rank == world.local_rank){
+        //initialize destination address in offload core
+        start_move(
+            MOVE_NONE, MOVE_NONE, MOVE_IMMEDIATE,
+            NO_COMPRESSION, RES_LOCAL, 0,
+            0,
+            comm_offset, arcfg_offset,
+            0, 0, dst_buf_addr, 0, 0, 0,
+            0, 0, 0, 0
+        );
+        nmoves++;
+
+        //copy our own data into place
+        curr_count = vcount(vtable, world.local_rank);
+        if(curr_count > 0){
+            start_move(
+                MOVE_IMMEDIATE, MOVE_NONE, MOVE_STRIDE,
+                NO_COMPRESSION, RES_LOCAL, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                src_buf_addr, 0, 0, 0, 0, vdispl(vtable, world.local_rank),
+                0, 0, 0, 0
+            );
+            prev_displ = vdispl(vtable, world.local_rank);
+            nmoves++;
+        }
+
+        //chunks arrive from the previous in ring, originating progressively further back in the ring
+        for(i=0; i<world.size-1; i++){
+            origin = ring_rank(local_pos + 2*world.size - 1 - i);
+            curr_count = vcount(vtable, origin);
+            if(curr_count == 0) continue;
+            start_move(
+                MOVE_NONE, MOVE_ON_RECV, MOVE_STRIDE,
+                NO_COMPRESSION, RES_LOCAL, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                0, 0, 0, 0, 0, vdispl(vtable, origin)-prev_displ,
+                prev_in_ring, TAG_ANY, 0, 0
+            );
+            prev_displ = vdispl(vtable, origin);
+            nmoves++;
+        }
+    } else{
+        //first send our own data
+        curr_count = vcount(vtable, world.local_rank);
+        if(curr_count > 0){
+            start_move(
+                MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+                NO_COMPRESSION, RES_REMOTE, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                src_buf_addr, 0, 0, 0, 0, 0,
+                0, 0, next_in_ring, TAG_ANY
+            );
+            nmoves++;
+        }
+        //next relay the chunks of the ranks between the root and us
+        number_of_shift = ((world.size+local_pos-ring_pos(root_rank))%world.size) - 1;
+        for(i=0; i<number_of_shift; i++){
+            origin = ring_rank(local_pos + 2*world.size - 1 - i);
+            curr_count = vcount(vtable, origin);
+            if(curr_count == 0) continue;
+            start_move(
+                MOVE_NONE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+                NO_COMPRESSION, RES_REMOTE, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                0, 0, 0, 0, 0, 0,
+                prev_in_ring, TAG_ANY, next_in_ring, TAG_ANY
+            );
+            nmoves++;
+        }
+    }
+    for(i=0; i<nmoves; i++){
+        err |= end_move();
+    }
+    return err;
+}
+
+//ring allgather with per-rank counts: receive a chunk, store it at the displacement
+//of its originating rank, then relay it to the next rank
+int allgatherv(
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int vtable,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int i, origin, prev_displ = 0;
+    unsigned int curr_count, local_pos, next_in_ring, prev_in_ring;
+    int err = NO_ERROR;
+
+    //see allgather() for the handling of compression on relays
+    unsigned int relay_compression = (compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression;
+    relay_compression &= ~(RES_COMPRESSED);
+
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
+
+    //prime the address slot for the destination, so we can subsequently stride against it
+    err |= move(
+        MOVE_NONE, MOVE_NONE, MOVE_IMMEDIATE,
+        compression, RES_LOCAL, 0,
+        0,
+        0, arcfg_offset,
+        0, 0, dst_buf_addr, 0, 0, 0,
+        0, 0, 0, 0
+    );
+
+    curr_count = vcount(vtable, world.local_rank);
+    if(curr_count > 0){
+        //copy our local data into the appropriate destination slot
+        start_move(
+            MOVE_IMMEDIATE, MOVE_NONE, MOVE_STRIDE,
+            compression, RES_LOCAL, 0,
+            curr_count,
+            0, arcfg_offset,
+            src_buf_addr, 0, 0, 0, 0, vdispl(vtable, world.local_rank),
+            0, 0, 0, 0
+        );
+        prev_displ = vdispl(vtable, world.local_rank);
+        //send to next in ring
+        start_move(
+            MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE,
+            compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
+            curr_count,
+            comm_offset, arcfg_offset,
+            src_buf_addr, 0, 0, 0, 0, 0,
+            0, 0, next_in_ring, TAG_ANY
+        );
+        err |= end_move();
+        err |= end_move();
+    }
+
+    //receive and forward from all other members of the communicator
+    for(i=0; i<world.size-1; i++){
+        origin = ring_rank(local_pos + 2*world.size - 1 - i);
+        curr_count = vcount(vtable, origin);
+        if(curr_count == 0) continue;
+
+        //blocking move to avoid a race condition with the relay below, see allgather()
+        err |= move(
+            MOVE_NONE, MOVE_ON_RECV, MOVE_STRIDE,
+            compression & ~(OP0_COMPRESSED), RES_LOCAL, 0,
+            curr_count,
+            comm_offset, arcfg_offset,
+            0, 0, 0, 0, 0, vdispl(vtable, origin)-prev_displ,
+            prev_in_ring, TAG_ANY, 0, 0
+        );
+        prev_displ = vdispl(vtable, origin);
+
+        if(i < world.size-2){ //if not the last data, relay to the next in ring
+            //first prime the address
+            start_move(
+                MOVE_NONE, MOVE_IMMEDIATE, MOVE_NONE,
+                relay_compression, RES_REMOTE, 0,
+                0,
+                comm_offset, arcfg_offset,
+                0, dst_buf_addr, 0, 0, 0, 0,
+                0, 0, next_in_ring, TAG_ANY
+            );
+            //send
+            start_move(
+                MOVE_NONE, MOVE_STRIDE, MOVE_IMMEDIATE,
+                relay_compression, RES_REMOTE, 0,
+                curr_count,
+                comm_offset, arcfg_offset,
+                0, 0, 0, 0, vdispl(vtable, origin), 0,
+                0, 0, next_in_ring, TAG_ANY
+            );
+            err |= end_move();
+            err |= end_move();
+        }
+    }
+
+    return err;
+}
+
+//ring reduce-scatter with per-rank counts: at step s, each rank forwards the partial 
+//reduction of the chunk 1+s positions back in the ring, such that each rank ends up with its own chunk
+//fully reduced, stored at offset 0 of the destination buffer
+int reduce_scatterv(
+    unsigned int func,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int vtable,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int i, chunk, prev_displ = 0;
+    unsigned int curr_count, local_pos, next_in_ring, prev_in_ring, nmoves = 0;
+    int err = NO_ERROR;
+
+    local_pos = ring_pos(world.local_rank);
+    next_in_ring = ring_rank(local_pos + 1);
+    prev_in_ring = ring_rank(local_pos + world.size - 1);
+
+    //prime the address slot for the source, so we can subsequently stride against it
+    start_move(
+        MOVE_IMMEDIATE, MOVE_NONE, MOVE_NONE,
+        compression, RES_LOCAL, 0,
+        0,
+        0, arcfg_offset,
+        src_buf_addr, 0, 0, 0, 0, 0,
+        0, 0, 0, 0
+    );
+    nmoves++;
+
+    //send the chunk of the previous in ring, it starts its reduction there
+    curr_count = vcount(vtable, prev_in_ring);
+    if(curr_count > 0){
+        start_move(
+            MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE,
+            compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
+            curr_count,
+            comm_offset, arcfg_offset,
+            0, 0, 0, vdispl(vtable, prev_in_ring), 0, 0,
+            0, 0, next_in_ring, TAG_ANY
+        );
+        prev_displ = vdispl(vtable, prev_in_ring);
+        nmoves++;
+    }
+
+    //receive and reduce+forward from all other members of the communicator
+    for(i=0; i<world.size-1; i++){
+        chunk = ring_rank(local_pos + 2*world.size - 2 - i);
+        curr_count = vcount(vtable, chunk);
+        if(curr_count == 0) continue;
+        //simultaneous receive, reduce and send for the received chunk,
+        //unless it is the last step, in which case we don't send, but save locally
+        start_move(
+            MOVE_STRIDE, MOVE_ON_RECV, MOVE_IMMEDIATE,
+            compression & ~(OP0_COMPRESSED), (i < world.size-2) ? RES_REMOTE : RES_LOCAL, func,
+            curr_count,
+            comm_offset, arcfg_offset,
+            0, 0, dst_buf_addr, vdispl(vtable, chunk)-prev_displ, 0, 0,
+            prev_in_ring, TAG_ANY, next_in_ring, TAG_ANY
+        );
+        prev_displ = vdispl(vtable, chunk);
+        nmoves++;
+        //pop one result here to keep the result FIFO not full
+        if(nmoves > 2){
+            err |= end_move();
+            nmoves--;
+        }
+    }
+
+    for(i=0; i<nmoves; i++){
+        err |= end_move();
+    }
+
+    return err;
+}
+
+//SPARSE COLLECTIVES
+
+//allreduce of sorted (index, value) pair buffers, count is the capacity in pairs
+//the arithmetic plugin merges two operands into one buffer of the same capacity,
+//so partial results are only valid if an operand is never split across segments:
+//merge-reduce along the ring into rank 0, then broadcast the merged buffer
+int sparse_allreduce(
+    unsigned int count,
+    unsigned int func,
+    uint64_t src_buf_addr,
+    uint64_t dst_buf_addr,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int compression,
+    unsigned int stream
+){
+    int err = NO_ERROR;
+
+    if((uint64_t)count*Xil_In32(arcfg_offset) > max_segment_size || count > SPARSE_MAX_PAIRS){
+        return DMA_SIZE_ERROR;
+    }
+    if(world.size == 1){
+        return copy(count, src_buf_addr, dst_buf_addr, arcfg_offset, compression, stream & OP0_STREAM);
+    }
+    err |= reduce(count, func, 0, src_buf_addr, dst_buf_addr, comm_offset, arcfg_offset, compression, stream & OP0_STREAM);
+    //the root holds the merged result in memory, results are never streamed
+    err |= broadcast(count, 0, dst_buf_addr, comm_offset, arcfg_offset, compression, NO_STREAM);
+    return err;
+}
 
 //startup and main
 
@@ -1119,6 +2500,8 @@ void init(void) {
     SET(GPIO_DATA_REG, GPIO_SWRST_MASK);
     //enable access from host to exchange memory by removing reset of interface
     SET(GPIO_DATA_REG, GPIO_READY_MASK);
+    //the mover is out of reset with empty queues, learn their capacity
+    init_move_credits();
     //poll CFGRDY until it is set (by the driver, following configuration)
     volatile bool rdy = false;
     do{
@@ -1142,9 +2525,27 @@ static inline void wait_for_call(void) {
     do {
         invalid = 0;
         invalid += tngetd(CMD_CALL);
+        //serve one-sided accesses to our windows in the meantime
+        if(invalid) service_rma();
     } while (invalid);
 }
 
+//check that the reduction function requested by a call is provided by its arithmetic config
+static inline bool arith_func_supported(unsigned int scenario, unsigned int function, unsigned int arcfg_offset){
+    switch(scenario){
+        case ACCL_COMBINE:
+        case ACCL_REDUCE:
+        case ACCL_ALLREDUCE:
+        case ACCL_ALLREDUCE_DUAL_RING:
+        case ACCL_REDUCE_SCATTER:
+        case ACCL_REDUCE_SCATTERV:
+        case ACCL_SPARSE_ALLREDUCE:
+            return function < ((datapath_arith_config*)(cfgmem+arcfg_offset/4))->arith_nfunctions;
+        default:
+            return true;
+    }
+}
+
 //signal finish to the host and write ret value in exchange mem
 void finalize_call(unsigned int retval) {
     Xil_Out32(RETVAL_OFFSET, retval);
@@ -1196,12 +2597,13 @@ void run() {
         //initialize arithmetic/compression config and communicator
         //NOTE: these are global because they're used in a lot of places but don't change during a call
         //TODO: determine if they can remain global in hierarchical collectives
-        if(!comm_cached || (comm != comm_cache_adr)){
-            world = find_comm(comm);
-            comm_cached = true;
-            comm_cache_adr = comm;
-        }
+        world = lookup_comm(comm, false);
         
+        if(!arith_func_supported(scenario, function, datapath_cfg)){
+            finalize_call(ARITH_ERROR);
+            continue;
+        }
+
         switch (scenario)
         {
             case ACCL_COPY:
@@ -1211,10 +2613,20 @@ void run() {
                 retval = combine(count, function, op0_addr, op1_addr, res_addr, datapath_cfg, compression_flags, stream_flags);
                 break;
             case ACCL_SEND:
-                retval = send(root_src_dst, count, op0_addr, comm, datapath_cfg, msg_tag, compression_flags, stream_flags);
+                if(rndzv_eligible(count, datapath_cfg, compression_flags, stream_flags)){
+                    retval = rndzv_send(root_src_dst, count, op0_addr, comm, datapath_cfg, msg_tag);
+                } else{
+                    retval = send(root_src_dst, count, op0_addr, comm, datapath_cfg, msg_tag, compression_flags, stream_flags);
+                }
                 break;
             case ACCL_RECV:
-                retval = recv(root_src_dst, count, res_addr, comm, datapath_cfg, msg_tag, compression_flags);
+                if(function == RECV_UP_TO){
+                    retval = recv_up_to(root_src_dst, count, res_addr, comm, datapath_cfg, msg_tag, compression_flags, op1_addrl);
+                } else if(rndzv_eligible(count, datapath_cfg, compression_flags, NO_STREAM)){
+                    retval = rndzv_recv(root_src_dst, count, res_addr, comm, datapath_cfg, msg_tag, compression_flags);
+                } else{
+                    retval = recv(root_src_dst, count, res_addr, comm, datapath_cfg, msg_tag, compression_flags);
+                }
                 break;
             case ACCL_BCAST:
                 retval = broadcast(count, root_src_dst, op0_addr, comm, datapath_cfg, compression_flags, stream_flags);
@@ -1237,6 +2649,36 @@ void run() {
             case ACCL_ALLREDUCE:
                 retval = allreduce(count, function, op0_addr, res_addr, comm, datapath_cfg, compression_flags, stream_flags);
                 break;
+            case ACCL_ALLREDUCE_DUAL_RING:
+                retval = allreduce_dual_ring(count, function, op0_addr, res_addr, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_SCATTERV:
+                retval = scatterv(root_src_dst, op0_addr, res_addr, op1_addrl, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_GATHERV:
+                retval = gatherv(root_src_dst, op0_addr, res_addr, op1_addrl, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_ALLGATHERV:
+                retval = allgatherv(op0_addr, res_addr, op1_addrl, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_REDUCE_SCATTERV:
+                retval = reduce_scatterv(function, op0_addr, res_addr, op1_addrl, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_SPARSE_ALLREDUCE:
+                retval = sparse_allreduce(count, function, op0_addr, res_addr, comm, datapath_cfg, compression_flags, stream_flags);
+                break;
+            case ACCL_PROBE:
+                retval = probe(root_src_dst, msg_tag, function, op1_addrl);
+                break;
+            case ACCL_PUT:
+                retval = rma_put(root_src_dst, count, op0_addr, res_addr, op1_addrl);
+                break;
+            case ACCL_GET:
+                retval = rma_get(root_src_dst, count, res_addr, op0_addr, op1_addrl);
+                break;
+            case ACCL_FLUSH:
+                retval = rma_flush(root_src_dst, op1_addrl);
+                break;
             case ACCL_CONFIG:
                 retval = 0;
                 switch (function)
@@ -1262,6 +2704,8 @@ void run() {
                         break;
                     case HOUSEKEEP_OPEN_CON:
                         if(use_tcp == 1){
+                            //the host may have rewritten the communicator since it was cached
+                            world = lookup_comm(comm, true);
                             retval = openCon();
                         } else{
                             retval = OPEN_CON_NOT_SUCCEEDED;
@@ -1277,6 +2721,18 @@ void run() {
                             retval = NO_ERROR;
                         }
                         break;
+                    case HOUSEKEEP_SET_RNDZV_THRESHOLD:
+                        rndzv_threshold = count;
+                        break;
+                    case HOUSEKEEP_SET_PIPELINE_THRESHOLD:
+                        pipeline_threshold = count;
+                        break;
+                    case HOUSEKEEP_SET_SEQUENCER:
+                        use_sequencer = count;
+                        break;
+                    case HOUSEKEEP_SET_MULTICAST:
+                        use_multicast = count;
+                        break;
                     default:
                         break;
                 }
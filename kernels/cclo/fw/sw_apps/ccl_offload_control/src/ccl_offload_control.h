@@ -47,13 +47,26 @@
 
 
 //PACKT CONST
+#ifndef MAX_PACKETSIZE
 #define MAX_PACKETSIZE 1536
+#endif
 #define MAX_SEG_SIZE 1048576
 //DMA CONST 
 #define DMA_MAX_BTT              ((1<<23)/64*64)
 #define DMA_MAX_TRANSACTIONS     20
 #define DMA_TRANSACTION_SIZE     4194304 //info: can correspond to MAX_BTT
 #define MAX_DMA_TAGS 16
+//CACHE CONST
+//number of communicators and arithmetic configs whose parsed form is kept between calls/moves
+#define COMM_CACHE_SIZE          4
+#define ARCFG_CACHE_SIZE         4
+//CONNECTION SETUP CONST
+//the (ip, port) to rank lookup must hold at least twice the communicator size
+#define CON_LOOKUP_LOG           10
+#define CON_LOOKUP_SIZE          (1<<CON_LOOKUP_LOG)
+#define CON_LOOKUP_EMPTY         0xFFFF
+#define OPEN_CON_RETRIES         4
+#define OPEN_CON_BACKOFF         1024 //polling iterations before the first retry, doubled on every retry
 
 //******************************
 //**  XCC Operations          **
@@ -73,6 +86,23 @@
 #define ACCL_ALLGATHER      9
 #define ACCL_ALLREDUCE      10
 #define ACCL_REDUCE_SCATTER 11
+//Vector collectives (per-rank counts and displacements)
+#define ACCL_SCATTERV       13
+#define ACCL_GATHERV        14
+#define ACCL_ALLGATHERV     15
+#define ACCL_REDUCE_SCATTERV 16
+//Sparse (index, value) collectives
+#define ACCL_SPARSE_ALLREDUCE 17
+//pair capacity of the sparse merge plugin, see kernels/plugins/sparse_reduce
+#define SPARSE_MAX_PAIRS    8192
+//Point-to-point message inspection
+#define ACCL_PROBE          18
+//One-sided access to registered memory windows
+#define ACCL_PUT            19
+#define ACCL_GET            20
+#define ACCL_FLUSH          21
+//Allreduce over both directions of the ring
+#define ACCL_ALLREDUCE_DUAL_RING 22
 
 //ACCL_CONFIG SUBFUNCTIONS
 #define HOUSEKEEP_SWRST                0
@@ -82,6 +112,18 @@
 #define HOUSEKEEP_OPEN_CON             4
 #define HOUSEKEEP_SET_STACK_TYPE       5
 #define HOUSEKEEP_SET_MAX_SEGMENT_SIZE 6
+#define HOUSEKEEP_SET_RNDZV_THRESHOLD  7
+#define HOUSEKEEP_SET_PIPELINE_THRESHOLD 8
+#define HOUSEKEEP_SET_SEQUENCER        9
+#define HOUSEKEEP_SET_MULTICAST        10
+
+//ACCL_PROBE SUBFUNCTIONS
+#define PROBE_BLOCKING                 0
+#define PROBE_NONBLOCKING              1
+
+//ACCL_RECV SUBFUNCTIONS
+#define RECV_EXACT                     0
+#define RECV_UP_TO                     1
 
 //AXI MMAP address
 #define CFGRDY_OFFSET     0x1FF4
@@ -149,6 +191,10 @@
 #define KRNL_STS_COUNT_ERROR                          (1<<24)
 #define SEGMENTER_EXPECTED_BTT_ERROR                  (1<<25)
 #define DMA_TAG_MISMATCH_ERROR                        (1<<26)
+#define RECEIVE_TRUNCATION_ERROR                      (1<<27)
+#define RMA_WINDOW_ERROR                              (1<<28)
+//flagged in the result by the sparse merge plugin, reported by the driver
+#define SPARSE_OVERFLOW_ERROR                         (1<<29)
 
 //define opcodes for move offload
 //each address parameter (op0, op1, res) should carry one of these opcodes
@@ -160,6 +206,49 @@
 #define MOVE_REPEAT    5 //use address of previous move - available on both ops and res
 #define MOVE_STRIDE    6 //resolve address by adding an immediate stride count (replacing address) to address of previous move - available on both ops and res
 
+//flag in the opcode word of a move asking the dma mover how many moves it can queue;
+//the query is followed by a zero count and arith config offset and answered in order on the
+//move status stream with the credit count in place of an error code
+#define MOVE_CREDIT_QUERY (1<<21)
+//results of moves retired early for lack of credits, held until end_move asks for them
+#define MOVE_BACKLOG_SIZE 64
+
+//flag in the opcode word marking a collective descriptor for the collective sequencer,
+//which expands it into the moves of a ring collective and answers with their merged result;
+//the collective is in place of op0_opcode, followed by count, arith config offset,
+//communicator offset, ring position of the local rank, source and destination address
+#define MOVE_SEQUENCE (1<<22)
+#define SEQUENCE_DESCRIPTOR_WORDS 9
+#define SEQUENCE_REDUCE_SCATTER   1
+#define SEQUENCE_ALLGATHER        2
+#define SEQUENCE_ALLREDUCE        3
+
+//compact move encoding, flagged in the opcode word; arith config and communicator offsets are not
+//sent but taken from the last MOVE_CONTEXT instruction (opcode word, arith config offset and
+//communicator offset, without result). A compact move is the opcode word, count, immediate addresses,
+//strides as signed 16-bit counts packed two per word in op0, op1, res order, one word with the
+//source rank in the low and destination rank in the high half if receiving or sending, then
+//the tags unless MOVE_TAG_ANY is set. Compact moves are always eager
+#define MOVE_COMPACT (1<<23)
+#define MOVE_CONTEXT (1<<24)
+#define MOVE_TAG_ANY (1<<25)
+#define MOVE_CONTEXT_WORDS 3
+
+//flag in the opcode word of a move (full or compact) which the dma mover repeats; the move is followed
+//by a loop word with the number of iterations in bits 15:0, the op0, op1 and res opcodes of the
+//iterations after the first in bits 18:16, 21:19 and 24:22 and the destination rank increment per
+//iteration in bits 31:25, then the stride of the operands which use MOVE_STRIDE in those iterations.
+//All iterations are answered with one merged result
+#define MOVE_LOOP (1<<26)
+#define MOVE_LOOP_WORDS 2
+
+//flag in the opcode word of a remote MOVE_LOOP sending the same data to consecutive ranks (wrapping
+//around the communicator); the first iteration is read from memory and recorded by the fan-out block
+//in front of the packetizer, the other iterations replay it. The message may not exceed MULTICAST_MAX_BYTES,
+//which must match FANOUT_BUFFER_WORDS of the fan-out block
+#define MOVE_MULTICAST (1<<27)
+#define MULTICAST_MAX_BYTES (4096*64)
+
 //define compression flags; these are one-hot, one bit per parameter
 //ETH_COMPRESSED is a meta-flag, it's passed in the call to the CCLO,
 //but it does not go down into the move operation, but instead 
@@ -173,6 +262,26 @@
 #define RES_COMPRESSED (1<<2)
 #define ETH_COMPRESSED (1<<3)
 
+//message types, carried in the eth header and in the rx buffer descriptor
+//eager messages and RTS take a sequence number and are received in order through the rx buffers
+//CTS and FIN are out of band: they land in rx buffers but are not offered to the rx buffer seek,
+//firmware finds and releases them; rendezvous payload is written directly to the posted buffer
+//the type is passed to the dma mover in the move opcode, non-eager types are followed by
+//a 64-bit argument: total message bytes for RTS, posted buffer address for CTS and payload
+//RMA messages are all out of band: a put is rendezvous payload written into the target window,
+//a get request carries the element count and window byte offset (count in the upper word)
+//and is answered with response segments through the rx buffers, each carrying its window offset;
+//flush requests are acknowledged once all preceding puts from the origin have landed
+#define MSG_EAGER          0
+#define MSG_RNDZV_RTS      1
+#define MSG_RNDZV_CTS      2
+#define MSG_RNDZV_DATA     3
+#define MSG_RNDZV_FIN      4
+#define MSG_RMA_GET        5
+#define MSG_RMA_GET_RESP   6
+#define MSG_RMA_FLUSH      7
+#define MSG_RMA_FLUSH_ACK  8
+
 //define if result is stored locally or sent to remote node
 #define RES_LOCAL  0
 #define RES_REMOTE 1
@@ -248,6 +357,10 @@ typedef struct {
     unsigned int rx_len;
     unsigned int rx_src;
     unsigned int sequence_number;
+    unsigned int msg_count;
+    unsigned int msg_type;
+    unsigned int rndzv_addrl;
+    unsigned int rndzv_addrh;
 } rx_buffer;
 
 #define STATUS_OFFSET           0
@@ -258,8 +371,12 @@ typedef struct {
 #define RX_LEN_OFFSET           5
 #define RX_SRC_OFFSET           6
 #define SEQUENCE_NUMBER_OFFSET  7   
-#define SPARE_BUFFER_SIZE       32
-#define SPARE_BUFFER_FIELDS     8       
+#define MSG_COUNT_OFFSET        8
+#define MSG_TYPE_OFFSET         9
+#define RNDZV_ADDRL_OFFSET      10
+#define RNDZV_ADDRH_OFFSET      11
+#define SPARE_BUFFER_SIZE       48
+#define SPARE_BUFFER_FIELDS     12       
 
 #define STATUS_IDLE     0x00
 #define STATUS_ENQUEUED 0x01
@@ -281,13 +398,32 @@ typedef struct {
 typedef struct {
     unsigned int size;
     unsigned int local_rank;
+    unsigned int id;
     comm_rank* ranks;
+    unsigned int* ring;
 } communicator;
 
+//one direction of a dual-ring allreduce or one block of a pipelined allreduce:
+//a ring allreduce of part of the buffer, with its own neighbours and chunking
+typedef struct {
+    unsigned int next_in_ring;
+    unsigned int prev_in_ring;
+    unsigned int pos;
+    unsigned int bulk_count;
+    unsigned int tail_count;
+    uint64_t src_addr;
+    uint64_t dst_addr;
+} ring_direction;
+
 //COMMUNICATOR OFFSETS
 #define COMM_SIZE_OFFSET                 0
 #define COMM_LOCAL_RANK_OFFSET           1
 #define COMM_RANKS_OFFSET                2
+//the local rank word holds the rank in its lower half and the communicator id in its upper half;
+//it is sent as the message source, so communicators sharing sessions keep their messages apart
+#define COMM_RANK_MASK                   0xFFFF
+#define COMM_ID_SHIFT                    16
+#define MSG_SRC_RANK(src)                ((src) & COMM_RANK_MASK)
 //RANK OFFSET
 #define RANK_IP_OFFSET                   0
 #define RANK_PORT_OFFSET                 1
@@ -296,7 +432,57 @@ typedef struct {
 #define RANK_SESSION_OFFSET              4
 #define RANK_SEGLEN_OFFSET               5
 #define RANK_SIZE                        6
-
+//the ring order table follows the ranks, it holds the rank at each position of the ring
+//traversed by ring collectives, so that rings can follow the physical topology
+#define COMM_RING_OFFSET(size)           (COMM_RANKS_OFFSET + (size)*RANK_SIZE)
+//session of a rank without an open connection
+#define SESSION_INVALID                  0xFFFFFFFF
+
+//VECTOR COLLECTIVE TABLE
+//resides in exchange memory, its offset is passed to the CCLO in place of op1_addr
+//holds size counts followed by size displacements, both expressed in elements
+#define VTABLE_COUNTS_OFFSET             0
+#define VTABLE_DISPLS_OFFSET(size)       (size)
+
+
+//PROBE STATUS
+//resides in exchange memory, its offset is passed to the CCLO in place of op1_addr
+//the flag is set if a message matched, in which case source, tag and byte count describe it
+//up-to receives use the same layout, with the flag set once received
+#define PROBE_FLAG_OFFSET                0
+#define PROBE_SRC_OFFSET                 1
+#define PROBE_TAG_OFFSET                 2
+#define PROBE_COUNT_OFFSET               3
+
+//DIRECT WRITE GRANTS
+//reside at a fixed place in exchange memory, below the config ready flag; rendezvous payload
+//is written directly to memory only within one of these ranges, any other is received into a
+//RX buffer and discarded. An entry holds base address and size in bytes, size 0 if unused.
+//The first entry is the posted buffer of the rendezvous receive in progress, set by the firmware,
+//the others are the local ranges of RMA windows, set by the driver, along with the window handle;
+//they are the table of local windows against which the handles in RMA requests are checked
+#define DIRECT_GRANT_OFFSET              0x1F70
+#define DIRECT_GRANT_COUNT               8
+#define DIRECT_GRANT_FIELDS              4
+#define DIRECT_GRANT_BASEL_OFFSET        0
+#define DIRECT_GRANT_BASEH_OFFSET        1
+#define DIRECT_GRANT_SIZE_OFFSET         2
+#define DIRECT_GRANT_WIN_OFFSET          3
+#define DIRECT_GRANT_RNDZV               0
+
+//RMA WINDOW
+//resides in exchange memory, its offset is the local window handle, passed to the CCLO in place of op1_addr
+//holds the key, the arithmetic config of the window data type and the communicator, followed by
+//one entry per rank with the window base address, its size in bytes and that rank's handle for it
+#define WIN_KEY_OFFSET                   0
+#define WIN_ARCFG_OFFSET                 1
+#define WIN_COMM_OFFSET                  2
+#define WIN_RANKS_OFFSET                 3
+#define WIN_BASEL_OFFSET                 0
+#define WIN_BASEH_OFFSET                 1
+#define WIN_SIZE_OFFSET                  2
+#define WIN_HANDLE_OFFSET                3
+#define WIN_RANK_SIZE                    4
 
 //structure defining arithmetic config parameters
 //TODO: make unsigned char to save on space
@@ -315,6 +501,7 @@ typedef struct {
 
 //Tag definitions
 #define TAG_ANY 0xFFFFFFFF
+#define SRC_ANY 0xFFFFFFFF
 
 //define exception handling for simulation
 #ifdef MB_FW_EMULATION
@@ -0,0 +1,401 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "collective_sequencer.h"
+
+unsigned int sequence_moves(unsigned int op, unsigned int size){
+#pragma HLS INLINE
+    //reduce-scatter: prime, send and one step per other rank
+    unsigned int rs = size + 1;
+    //allgather: prime, copy and send, one receive per other rank, each but the last relayed in two moves
+    unsigned int ag = 3 + (size - 1) + 2*(size - 2);
+    switch(op){
+        case SEQUENCE_REDUCE_SCATTER:
+            return rs;
+        case SEQUENCE_ALLGATHER:
+            return ag;
+        default:
+            //the allgather phase of an allreduce does not copy the local chunk
+            return rs + ag - 1;
+    }
+}
+
+unsigned int move_words(ap_uint<32> opcode){
+#pragma HLS INLINE
+    if(opcode & MOVE_SEQUENCE) return SEQUENCE_DESCRIPTOR_WORDS;
+    if(opcode & MOVE_CONTEXT) return MOVE_CONTEXT_WORDS;
+    ap_uint<3> op0_opcode = opcode(2,0);
+    ap_uint<3> op1_opcode = opcode(5,3);
+    ap_uint<3> res_opcode = opcode(8,6);
+    bool res_is_remote = (opcode(9,9) == RES_REMOTE);
+    ap_uint<4> msg_type = opcode(20,17);
+    //loop word and stride
+    unsigned int n = (opcode & MOVE_LOOP) ? MOVE_LOOP_WORDS : 0;
+    if(opcode & MOVE_COMPACT){
+        //opcode and count, strides two per word, both ranks in one word
+        unsigned int nstrides = (op0_opcode == MOVE_STRIDE) + (op1_opcode == MOVE_STRIDE) + (res_opcode == MOVE_STRIDE);
+        n += 2 + (nstrides + 1)/2;
+        if(op0_opcode == MOVE_IMMEDIATE) n += 2;
+        if(op1_opcode == MOVE_IMMEDIATE) n += 2;
+        if(res_opcode == MOVE_IMMEDIATE) n += 2;
+        if(res_is_remote || op1_opcode == MOVE_ON_RECV) n += 1;
+        if(!(opcode & MOVE_TAG_ANY)){
+            if(op1_opcode == MOVE_ON_RECV) n += 1;
+            if(res_is_remote || res_opcode == MOVE_STREAM) n += 1;
+        }
+        return n;
+    }
+    //opcode, count and arith config offset
+    n += 3;
+    if(op0_opcode == MOVE_IMMEDIATE) n += 2;
+    if(op0_opcode == MOVE_STRIDE) n += 1;
+    if(op1_opcode == MOVE_IMMEDIATE || op1_opcode == MOVE_ON_RECV) n += 2;
+    if(op1_opcode == MOVE_STRIDE) n += 1;
+    if(res_opcode == MOVE_IMMEDIATE) n += 2;
+    if(res_opcode == MOVE_STRIDE) n += 1;
+    if(res_is_remote || res_opcode == MOVE_STREAM) n += 1;
+    if(res_is_remote || op1_opcode == MOVE_ON_RECV) n += 1;
+    if(res_is_remote) n += 1;
+    if(res_is_remote && msg_type != MSG_EAGER) n += 2;
+    return n;
+}
+
+//encode a move the way the firmware start_move does
+void serialize_move(
+    seq_move &m,
+    unsigned int comm_offset,
+    unsigned int arcfg_offset,
+    unsigned int *words,
+    unsigned int &nwords
+){
+#pragma HLS INLINE
+    unsigned int n = 0;
+    ap_uint<32> opcode = 0;
+    opcode(2,0) = m.op0_opcode;
+    opcode(5,3) = m.op1_opcode;
+    opcode(8,6) = m.res_opcode;
+    opcode(9,9) = m.res_is_remote ? RES_REMOTE : RES_LOCAL;
+    opcode(12,10) = m.compression;
+    opcode(16,13) = m.func_id;
+    words[n++] = opcode;
+    words[n++] = m.count;
+    words[n++] = arcfg_offset;
+    if(m.op0_opcode == MOVE_IMMEDIATE){
+        words[n++] = m.op0_addr(31,0);
+        words[n++] = m.op0_addr(63,32);
+    } else if(m.op0_opcode == MOVE_STRIDE){
+        words[n++] = m.op0_stride;
+    }
+    if(m.op1_opcode == MOVE_IMMEDIATE){
+        words[n++] = m.op1_addr(31,0);
+        words[n++] = m.op1_addr(63,32);
+    } else if(m.op1_opcode == MOVE_ON_RECV){
+        words[n++] = m.rx_src;
+        words[n++] = TAG_ANY;
+    } else if(m.op1_opcode == MOVE_STRIDE){
+        words[n++] = m.op1_stride;
+    }
+    if(m.res_opcode == MOVE_IMMEDIATE){
+        words[n++] = m.res_addr(31,0);
+        words[n++] = m.res_addr(63,32);
+    } else if(m.res_opcode == MOVE_STRIDE){
+        words[n++] = m.res_stride;
+    }
+    if(m.res_is_remote){
+        words[n++] = TAG_ANY;
+    }
+    if(m.res_is_remote || m.op1_opcode == MOVE_ON_RECV){
+        words[n++] = comm_offset;
+    }
+    if(m.res_is_remote){
+        words[n++] = m.dst_rank;
+    }
+    nwords = n;
+}
+
+//expands collective descriptors from the processor into the moves the firmware would
+//issue for the same ring collective, one instruction word per cycle towards the dma mover;
+//other moves pass through in order. Results of the moves of a collective are merged
+//into a single result for the processor. Where the firmware would wait for a move
+//to complete before relaying its data, the sequencer waits for all issued moves to retire
+void collective_sequencer(
+    unsigned int * exchange_mem,
+    STREAM<ap_axiu<32,0,0,0> > &cmd_in,
+    STREAM<ap_axiu<32,0,0,0> > &sts_out,
+    STREAM<ap_axiu<32,0,0,0> > &cmd_out,
+    STREAM<ap_axiu<32,0,0,0> > &sts_in
+){
+#pragma HLS INTERFACE axis port=cmd_in
+#pragma HLS INTERFACE axis port=sts_out
+#pragma HLS INTERFACE axis port=cmd_out
+#pragma HLS INTERFACE axis port=sts_in
+#pragma HLS INTERFACE m_axi port=exchange_mem offset=off num_read_outstanding=4 num_write_outstanding=4 bundle=mem
+#pragma HLS INTERFACE ap_ctrl_none port=return
+#pragma HLS PIPELINE II=1 style=flp
+
+    //number of moves merged into each result owed to the processor, oldest first
+    static unsigned int tickets[SEQ_TICKETS];
+    static unsigned int ticket_head = 0;
+    static unsigned int ticket_count = 0;
+    static unsigned int ticket_retired = 0;
+    static unsigned int ticket_err = NO_ERROR;
+    //moves issued to and retired by the dma mover
+    static unsigned int issued = 0;
+    static unsigned int retired = 0;
+    //move being emitted, generated or passing through
+    static unsigned int words[SEQ_MAX_MOVE_WORDS];
+#pragma HLS ARRAY_PARTITION variable=words complete
+    static unsigned int nwords = 0;
+    static unsigned int word_idx = 0;
+    static unsigned int pass_words = 0;
+    //context instructions pass through without a result
+    static bool pass_result = true;
+    //collective being generated
+    static seq_phase phase = SEQ_IDLE;
+    static unsigned int op, count, bulk_count, tail_count, func, compression, relay_compression;
+    static unsigned int arcfg_offset, comm_offset, ring_offset;
+    static unsigned int size, local_rank, local_pos, next_pos, next_in_ring, prev_in_ring;
+    static unsigned int step, curr_pos, curr_chunk;
+    static ap_uint<64> src_addr, dst_addr;
+
+    ap_axiu<32,0,0,0> inword, outword;
+    outword.last = 1;
+    seq_move m;
+    unsigned int prev_pos, prev_chunk;
+
+    //retire: merge results of the moves of the oldest ticket
+    if(ticket_count > 0 && !STREAM_IS_EMPTY(sts_in)){
+        ticket_err |= (unsigned int)(STREAM_READ(sts_in).data);
+        retired++;
+        ticket_retired++;
+        if(ticket_retired == tickets[ticket_head]){
+            outword.data = ticket_err;
+            STREAM_WRITE(sts_out, outword);
+            ticket_err = NO_ERROR;
+            ticket_retired = 0;
+            ticket_head = (ticket_head + 1) % SEQ_TICKETS;
+            ticket_count--;
+        }
+    }
+
+    //issue
+    if(word_idx < nwords){
+        if(!STREAM_IS_FULL(cmd_out)){
+            outword.data = words[word_idx++];
+            STREAM_WRITE(cmd_out, outword);
+            if(word_idx == nwords) issued++;
+        }
+    } else if(pass_words > 0){
+        if(!STREAM_IS_EMPTY(cmd_in) && !STREAM_IS_FULL(cmd_out)){
+            STREAM_WRITE(cmd_out, STREAM_READ(cmd_in));
+            pass_words--;
+            if(pass_words == 0 && pass_result) issued++;
+        }
+    } else if(phase == SEQ_AG_FENCE){
+        //the data to relay is received into the destination buffer, which the relay reads back
+        if(issued == retired) phase = SEQ_AG_RELAY_PRIME;
+    } else if(phase != SEQ_IDLE){
+        m.op0_opcode = MOVE_NONE;
+        m.op1_opcode = MOVE_NONE;
+        m.res_opcode = MOVE_NONE;
+        m.compression = compression;
+        m.res_is_remote = false;
+        m.func_id = 0;
+        m.count = 0;
+        m.op0_addr = 0;
+        m.op1_addr = 0;
+        m.res_addr = 0;
+        m.op0_stride = 0;
+        m.op1_stride = 0;
+        m.res_stride = 0;
+        m.rx_src = prev_in_ring;
+        m.dst_rank = next_in_ring;
+        //chunk received in a step, from one position further back in the ring;
+        //allreduce chunks are indexed by position, others by rank
+        prev_pos = (curr_pos == 0) ? (size - 1) : (curr_pos - 1);
+        prev_chunk = (op == SEQUENCE_ALLREDUCE) ? prev_pos : exchange_mem[ring_offset + prev_pos];
+        switch(phase){
+            case SEQ_RS_PRIME:
+                m.op0_opcode = MOVE_IMMEDIATE;
+                m.op0_addr = src_addr;
+                if(op == SEQUENCE_ALLREDUCE){
+                    m.res_opcode = MOVE_IMMEDIATE;
+                    m.res_addr = dst_addr;
+                }
+                phase = SEQ_RS_SEND;
+                break;
+            case SEQ_RS_SEND:
+                m.op0_opcode = MOVE_STRIDE;
+                m.res_opcode = MOVE_IMMEDIATE;
+                m.compression = compression & ~(RES_COMPRESSED);
+                m.res_is_remote = true;
+                m.count = (curr_chunk == size - 1) ? tail_count : bulk_count;
+                m.op0_stride = bulk_count*curr_chunk;
+                step = 0;
+                phase = SEQ_RS_STEP;
+                break;
+            case SEQ_RS_STEP:
+                //receive, reduce and forward, the last step keeps its result
+                m.op0_opcode = MOVE_STRIDE;
+                m.op1_opcode = MOVE_ON_RECV;
+                m.compression = compression & ~(OP0_COMPRESSED);
+                m.count = (prev_chunk == size - 1) ? tail_count : bulk_count;
+                m.op0_stride = bulk_count*prev_chunk - bulk_count*curr_chunk;
+                m.func_id = func;
+                if(step < size - 2){
+                    m.res_opcode = MOVE_IMMEDIATE;
+                    m.res_is_remote = true;
+                } else if(op == SEQUENCE_ALLREDUCE){
+                    m.res_opcode = MOVE_STRIDE;
+                    m.res_stride = bulk_count*prev_chunk;
+                } else{
+                    m.res_opcode = MOVE_IMMEDIATE;
+                    m.res_addr = dst_addr;
+                }
+                curr_pos = prev_pos;
+                curr_chunk = prev_chunk;
+                step++;
+                if(step == size - 1){
+                    if(op == SEQUENCE_ALLREDUCE){
+                        phase = SEQ_AG_PRIME;
+                    } else{
+                        phase = SEQ_IDLE;
+                    }
+                }
+                break;
+            case SEQ_AG_PRIME:
+                if(op == SEQUENCE_ALLREDUCE){
+                    //send our reduced chunk from the destination
+                    m.op0_opcode = MOVE_IMMEDIATE;
+                    m.op0_addr = dst_addr;
+                    m.compression = compression & ~(RES_COMPRESSED);
+                    curr_pos = next_pos;
+                    curr_chunk = next_pos;
+                    phase = SEQ_AG_SEND;
+                } else{
+                    m.res_opcode = MOVE_IMMEDIATE;
+                    m.res_addr = dst_addr;
+                    curr_pos = local_pos;
+                    curr_chunk = local_rank;
+                    phase = SEQ_AG_COPY;
+                }
+                break;
+            case SEQ_AG_COPY:
+                m.op0_opcode = MOVE_IMMEDIATE;
+                m.op0_addr = src_addr;
+                m.res_opcode = MOVE_STRIDE;
+                m.count = count;
+                m.res_stride = count*local_rank;
+                phase = SEQ_AG_SEND;
+                break;
+            case SEQ_AG_SEND:
+                m.op0_opcode = (op == SEQUENCE_ALLREDUCE) ? MOVE_STRIDE : MOVE_IMMEDIATE;
+                m.op0_addr = src_addr;
+                m.op0_stride = bulk_count*curr_chunk;
+                m.res_opcode = MOVE_IMMEDIATE;
+                m.compression = compression & ~(RES_COMPRESSED);
+                m.res_is_remote = true;
+                m.count = (curr_chunk == size - 1) ? tail_count : bulk_count;
+                step = 0;
+                phase = SEQ_AG_RECV;
+                break;
+            case SEQ_AG_RECV:
+                m.op1_opcode = MOVE_ON_RECV;
+                m.res_opcode = MOVE_STRIDE;
+                m.compression = compression & ~(OP0_COMPRESSED);
+                m.count = (prev_chunk == size - 1) ? tail_count : bulk_count;
+                m.res_stride = bulk_count*prev_chunk - bulk_count*curr_chunk;
+                curr_pos = prev_pos;
+                curr_chunk = prev_chunk;
+                phase = (step < size - 2) ? SEQ_AG_FENCE : SEQ_IDLE;
+                break;
+            case SEQ_AG_RELAY_PRIME:
+                m.op1_opcode = MOVE_IMMEDIATE;
+                m.op1_addr = dst_addr;
+                m.compression = relay_compression;
+                m.res_is_remote = true;
+                phase = SEQ_AG_RELAY_SEND;
+                break;
+            default:
+                //relay the chunk we just received
+                m.op1_opcode = MOVE_STRIDE;
+                m.res_opcode = MOVE_IMMEDIATE;
+                m.compression = relay_compression;
+                m.res_is_remote = true;
+                m.count = (curr_chunk == size - 1) ? tail_count : bulk_count;
+                m.op1_stride = bulk_count*curr_chunk;
+                step++;
+                phase = SEQ_AG_RECV;
+                break;
+        }
+        serialize_move(m, comm_offset, arcfg_offset, words, nwords);
+        word_idx = 0;
+#ifndef ACCL_SYNTHESIS
+        std::stringstream ss;
+        ss << "Collective Sequencer: move " << m.op0_opcode << " " << m.op1_opcode << " " << m.res_opcode << " count=" << m.count << "\n";
+        std::cout << ss.str();
+#endif
+    } else if(!STREAM_IS_EMPTY(cmd_in) && !STREAM_IS_FULL(cmd_out) && ticket_count < SEQ_TICKETS){
+        inword = STREAM_READ(cmd_in);
+        ap_uint<32> opcode = inword.data;
+        unsigned int nmoves = 1;
+        if(opcode & MOVE_SEQUENCE){
+            op = opcode(2,0);
+            compression = opcode(12,10);
+            func = opcode(16,13);
+            count = (STREAM_READ(cmd_in)).data;
+            arcfg_offset = (STREAM_READ(cmd_in)).data;
+            comm_offset = (STREAM_READ(cmd_in)).data;
+            local_pos = (STREAM_READ(cmd_in)).data;
+            src_addr(31,0) = (STREAM_READ(cmd_in)).data;
+            src_addr(63,32) = (STREAM_READ(cmd_in)).data;
+            dst_addr(31,0) = (STREAM_READ(cmd_in)).data;
+            dst_addr(63,32) = (STREAM_READ(cmd_in)).data;
+            size = exchange_mem[comm_offset + COMM_SIZE_OFFSET];
+            local_rank = exchange_mem[comm_offset + COMM_LOCAL_RANK_OFFSET] & COMM_RANK_MASK;
+            ring_offset = comm_offset + COMM_RING_OFFSET(size);
+            next_pos = (local_pos == size - 1) ? 0 : (local_pos + 1);
+            next_in_ring = exchange_mem[ring_offset + next_pos];
+            prev_in_ring = exchange_mem[ring_offset + ((local_pos == 0) ? (size - 1) : (local_pos - 1))];
+            //allreduce splits the buffer into one chunk per rank, the last one smaller,
+            //other collectives move whole buffers of count elements per rank
+            if(op == SEQUENCE_ALLREDUCE){
+                bulk_count = (count + size - 1) / size;
+                tail_count = count - bulk_count*(size - 1);
+            } else{
+                bulk_count = count;
+                tail_count = count;
+            }
+            //the relay sends from the destination, where the data was received
+            relay_compression = (compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression;
+            relay_compression &= ~(RES_COMPRESSED);
+            curr_pos = local_pos;
+            curr_chunk = (op == SEQUENCE_ALLREDUCE) ? local_pos : local_rank;
+            phase = (op == SEQUENCE_ALLGATHER) ? SEQ_AG_PRIME : SEQ_RS_PRIME;
+            nmoves = sequence_moves(op, size);
+        } else{
+            STREAM_WRITE(cmd_out, inword);
+            pass_words = move_words(opcode) - 1;
+            if(opcode & MOVE_CONTEXT) nmoves = 0;
+            pass_result = (nmoves > 0);
+        }
+        if(nmoves > 0){
+            tickets[(ticket_head + ticket_count) % SEQ_TICKETS] = nmoves;
+            ticket_count++;
+        }
+    }
+}
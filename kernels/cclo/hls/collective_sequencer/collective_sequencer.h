@@ -0,0 +1,76 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#pragma once
+
+#include "streamdefines.h"
+#include "ap_int.h"
+#include "ccl_offload_control.h"
+
+//longest move instruction generated by the sequencer, in 32-bit words
+#define SEQ_MAX_MOVE_WORDS 12
+//results owed to the firmware, must exceed the move credits it is given by the dma mover
+#define SEQ_TICKETS 32
+
+//phases of a sequenced collective, one move is generated per phase visit
+typedef enum {
+    SEQ_IDLE,
+    SEQ_RS_PRIME,
+    SEQ_RS_SEND,
+    SEQ_RS_STEP,
+    SEQ_AG_PRIME,
+    SEQ_AG_COPY,
+    SEQ_AG_SEND,
+    SEQ_AG_RECV,
+    SEQ_AG_FENCE,
+    SEQ_AG_RELAY_PRIME,
+    SEQ_AG_RELAY_SEND
+} seq_phase;
+
+typedef struct{
+    ap_uint<3> op0_opcode;
+    ap_uint<3> op1_opcode;
+    ap_uint<3> res_opcode;
+    ap_uint<3> compression;
+    bool res_is_remote;
+    ap_uint<4> func_id;
+    unsigned int count;
+    ap_uint<64> op0_addr;
+    ap_uint<64> op1_addr;
+    ap_uint<64> res_addr;
+    int op0_stride;
+    int op1_stride;
+    int res_stride;
+    unsigned int rx_src;
+    unsigned int dst_rank;
+} seq_move;
+
+//number of moves making up a sequenced collective on a communicator of the given size
+unsigned int sequence_moves(unsigned int op, unsigned int size);
+
+//number of 32-bit words of a move instruction or collective descriptor, from its opcode word
+unsigned int move_words(ap_uint<32> opcode);
+
+void collective_sequencer(
+    //interfaces to processor
+    unsigned int * exchange_mem,
+    STREAM<ap_axiu<32,0,0,0> > &cmd_in,
+    STREAM<ap_axiu<32,0,0,0> > &sts_out,
+    //interfaces to dma mover
+    STREAM<ap_axiu<32,0,0,0> > &cmd_out,
+    STREAM<ap_axiu<32,0,0,0> > &sts_in
+);
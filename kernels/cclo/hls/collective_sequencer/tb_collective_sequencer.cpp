@@ -0,0 +1,363 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "collective_sequencer.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define SIZE 5
+#define LOCAL_RANK 3
+#define COMM 16
+#define ARCFG 8
+#define SRC_ADDR 0x100000000ULL
+#define DST_ADDR 0x200000040ULL
+//MAX, which every reduction step applies, including the last one keeping its result
+#define FUNC 1
+
+unsigned int exchange_mem[1024];
+unsigned int ring[SIZE] = {2, 0, 3, 4, 1};
+vector<unsigned int> golden;
+
+//same encoding as start_move in the firmware, capturing the words
+void start_move(
+    unsigned int op0_opcode, unsigned int op1_opcode, unsigned int res_opcode,
+    unsigned int compression_flags, unsigned int remote_flags, unsigned int func_id,
+    unsigned int count, unsigned int comm_offset, unsigned int arcfg_offset,
+    uint64_t op0_addr, uint64_t op1_addr, uint64_t res_addr,
+    int op0_stride, int op1_stride, int res_stride,
+    unsigned int rx_src_rank, unsigned int rx_tag, unsigned int tx_dst_rank, unsigned int tx_tag
+){
+    bool res_is_remote = (remote_flags == RES_REMOTE);
+    golden.push_back(op0_opcode | (op1_opcode << 3) | (res_opcode << 6) | (remote_flags << 9) | (compression_flags << 10) | (func_id << 13));
+    golden.push_back(count);
+    golden.push_back(arcfg_offset);
+    if(op0_opcode == MOVE_IMMEDIATE){
+        golden.push_back((uint32_t)op0_addr);
+        golden.push_back((uint32_t)(op0_addr >> 32));
+    } else if(op0_opcode == MOVE_STRIDE){
+        golden.push_back(op0_stride);
+    }
+    if(op1_opcode == MOVE_IMMEDIATE){
+        golden.push_back((uint32_t)op1_addr);
+        golden.push_back((uint32_t)(op1_addr >> 32));
+    } else if(op1_opcode == MOVE_ON_RECV){
+        golden.push_back(rx_src_rank);
+        golden.push_back(rx_tag);
+    } else if(op1_opcode == MOVE_STRIDE){
+        golden.push_back(op1_stride);
+    }
+    if(res_opcode == MOVE_IMMEDIATE){
+        golden.push_back((uint32_t)res_addr);
+        golden.push_back((uint32_t)(res_addr >> 32));
+    } else if(res_opcode == MOVE_STRIDE){
+        golden.push_back(res_stride);
+    }
+    if(res_is_remote || res_opcode == MOVE_STREAM) golden.push_back(tx_tag);
+    if(res_is_remote || op1_opcode == MOVE_ON_RECV) golden.push_back(comm_offset);
+    if(res_is_remote) golden.push_back(tx_dst_rank);
+}
+
+unsigned int ring_rank(int pos){ return ring[((pos % SIZE) + SIZE) % SIZE]; }
+
+unsigned int ring_pos(unsigned int rank){
+    for(int i = 0; i < SIZE; i++){
+        if(ring[i] == rank) return i;
+    }
+    return 0;
+}
+
+//move sequences of the firmware ring collectives, with uniform moves standing in for blocking ones
+void golden_reduce_scatter(unsigned int count, unsigned int func, unsigned int compression){
+    int local_pos = ring_pos(LOCAL_RANK);
+    int next = ring_rank(local_pos + 1), prev = ring_rank(local_pos + SIZE - 1);
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_NONE, compression, RES_LOCAL, 0, 0, 0, ARCFG, SRC_ADDR, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    start_move(MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE, compression & ~(RES_COMPRESSED), RES_REMOTE, 0, count, COMM, ARCFG,
+        0, 0, 0, count*LOCAL_RANK, 0, 0, 0, 0, next, TAG_ANY);
+    int curr_pos = local_pos;
+    for(int i = 0; i < SIZE-1; i++){
+        int rel_stride = count*(ring_rank(curr_pos + SIZE - 1) - ring_rank(curr_pos));
+        if(i < SIZE-2){
+            start_move(MOVE_STRIDE, MOVE_ON_RECV, MOVE_IMMEDIATE, compression & ~(OP0_COMPRESSED), RES_REMOTE, func, count, COMM, ARCFG,
+                0, 0, 0, rel_stride, 0, 0, prev, TAG_ANY, next, TAG_ANY);
+        } else{
+            start_move(MOVE_STRIDE, MOVE_ON_RECV, MOVE_IMMEDIATE, compression & ~(OP0_COMPRESSED), RES_LOCAL, func, count, COMM, ARCFG,
+                0, 0, DST_ADDR, rel_stride, 0, 0, prev, TAG_ANY, 0, 0);
+        }
+        curr_pos = (curr_pos + SIZE - 1) % SIZE;
+    }
+}
+
+void golden_allgather(unsigned int count, unsigned int compression){
+    unsigned int relay_compression = ((compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression) & ~(RES_COMPRESSED);
+    int local_pos = ring_pos(LOCAL_RANK);
+    int next = ring_rank(local_pos + 1), prev = ring_rank(local_pos + SIZE - 1);
+    start_move(MOVE_NONE, MOVE_NONE, MOVE_IMMEDIATE, compression, RES_LOCAL, 0, 0, 0, ARCFG, SRC_ADDR, 0, DST_ADDR, 0, 0, 0, 0, 0, 0, 0);
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_STRIDE, compression, RES_LOCAL, 0, count, 0, ARCFG,
+        SRC_ADDR, 0, 0, 0, 0, count*LOCAL_RANK, 0, 0, 0, 0);
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE, compression & ~(RES_COMPRESSED), RES_REMOTE, 0, count, COMM, ARCFG,
+        SRC_ADDR, 0, 0, 0, 0, 0, 0, 0, next, TAG_ANY);
+    int curr_pos = local_pos;
+    for(int i = 0; i < SIZE-1; i++){
+        int abs_stride = count*ring_rank(curr_pos + SIZE - 1);
+        int rel_stride = abs_stride - count*ring_rank(curr_pos);
+        start_move(MOVE_NONE, MOVE_ON_RECV, MOVE_STRIDE, compression & ~(OP0_COMPRESSED), RES_LOCAL, 0, count, COMM, ARCFG,
+            0, 0, 0, 0, 0, rel_stride, prev, TAG_ANY, 0, 0);
+        if(i < SIZE-2){
+            start_move(MOVE_NONE, MOVE_IMMEDIATE, MOVE_NONE, relay_compression, RES_REMOTE, 0, 0, COMM, ARCFG,
+                0, DST_ADDR, 0, 0, 0, 0, 0, 0, next, TAG_ANY);
+            start_move(MOVE_NONE, MOVE_STRIDE, MOVE_IMMEDIATE, relay_compression, RES_REMOTE, 0, count, COMM, ARCFG,
+                0, 0, 0, 0, abs_stride, 0, 0, 0, next, TAG_ANY);
+        }
+        curr_pos = (curr_pos + SIZE - 1) % SIZE;
+    }
+}
+
+//the firmware allreduce passes zero for the communicator and destination of dry runs,
+//which do not use them; the sequencer passes the actual ones
+void golden_allreduce(unsigned int count, unsigned int func, unsigned int compression){
+    unsigned int relay_compression = ((compression & RES_COMPRESSED) ? (compression | OP0_COMPRESSED) : compression) & ~(RES_COMPRESSED);
+    int local_pos = ring_pos(LOCAL_RANK);
+    int next = ring_rank(local_pos + 1), prev = ring_rank(local_pos + SIZE - 1);
+    int next_pos = (local_pos + 1) % SIZE;
+    unsigned int bulk_count = (count + SIZE - 1) / SIZE;
+    unsigned int tail_count = count - bulk_count*(SIZE-1);
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE, compression, RES_LOCAL, 0, 0, 0, ARCFG, SRC_ADDR, 0, DST_ADDR, 0, 0, 0, 0, 0, 0, 0);
+    start_move(MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE, compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
+        (local_pos == SIZE-1) ? tail_count : bulk_count, COMM, ARCFG, 0, 0, 0, bulk_count*local_pos, 0, 0, 0, 0, next, TAG_ANY);
+    int curr_pos = local_pos;
+    for(int i = 0; i < SIZE-1; i++){
+        int rel_stride = bulk_count*((curr_pos == 0) ? (SIZE-1) : -1);
+        unsigned int curr_count = (curr_pos == 0) ? tail_count : bulk_count;
+        if(i < SIZE-2){
+            start_move(MOVE_STRIDE, MOVE_ON_RECV, MOVE_IMMEDIATE, compression & ~(OP0_COMPRESSED), RES_REMOTE, func, curr_count, COMM, ARCFG,
+                0, 0, 0, rel_stride, 0, 0, prev, TAG_ANY, next, TAG_ANY);
+        } else{
+            start_move(MOVE_STRIDE, MOVE_ON_RECV, MOVE_STRIDE, compression & ~(OP0_COMPRESSED), RES_LOCAL, func, curr_count, COMM, ARCFG,
+                0, 0, 0, rel_stride, 0, bulk_count*next_pos, prev, TAG_ANY, 0, 0);
+        }
+        curr_pos = (curr_pos + SIZE - 1) % SIZE;
+    }
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_NONE, compression & ~(RES_COMPRESSED), RES_LOCAL, 0, 0, 0, ARCFG, DST_ADDR, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    start_move(MOVE_STRIDE, MOVE_NONE, MOVE_IMMEDIATE, compression & ~(RES_COMPRESSED), RES_REMOTE, 0,
+        (next_pos == SIZE-1) ? tail_count : bulk_count, COMM, ARCFG, 0, 0, 0, bulk_count*next_pos, 0, 0, 0, 0, next, TAG_ANY);
+    curr_pos = next_pos;
+    for(int i = 0; i < SIZE-1; i++){
+        int rel_stride = bulk_count*((curr_pos == 0) ? (SIZE-1) : -1);
+        unsigned int curr_count = (curr_pos == 0) ? tail_count : bulk_count;
+        start_move(MOVE_NONE, MOVE_ON_RECV, MOVE_STRIDE, compression & ~(OP0_COMPRESSED), RES_LOCAL, 0, curr_count, COMM, ARCFG,
+            0, 0, 0, 0, 0, rel_stride, prev, TAG_ANY, 0, 0);
+        curr_pos = (curr_pos + SIZE - 1) % SIZE;
+        curr_count = (curr_pos == (SIZE - 1)) ? tail_count : bulk_count;
+        if(i < SIZE-2){
+            start_move(MOVE_NONE, MOVE_IMMEDIATE, MOVE_NONE, relay_compression, RES_REMOTE, 0, 0, COMM, ARCFG,
+                0, DST_ADDR, 0, 0, 0, 0, 0, 0, next, TAG_ANY);
+            start_move(MOVE_NONE, MOVE_STRIDE, MOVE_IMMEDIATE, relay_compression, RES_REMOTE, 0, curr_count, COMM, ARCFG,
+                0, 0, 0, 0, bulk_count*curr_pos, 0, 0, 0, next, TAG_ANY);
+        }
+    }
+}
+
+void put(STREAM<ap_axiu<32,0,0,0> > &s, unsigned int val){
+    ap_axiu<32,0,0,0> w;
+    w.data = val;
+    w.last = 1;
+    STREAM_WRITE(s, w);
+}
+
+//runs the sequencer, acting as a dma mover which retires every move it receives
+//with the given result unless hold is set; returns the words received
+vector<unsigned int> run(
+    STREAM<ap_axiu<32,0,0,0> > &cmd_in, STREAM<ap_axiu<32,0,0,0> > &sts_out,
+    STREAM<ap_axiu<32,0,0,0> > &cmd_out, STREAM<ap_axiu<32,0,0,0> > &sts_in,
+    unsigned int result, bool hold, unsigned int &nretired
+){
+    vector<unsigned int> words;
+    unsigned int move_start = 0;
+    nretired = 0;
+    for(int cycle = 0; cycle < 10000; cycle++){
+        collective_sequencer(exchange_mem, cmd_in, sts_out, cmd_out, sts_in);
+        while(!STREAM_IS_EMPTY(cmd_out)){
+            words.push_back((unsigned int)STREAM_READ(cmd_out).data);
+            if(words.size() - move_start == move_words(words[move_start])){
+                bool context = (words[move_start] & MOVE_CONTEXT) != 0;
+                move_start = words.size();
+                if(!hold && !context){
+                    put(sts_in, result);
+                    nretired++;
+                }
+            }
+        }
+    }
+    return words;
+}
+
+int check(const char *name, vector<unsigned int> &words){
+    if(words != golden){
+        cout << name << ": got " << words.size() << " words, expected " << golden.size() << endl;
+        for(unsigned int i = 0; i < words.size() && i < golden.size(); i++){
+            if(words[i] != golden[i]){
+                cout << name << ": first mismatch at word " << i << ": " << hex << words[i] << " vs " << golden[i] << dec << endl;
+                break;
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int main(){
+    STREAM<ap_axiu<32,0,0,0> > cmd_in, sts_out, cmd_out, sts_in;
+    vector<unsigned int> words;
+    unsigned int nretired;
+    int nerrors = 0;
+
+    exchange_mem[COMM + COMM_SIZE_OFFSET] = SIZE;
+    exchange_mem[COMM + COMM_LOCAL_RANK_OFFSET] = (7 << COMM_ID_SHIFT) | LOCAL_RANK;
+    for(int i = 0; i < SIZE; i++){
+        exchange_mem[COMM + COMM_RING_OFFSET(SIZE) + i] = ring[i];
+    }
+
+    unsigned int ops[3] = {SEQUENCE_REDUCE_SCATTER, SEQUENCE_ALLGATHER, SEQUENCE_ALLREDUCE};
+    const char *names[3] = {"reduce_scatter", "allgather", "allreduce"};
+    unsigned int compressions[2] = {NO_COMPRESSION, OP1_COMPRESSED | RES_COMPRESSED};
+    for(int c = 0; c < 2; c++){
+        for(int o = 0; o < 3; o++){
+            golden.clear();
+            if(ops[o] == SEQUENCE_REDUCE_SCATTER) golden_reduce_scatter(37, FUNC, compressions[c]);
+            if(ops[o] == SEQUENCE_ALLGATHER) golden_allgather(37, compressions[c]);
+            if(ops[o] == SEQUENCE_ALLREDUCE) golden_allreduce(37, FUNC, compressions[c]);
+            put(cmd_in, MOVE_SEQUENCE | ops[o] | (compressions[c] << 10) | (FUNC << 13));
+            put(cmd_in, 37);
+            put(cmd_in, ARCFG);
+            put(cmd_in, COMM);
+            put(cmd_in, ring_pos(LOCAL_RANK));
+            put(cmd_in, (uint32_t)SRC_ADDR);
+            put(cmd_in, (uint32_t)(SRC_ADDR >> 32));
+            put(cmd_in, (uint32_t)DST_ADDR);
+            put(cmd_in, (uint32_t)(DST_ADDR >> 32));
+            //every move retires with its own error bit, the firmware sees them merged
+            words = run(cmd_in, sts_out, cmd_out, sts_in, 1 << o, false, nretired);
+            nerrors += check(names[o], words);
+            if(nretired != sequence_moves(ops[o], SIZE)){
+                cout << names[o] << ": " << nretired << " moves, expected " << sequence_moves(ops[o], SIZE) << endl;
+                nerrors++;
+            }
+            if(STREAM_IS_EMPTY(sts_out) || (unsigned int)STREAM_READ(sts_out).data != (1u << o) || !STREAM_IS_EMPTY(sts_out)){
+                cout << names[o] << ": expected a single merged result" << endl;
+                nerrors++;
+            }
+        }
+    }
+
+    //plain moves and credit queries pass through unchanged, with one result each
+    golden.clear();
+    start_move(MOVE_IMMEDIATE, MOVE_NONE, MOVE_IMMEDIATE, NO_COMPRESSION, RES_REMOTE, 0, 12, COMM, ARCFG,
+        SRC_ADDR, 0, 0, 0, 0, 0, 0, 0, 2, 5);
+    golden.push_back(MOVE_CREDIT_QUERY);
+    golden.push_back(0);
+    golden.push_back(0);
+    for(unsigned int i = 0; i < golden.size(); i++){
+        put(cmd_in, golden[i]);
+    }
+    words = run(cmd_in, sts_out, cmd_out, sts_in, 0, false, nretired);
+    nerrors += check("passthrough", words);
+    for(int i = 0; i < 2; i++){
+        if(STREAM_IS_EMPTY(sts_out)){
+            cout << "passthrough: missing result" << endl;
+            nerrors++;
+        } else{
+            STREAM_READ(sts_out);
+        }
+    }
+
+    //compact moves pass through after their context, which has no result, and a loop
+    //passes through as a single move
+    golden.clear();
+    golden.push_back(MOVE_CONTEXT);
+    golden.push_back(ARCFG);
+    golden.push_back(COMM);
+    golden.push_back(MOVE_STRIDE | (MOVE_ON_RECV << 3) | (MOVE_STRIDE << 6) | (RES_REMOTE << 9) | MOVE_COMPACT);
+    golden.push_back(12);
+    golden.push_back(0xFFF4000C);
+    golden.push_back((2 << 16) | 4);
+    golden.push_back(9);
+    golden.push_back(5);
+    golden.push_back(MOVE_IMMEDIATE | (MOVE_IMMEDIATE << 6) | MOVE_COMPACT | MOVE_TAG_ANY | MOVE_LOOP);
+    golden.push_back(12);
+    for(int i = 0; i < 4; i++){
+        golden.push_back(i);
+    }
+    golden.push_back(4 | (MOVE_STRIDE << 16) | (MOVE_STRIDE << 22));
+    golden.push_back(12);
+    for(unsigned int i = 0; i < golden.size(); i++){
+        put(cmd_in, golden[i]);
+    }
+    words = run(cmd_in, sts_out, cmd_out, sts_in, 0, false, nretired);
+    nerrors += check("compact", words);
+    if(nretired != 2){
+        cout << "compact: " << nretired << " moves, expected 2" << endl;
+        nerrors++;
+    }
+    for(int i = 0; i < 2; i++){
+        if(STREAM_IS_EMPTY(sts_out)){
+            cout << "compact: missing result" << endl;
+            nerrors++;
+        } else{
+            STREAM_READ(sts_out);
+        }
+    }
+    if(!STREAM_IS_EMPTY(sts_out)){
+        cout << "compact: unexpected result" << endl;
+        nerrors++;
+    }
+
+    //the allgather relays data it received into the destination, so it waits for the receive to retire
+    golden.clear();
+    golden_allgather(37, NO_COMPRESSION);
+    put(cmd_in, MOVE_SEQUENCE | SEQUENCE_ALLGATHER);
+    put(cmd_in, 37);
+    put(cmd_in, ARCFG);
+    put(cmd_in, COMM);
+    put(cmd_in, ring_pos(LOCAL_RANK));
+    put(cmd_in, (uint32_t)SRC_ADDR);
+    put(cmd_in, (uint32_t)(SRC_ADDR >> 32));
+    put(cmd_in, (uint32_t)DST_ADDR);
+    put(cmd_in, (uint32_t)(DST_ADDR >> 32));
+    words = run(cmd_in, sts_out, cmd_out, sts_in, 0, true, nretired);
+    //prime, copy, send and the first receive
+    unsigned int nwords = 0;
+    for(int i = 0; i < 4; i++){
+        nwords += move_words(golden[nwords]);
+    }
+    if(words.size() != nwords){
+        cout << "fence: issued " << words.size() << " words before any move retired, expected " << nwords << endl;
+        nerrors++;
+    }
+    for(int i = 0; i < 4; i++){
+        put(sts_in, NO_ERROR);
+    }
+    vector<unsigned int> rest = run(cmd_in, sts_out, cmd_out, sts_in, 0, false, nretired);
+    words.insert(words.end(), rest.begin(), rest.end());
+    nerrors += check("fence", words);
+
+    if(nerrors == 0){
+        cout << "Collective sequencer test passed" << endl;
+    }
+    return nerrors;
+}
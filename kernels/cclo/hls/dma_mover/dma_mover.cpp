@@ -283,10 +283,14 @@ void eth_cmd_execute(
     STREAM<packetizer_ack_instruction> &ack_instruction
 ) {
 #pragma HLS PIPELINE II=1 style=flp
-    unsigned int seg_len, sequence_number;
+    unsigned int seg_len, sequence_number, msg_count;
+    ap_uint<64> seg_addr;
     if(!STREAM_IS_EMPTY(instruction)){
         packetizer_instruction insn = STREAM_READ(instruction);
         sequence_number = insn.seqn;
+        //a RTS announces the size of the rendezvous payload that follows it
+        msg_count = (insn.msg_type == MSG_RNDZV_RTS) ? (unsigned int)insn.rndzv_arg : insn.len;
+        seg_addr = insn.rndzv_arg;
         while(insn.len > 0){
             //NOTE: to make sure we don't get into trouble with ragged ends on streams,
             //max_segment_len should be a multiple of the datapath width (64B)
@@ -302,6 +306,15 @@ void eth_cmd_execute(
             pkt_cmd.seqn = sequence_number;
             pkt_cmd.strm = insn.to_stream ? (insn.mpi_tag + SWITCH_M_BYPASS) : 0;
             pkt_cmd.dst = insn.dst_sess_id;
+            pkt_cmd.msg_count = msg_count;
+            pkt_cmd.msg_type = insn.msg_type;
+            pkt_cmd.addr = seg_addr;
+            pkt_cmd.fanout = insn.fanout;
+            pkt_cmd.fanout_first = (sequence_number == insn.seqn);
+            //rendezvous payload and RMA get response segments each carry their own address
+            if(insn.msg_type == MSG_RNDZV_DATA || insn.msg_type == MSG_RMA_GET_RESP){
+                seg_addr += seg_len;
+            }
             STREAM_WRITE(eth_cmd_channel, pkt_cmd);
             packetizer_ack_instruction ack_insn;
             ack_insn.expected_seqn = sequence_number;
@@ -345,11 +358,31 @@ void instruction_fetch(
     STREAM<move_instruction> &instruction
 ){
 #pragma HLS PIPELINE II=1 style=flp
+    //offsets of compact moves, set by MOVE_CONTEXT
+    static unsigned int ctx_arcfg_offset = 0;
+    static unsigned int ctx_comm_offset = 0;
+    //iterations of a MOVE_LOOP left to issue, each from the previous one
+    static move_instruction loop_insn;
+    static unsigned int loop_remaining = 0;
+    static unsigned int loop_rank_step = 0;
     ap_uint<32> tmp;
     move_instruction ret;
 
+    if(loop_remaining > 0){
+        loop_remaining--;
+        loop_insn.merge_result = (loop_remaining > 0);
+        STREAM_WRITE(instruction, loop_insn);
+        loop_insn.dst_rank += loop_rank_step;
+        return;
+    }
+
     if(!STREAM_IS_EMPTY(cmd)){
         tmp = (STREAM_READ(cmd)).data;
+        if(tmp & MOVE_CONTEXT){
+            ctx_arcfg_offset = (STREAM_READ(cmd)).data;
+            ctx_comm_offset = (STREAM_READ(cmd)).data;
+            return;
+        }
         ret.op0_opcode = tmp(2,0);
         ret.op1_opcode = tmp(5,3);
         ret.res_opcode = tmp(8,6);
@@ -360,45 +393,119 @@ void instruction_fetch(
         ret.op1_is_compressed = (compression_flags & OP1_COMPRESSED) != 0;
         ret.res_is_compressed = (compression_flags & RES_COMPRESSED) != 0;
         ret.func_id = tmp(16,13);
+        ret.msg_type = tmp(20,17);
+        ret.credit_query = (tmp & MOVE_CREDIT_QUERY) != 0;
+        ret.merge_result = false;
+        ret.fanout = FANOUT_NONE;
         
         ret.count = (STREAM_READ(cmd)).data;
 
-        //get arith config offset
-        ret.arcfg_offset = (STREAM_READ(cmd)).data;
+        if(tmp & MOVE_COMPACT){
+            ret.arcfg_offset = ctx_arcfg_offset;
+            ret.comm_offset = ctx_comm_offset;
+            ret.msg_type = MSG_EAGER;
+            if(ret.op0_opcode == MOVE_IMMEDIATE){
+                ret.op0_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.op0_addr(63,32) = (STREAM_READ(cmd)).data;
+            }
+            if(ret.op1_opcode == MOVE_IMMEDIATE){
+                ret.op1_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.op1_addr(63,32) = (STREAM_READ(cmd)).data;
+            }
+            if(ret.res_opcode == MOVE_IMMEDIATE){
+                ret.res_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.res_addr(63,32) = (STREAM_READ(cmd)).data;
+            }
+            //16-bit strides, two per word, in op0, op1, res order
+            unsigned int nstrides = (ret.op0_opcode == MOVE_STRIDE) + (ret.op1_opcode == MOVE_STRIDE) + (ret.res_opcode == MOVE_STRIDE);
+            unsigned int strides_lo = 0, strides_hi = 0;
+            if(nstrides > 0) strides_lo = (STREAM_READ(cmd)).data;
+            if(nstrides > 2) strides_hi = (STREAM_READ(cmd)).data;
+            int stride0 = (short)(strides_lo & 0xFFFF);
+            int stride1 = (short)(strides_lo >> 16);
+            int stride2 = (short)(strides_hi & 0xFFFF);
+            ret.op0_stride = stride0;
+            ret.op1_stride = (ret.op0_opcode == MOVE_STRIDE) ? stride1 : stride0;
+            ret.res_stride = (nstrides == 3) ? stride2 : (nstrides == 2) ? stride1 : stride0;
+            if(ret.res_is_remote || ret.op1_opcode == MOVE_ON_RECV){
+                ap_uint<32> ranks = (STREAM_READ(cmd)).data;
+                ret.rx_src = ranks(15,0);
+                ret.dst_rank = ranks(31,16);
+            }
+            ret.rx_tag = TAG_ANY;
+            ret.mpi_tag = TAG_ANY;
+            if(!(tmp & MOVE_TAG_ANY)){
+                if(ret.op1_opcode == MOVE_ON_RECV){
+                    ret.rx_tag = (STREAM_READ(cmd)).data;
+                }
+                if(ret.res_is_remote || ret.res_opcode == MOVE_STREAM){
+                    ret.mpi_tag = (STREAM_READ(cmd)).data;
+                }
+            }
+        } else{
+            //get arith config offset
+            ret.arcfg_offset = (STREAM_READ(cmd)).data;
 
-        //get addr for op0, or equivalents
-        if(ret.op0_opcode == MOVE_IMMEDIATE){
-            ret.op0_addr(31,0) = (STREAM_READ(cmd)).data;
-            ret.op0_addr(63,32) = (STREAM_READ(cmd)).data;
-        } else if(ret.op0_opcode == MOVE_STRIDE){
-            ret.op0_stride = (STREAM_READ(cmd)).data;
-        }
-        //get addr for op1, or equivalents
-        if(ret.op1_opcode == MOVE_IMMEDIATE){
-            ret.op1_addr(31,0) = (STREAM_READ(cmd)).data;
-            ret.op1_addr(63,32) = (STREAM_READ(cmd)).data;
-        } else if(ret.op1_opcode == MOVE_ON_RECV){
-            ret.rx_src = (STREAM_READ(cmd)).data;
-            ret.rx_tag = (STREAM_READ(cmd)).data;
-        } else if(ret.op1_opcode == MOVE_STRIDE){
-            ret.op1_stride = (STREAM_READ(cmd)).data;
-        }
-        //get addr for res, or equivalents
-        if(ret.res_opcode == MOVE_IMMEDIATE){
-            ret.res_addr(31,0) = (STREAM_READ(cmd)).data;
-            ret.res_addr(63,32) = (STREAM_READ(cmd)).data;
-        } else if(ret.res_opcode == MOVE_STRIDE){
-            ret.res_stride = (STREAM_READ(cmd)).data;
-        }
-        //get send related stuff, if result is remote or stream
-        if(ret.res_is_remote || ret.res_opcode == MOVE_STREAM){
-            ret.mpi_tag = (STREAM_READ(cmd)).data;
-        }
-        if(ret.res_is_remote || ret.op1_opcode == MOVE_ON_RECV){
-            ret.comm_offset = (STREAM_READ(cmd)).data;
+            //get addr for op0, or equivalents
+            if(ret.op0_opcode == MOVE_IMMEDIATE){
+                ret.op0_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.op0_addr(63,32) = (STREAM_READ(cmd)).data;
+            } else if(ret.op0_opcode == MOVE_STRIDE){
+                ret.op0_stride = (STREAM_READ(cmd)).data;
+            }
+            //get addr for op1, or equivalents
+            if(ret.op1_opcode == MOVE_IMMEDIATE){
+                ret.op1_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.op1_addr(63,32) = (STREAM_READ(cmd)).data;
+            } else if(ret.op1_opcode == MOVE_ON_RECV){
+                ret.rx_src = (STREAM_READ(cmd)).data;
+                ret.rx_tag = (STREAM_READ(cmd)).data;
+            } else if(ret.op1_opcode == MOVE_STRIDE){
+                ret.op1_stride = (STREAM_READ(cmd)).data;
+            }
+            //get addr for res, or equivalents
+            if(ret.res_opcode == MOVE_IMMEDIATE){
+                ret.res_addr(31,0) = (STREAM_READ(cmd)).data;
+                ret.res_addr(63,32) = (STREAM_READ(cmd)).data;
+            } else if(ret.res_opcode == MOVE_STRIDE){
+                ret.res_stride = (STREAM_READ(cmd)).data;
+            }
+            //get send related stuff, if result is remote or stream
+            if(ret.res_is_remote || ret.res_opcode == MOVE_STREAM){
+                ret.mpi_tag = (STREAM_READ(cmd)).data;
+            }
+            if(ret.res_is_remote || ret.op1_opcode == MOVE_ON_RECV){
+                ret.comm_offset = (STREAM_READ(cmd)).data;
+            }
+            if(ret.res_is_remote){
+                ret.dst_rank = (STREAM_READ(cmd)).data;
+            }
+            if(ret.res_is_remote && ret.msg_type != MSG_EAGER){
+                ret.rndzv_arg(31,0) = (STREAM_READ(cmd)).data;
+                ret.rndzv_arg(63,32) = (STREAM_READ(cmd)).data;
+            }
         }
-        if(ret.res_is_remote){
-            ret.dst_rank = (STREAM_READ(cmd)).data;
+
+        //a loop repeats the move, the first iteration is the one decoded above
+        if(tmp & MOVE_LOOP){
+            ap_uint<32> loop = (STREAM_READ(cmd)).data;
+            int loop_stride = (STREAM_READ(cmd)).data;
+            loop_remaining = (loop(15,0) > 0) ? (unsigned int)(loop(15,0) - 1) : 0;
+            loop_rank_step = loop(31,25);
+            ret.merge_result = (loop_remaining > 0);
+            loop_insn = ret;
+            loop_insn.op0_opcode = loop(18,16);
+            loop_insn.op1_opcode = loop(21,19);
+            loop_insn.res_opcode = loop(24,22);
+            loop_insn.op0_stride = loop_stride;
+            loop_insn.op1_stride = loop_stride;
+            loop_insn.res_stride = loop_stride;
+            loop_insn.dst_rank = ret.dst_rank + loop_rank_step;
+            //a multicast loop reads its data once, to be replayed for the other destinations
+            if(tmp & MOVE_MULTICAST){
+                ret.fanout = FANOUT_RECORD;
+                loop_insn.fanout = FANOUT_REPLAY;
+            }
         }
         STREAM_WRITE(instruction, ret);
     }
@@ -432,7 +539,7 @@ void instruction_decode(
     if(STREAM_IS_EMPTY(instruction)) return;
 
     move_instruction insn = STREAM_READ(instruction);
-    unsigned int src, seqn, session, nsegments;
+    unsigned int src, seqn, session, nsegments, rx_src;
     datamover_instruction dm0_rd, dm1_rd, dm1_wr;
     packetizer_instruction pkt_wr;
     router_instruction rtr;
@@ -444,31 +551,60 @@ void instruction_decode(
     ack_insn.check_dma1_rx = false;
     ack_insn.check_dma1_tx = false;
     ack_insn.check_eth_tx = false;
+    ack_insn.report_credits = false;
+    ack_insn.merge_next = insn.merge_result;
+    //credit queries only travel to the retire stage, to be answered in order with other moves
+    if(insn.credit_query){
+        ack_insn.report_credits = true;
+        STREAM_WRITE(err_instruction, ack_insn);
+        return;
+    }
     //NOTE: if count is zero, we do all address manipulation but do not issue
     //actual commands to any execution units; this effectively creates an initialization
     //instruction, like a NOP with side-effects in the address registers
     bool dry_run = (insn.count == 0);
+    //replayed iterations of a multicast only send, their data comes from the fan-out block
+    bool replay = (insn.fanout == FANOUT_REPLAY);
     //get arithmetic config unless we have already cached it
-    static datapath_arith_config arcfg;
-    static bool arcfg_cached = false;
-    static unsigned int prev_arcfg_offset;
-    if(!arcfg_cached || (insn.arcfg_offset != prev_arcfg_offset && !dry_run)){
-        //Do the equivalent of this: 
-        //  arcfg = *((datapath_arith_config*)(exchange_mem + insn.arcfg_offset));
-        //Doing it directly infers a wide bus as if the entire struct is read at once
-        arcfg.uncompressed_elem_bytes = exchange_mem[insn.arcfg_offset + 0];
-        arcfg.compressed_elem_bytes = exchange_mem[insn.arcfg_offset + 1];
-        arcfg.elem_ratio_log = exchange_mem[insn.arcfg_offset + 2];
-        arcfg.compressor_tdest = exchange_mem[insn.arcfg_offset + 3];
-        arcfg.decompressor_tdest = exchange_mem[insn.arcfg_offset + 4];
-        arcfg.arith_nfunctions = exchange_mem[insn.arcfg_offset + 5];
-        arcfg.arith_is_compressed = exchange_mem[insn.arcfg_offset + 6];
-        for(int i=0; i<arcfg.arith_nfunctions; i++){
-            arcfg.arith_tdest[i] = exchange_mem[insn.arcfg_offset + 7 + i];
+    //the last ARCFG_CACHE_SIZE configs are kept, so calls alternating between
+    //data types do not reload them; dry runs reuse the config of the previous move
+    static datapath_arith_config arcfg_cache[ARCFG_CACHE_SIZE];
+#pragma HLS ARRAY_PARTITION variable=arcfg_cache complete
+    static unsigned int arcfg_cache_offset[ARCFG_CACHE_SIZE];
+#pragma HLS ARRAY_PARTITION variable=arcfg_cache_offset complete
+    static ap_uint<ARCFG_CACHE_SIZE> arcfg_cache_valid = 0;
+    static unsigned int arcfg_cache_next = 0;
+    static unsigned int arcfg_idx = 0;
+    if(arcfg_cache_valid == 0 || !dry_run){
+        bool arcfg_hit = false;
+        for(int i=0; i<ARCFG_CACHE_SIZE; i++){
+#pragma HLS UNROLL
+            if(arcfg_cache_valid[i] && (arcfg_cache_offset[i] == insn.arcfg_offset)){
+                arcfg_hit = true;
+                arcfg_idx = i;
+            }
+        }
+        if(!arcfg_hit){
+            arcfg_idx = arcfg_cache_next;
+            arcfg_cache_next = (arcfg_cache_next + 1) % ARCFG_CACHE_SIZE;
+            //Do the equivalent of this: 
+            //  arcfg = *((datapath_arith_config*)(exchange_mem + insn.arcfg_offset));
+            //Doing it directly infers a wide bus as if the entire struct is read at once
+            arcfg_cache[arcfg_idx].uncompressed_elem_bytes = exchange_mem[insn.arcfg_offset + 0];
+            arcfg_cache[arcfg_idx].compressed_elem_bytes = exchange_mem[insn.arcfg_offset + 1];
+            arcfg_cache[arcfg_idx].elem_ratio_log = exchange_mem[insn.arcfg_offset + 2];
+            arcfg_cache[arcfg_idx].compressor_tdest = exchange_mem[insn.arcfg_offset + 3];
+            arcfg_cache[arcfg_idx].decompressor_tdest = exchange_mem[insn.arcfg_offset + 4];
+            arcfg_cache[arcfg_idx].arith_nfunctions = exchange_mem[insn.arcfg_offset + 5];
+            arcfg_cache[arcfg_idx].arith_is_compressed = exchange_mem[insn.arcfg_offset + 6];
+            for(int i=0; i<arcfg_cache[arcfg_idx].arith_nfunctions; i++){
+                arcfg_cache[arcfg_idx].arith_tdest[i] = exchange_mem[insn.arcfg_offset + 7 + i];
+            }
+            arcfg_cache_offset[arcfg_idx] = insn.arcfg_offset;
+            arcfg_cache_valid[arcfg_idx] = 1;
         }
-        arcfg_cached = true;
-        prev_arcfg_offset = insn.arcfg_offset;
     }
+    datapath_arith_config arcfg = arcfg_cache[arcfg_idx];
     //compute total transfer bytes for compressed and uncompressed scenarios
     unsigned int total_bytes_uncompressed = get_len(insn.count, 0, arcfg.uncompressed_elem_bytes);
     unsigned int total_bytes_compressed = get_len(insn.count, arcfg.elem_ratio_log, arcfg.compressed_elem_bytes);
@@ -488,14 +624,14 @@ void instruction_decode(
     rtr.compress_func = arcfg.compressor_tdest;
     rtr.decompress_func = arcfg.decompressor_tdest;
     rtr.krnl_id = insn.mpi_tag;
-    if(!dry_run){
+    if(!dry_run && !replay){
         STREAM_WRITE(router_insn, rtr);
         ack_insn.check_strm_tx = rtr.stream_out;
     }
     //issue commands to datamovers, if required
     //DM0 read channel corresponding to OP0
     static datamover_instruction prev_dm0_rd;
-    if((insn.op0_opcode != MOVE_NONE) & (insn.op0_opcode != MOVE_STREAM)){
+    if((insn.op0_opcode != MOVE_NONE) & (insn.op0_opcode != MOVE_STREAM) & !replay){
         dm0_rd.total_bytes = insn.op0_is_compressed ? total_bytes_compressed : total_bytes_uncompressed;
         switch(insn.op0_opcode){
             //add options here - reuse, increment, etc
@@ -556,6 +692,8 @@ void instruction_decode(
             case MOVE_ON_RECV:
                 //get expected sequence number for the source rank by incrementing previous sequence number
                 inbound_seqn = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (insn.rx_src * RANK_SIZE) + RANK_INBOUND_SEQ_OFFSET];
+                //messages carry the communicator id along with the source rank
+                rx_src = (exchange_mem[insn.comm_offset + COMM_LOCAL_RANK_OFFSET] & ~COMM_RANK_MASK) | insn.rx_src;
                 bytes_remaining = dm1_rd.total_bytes;
                 ack_insn.release_count = 0;
                 ack_insn.check_dma1_rx = true;
@@ -564,7 +702,7 @@ void instruction_decode(
                 while(bytes_remaining > 0){
                     //emit rx seek queries until one returns true
                     do{
-                        STREAM_WRITE(rxbuf_req, ((rxbuf_signature){.tag=insn.rx_tag, .len=bytes_remaining, .src=insn.rx_src, .seqn=inbound_seqn}));
+                        STREAM_WRITE(rxbuf_req, ((rxbuf_signature){.tag=insn.rx_tag, .len=bytes_remaining, .src=rx_src, .seqn=inbound_seqn}));
                         seek_res = STREAM_READ(rxbuf_ack);
                     }while(!seek_res.valid);
                     dm1_rd.addr = seek_res.addr;
@@ -610,23 +748,34 @@ void instruction_decode(
     if(insn.res_opcode != MOVE_NONE){
         if(insn.res_is_remote){
             if(!dry_run){
+                //destinations of loop iterations wrap around the communicator
+                unsigned int comm_size = exchange_mem[insn.comm_offset + COMM_SIZE_OFFSET];
+                unsigned int dst_rank = (insn.dst_rank >= comm_size) ? (insn.dst_rank - comm_size) : insn.dst_rank;
                 pkt_wr.src_rank = exchange_mem[insn.comm_offset + COMM_LOCAL_RANK_OFFSET];
-                pkt_wr.seqn = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (insn.dst_rank * RANK_SIZE) + RANK_OUTBOUND_SEQ_OFFSET];
-                pkt_wr.dst_sess_id = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (insn.dst_rank * RANK_SIZE) + RANK_SESSION_OFFSET];
-                pkt_wr.max_seg_len = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (insn.dst_rank * RANK_SIZE) + RANK_SEGLEN_OFFSET];
+                pkt_wr.seqn = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (dst_rank * RANK_SIZE) + RANK_OUTBOUND_SEQ_OFFSET];
+                pkt_wr.dst_sess_id = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (dst_rank * RANK_SIZE) + RANK_SESSION_OFFSET];
+                pkt_wr.max_seg_len = exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (dst_rank * RANK_SIZE) + RANK_SEGLEN_OFFSET];
+                pkt_wr.fanout = insn.fanout;
                 pkt_wr.len = insn.res_is_compressed ? total_bytes_compressed : total_bytes_uncompressed;
                 pkt_wr.mpi_tag = insn.mpi_tag;
                 pkt_wr.to_stream = (insn.res_opcode == MOVE_STREAM);
+                pkt_wr.msg_type = insn.msg_type;
+                pkt_wr.rndzv_arg = insn.rndzv_arg;
+                //rendezvous payload bypasses the rx buffers, so it is not limited by their size
+                if(insn.msg_type == MSG_RNDZV_DATA){
+                    pkt_wr.max_seg_len = DMA_MAX_BTT;
+                }
                 STREAM_WRITE(eth_insn, pkt_wr);
                 ack_insn.check_eth_tx = true;
-                //if we're not sending to a remote stream, update sequence number
-                if(!pkt_wr.to_stream){
+                //if we're sending an in-order message to remote memory, update sequence number
+                //rendezvous CTS, payload, FIN and RMA messages are out of band and do not consume sequence numbers
+                if(!pkt_wr.to_stream && (insn.msg_type == MSG_EAGER || insn.msg_type == MSG_RNDZV_RTS)){
                     if(pkt_wr.len <= pkt_wr.max_seg_len){
                         nsegments = 1;
                     } else{
                         nsegments = ((pkt_wr.len+pkt_wr.max_seg_len-1)/pkt_wr.max_seg_len);
                     }
-                    exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (insn.dst_rank * RANK_SIZE) + RANK_OUTBOUND_SEQ_OFFSET] = pkt_wr.seqn+nsegments;
+                    exchange_mem[insn.comm_offset + COMM_RANKS_OFFSET + (dst_rank * RANK_SIZE) + RANK_OUTBOUND_SEQ_OFFSET] = pkt_wr.seqn+nsegments;
                 }
 #ifndef ACCL_SYNTHESIS
                 std::stringstream ss;
@@ -685,6 +834,8 @@ void instruction_retire(
     STREAM<ap_axiu<32,0,0,0> > &error
 ){
 #pragma HLS PIPELINE II=1 style=flp
+    //errors of the iterations of a loop, reported with its last iteration
+    static ap_uint<32> merged_err = NO_ERROR;
 
     if(STREAM_IS_EMPTY(instruction)) return;
     
@@ -692,6 +843,11 @@ void instruction_retire(
     ap_axiu<32,0,0,0> err;
     err.last = 1;
     err.data = NO_ERROR;
+    if(insn.report_credits){
+        err.data = DMA_MOVER_QUEUE_DEPTH;
+        STREAM_WRITE(error, err);
+        return;
+    }
     if(insn.check_dma0_rx) err.data |= STREAM_READ(dma0_rx_err);
     if(insn.check_dma1_rx){
         err.data |= STREAM_READ(dma1_rx_err);
@@ -710,6 +866,12 @@ void instruction_retire(
     if(insn.check_dma1_tx) err.data |= STREAM_READ(dma1_tx_err);
     if(insn.check_eth_tx) err.data |= STREAM_READ(eth_tx_err);
     if(insn.check_strm_tx) err.data |= STREAM_READ(strm_tx_err);
+    if(insn.merge_next){
+        merged_err |= err.data;
+        return;
+    }
+    err.data |= merged_err;
+    merged_err = NO_ERROR;
     STREAM_WRITE(error, err);
 }
 
@@ -778,64 +940,64 @@ void dma_mover(
 #pragma HLS INTERFACE ap_ctrl_none port=return
 #pragma HLS DATAFLOW disable_start_propagation
 
-    //NOTE: we implement 16-deep in general and a 64-deep fifo for release indexes
+    //NOTE: we implement DMA_MOVER_QUEUE_DEPTH-deep in general and a 64-deep fifo for release indexes
     //which implies the maximum message size is 64 segments,
     //and each segment is up to the size of the RX spares
 #ifdef ACCL_SYNTHESIS
     static hls::stream<move_instruction> instruction;
-    #pragma HLS STREAM variable=instruction depth=16
+    #pragma HLS STREAM variable=instruction depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_instruction> dma0_read_insn;
-    #pragma HLS STREAM variable=dma0_read_insn depth=16
+    #pragma HLS STREAM variable=dma0_read_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_instruction> dma1_read_insn;
-    #pragma HLS STREAM variable=dma1_read_insn depth=16
+    #pragma HLS STREAM variable=dma1_read_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_instruction> dma1_write_insn;
-    #pragma HLS STREAM variable=dma1_write_insn depth=16
+    #pragma HLS STREAM variable=dma1_write_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<packetizer_instruction> eth_insn;
-    #pragma HLS STREAM variable=eth_insn depth=16
+    #pragma HLS STREAM variable=eth_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<router_instruction> router_insn;
-    #pragma HLS STREAM variable=router_insn depth=16
+    #pragma HLS STREAM variable=router_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<move_ack_instruction> err_instruction;
-    #pragma HLS STREAM variable=err_instruction depth=16
+    #pragma HLS STREAM variable=err_instruction depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_ack_instruction> dma0_read_ack_insn;
-    #pragma HLS STREAM variable=dma0_read_ack_insn depth=16
+    #pragma HLS STREAM variable=dma0_read_ack_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_ack_instruction> dma1_read_ack_insn;
-    #pragma HLS STREAM variable=dma1_read_ack_insn depth=16
+    #pragma HLS STREAM variable=dma1_read_ack_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<datamover_ack_instruction> dma1_write_ack_insn;
-    #pragma HLS STREAM variable=dma1_write_ack_insn depth=16
+    #pragma HLS STREAM variable=dma1_write_ack_insn depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > dma0_read_error;
-    #pragma HLS STREAM variable=dma0_read_error depth=16
+    #pragma HLS STREAM variable=dma0_read_error depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > dma1_read_error;
-    #pragma HLS STREAM variable=dma1_read_error depth=16
+    #pragma HLS STREAM variable=dma1_read_error depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > dma1_write_error;
-    #pragma HLS STREAM variable=dma1_write_error depth=16
+    #pragma HLS STREAM variable=dma1_write_error depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<packetizer_ack_instruction> eth_tx_ack_instruction;
-    #pragma HLS STREAM variable=eth_tx_ack_instruction depth=16
+    #pragma HLS STREAM variable=eth_tx_ack_instruction depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > eth_tx_error;
-    #pragma HLS STREAM variable=eth_tx_error depth=16
+    #pragma HLS STREAM variable=eth_tx_error depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > strm_tx_ack_instruction;
-    #pragma HLS STREAM variable=strm_tx_ack_instruction depth=16
+    #pragma HLS STREAM variable=strm_tx_ack_instruction depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > strm_tx_error;
-    #pragma HLS STREAM variable=strm_tx_error depth=16
+    #pragma HLS STREAM variable=strm_tx_error depth=DMA_MOVER_QUEUE_DEPTH
     static hls::stream<ap_uint<32> > rxbuf_release_idx;
     #pragma HLS STREAM variable=rxbuf_release_idx depth=64
 #else
-    static hlslib::Stream<move_instruction, 16> instruction;
-    static hlslib::Stream<datamover_instruction, 16> dma0_read_insn;
-    static hlslib::Stream<datamover_instruction, 16> dma1_read_insn;
-    static hlslib::Stream<datamover_instruction, 16> dma1_write_insn;
-    static hlslib::Stream<packetizer_instruction, 16> eth_insn;
-    static hlslib::Stream<router_instruction, 16> router_insn;
-    static hlslib::Stream<move_ack_instruction, 16> err_instruction;
-    static hlslib::Stream<datamover_ack_instruction, 16> dma0_read_ack_insn;
-    static hlslib::Stream<datamover_ack_instruction, 16> dma1_read_ack_insn;
-    static hlslib::Stream<datamover_ack_instruction, 16> dma1_write_ack_insn;
-    static hlslib::Stream<ap_uint<32>, 16> dma0_read_error;
-    static hlslib::Stream<ap_uint<32>, 16> dma1_read_error;
-    static hlslib::Stream<ap_uint<32>, 16> dma1_write_error;
-    static hlslib::Stream<packetizer_ack_instruction, 16> eth_tx_ack_instruction;
-    static hlslib::Stream<ap_uint<32>, 16> eth_tx_error;
-    static hlslib::Stream<ap_uint<32>, 16> strm_tx_ack_instruction;
-    static hlslib::Stream<ap_uint<32>, 16> strm_tx_error;
+    static hlslib::Stream<move_instruction, DMA_MOVER_QUEUE_DEPTH> instruction;
+    static hlslib::Stream<datamover_instruction, DMA_MOVER_QUEUE_DEPTH> dma0_read_insn;
+    static hlslib::Stream<datamover_instruction, DMA_MOVER_QUEUE_DEPTH> dma1_read_insn;
+    static hlslib::Stream<datamover_instruction, DMA_MOVER_QUEUE_DEPTH> dma1_write_insn;
+    static hlslib::Stream<packetizer_instruction, DMA_MOVER_QUEUE_DEPTH> eth_insn;
+    static hlslib::Stream<router_instruction, DMA_MOVER_QUEUE_DEPTH> router_insn;
+    static hlslib::Stream<move_ack_instruction, DMA_MOVER_QUEUE_DEPTH> err_instruction;
+    static hlslib::Stream<datamover_ack_instruction, DMA_MOVER_QUEUE_DEPTH> dma0_read_ack_insn;
+    static hlslib::Stream<datamover_ack_instruction, DMA_MOVER_QUEUE_DEPTH> dma1_read_ack_insn;
+    static hlslib::Stream<datamover_ack_instruction, DMA_MOVER_QUEUE_DEPTH> dma1_write_ack_insn;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> dma0_read_error;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> dma1_read_error;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> dma1_write_error;
+    static hlslib::Stream<packetizer_ack_instruction, DMA_MOVER_QUEUE_DEPTH> eth_tx_ack_instruction;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> eth_tx_error;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> strm_tx_ack_instruction;
+    static hlslib::Stream<ap_uint<32>, DMA_MOVER_QUEUE_DEPTH> strm_tx_error;
     static hlslib::Stream<ap_uint<32>, 64> rxbuf_release_idx;
 #endif
 
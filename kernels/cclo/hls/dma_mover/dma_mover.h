@@ -25,6 +25,10 @@
 #include "rxbuf_offload.h"
 #include "ccl_offload_control.h"
 
+//depth of the internal instruction queues, which is also the number of moves
+//advertised to the firmware as credits: it may issue this many moves ahead of reading their results
+#define DMA_MOVER_QUEUE_DEPTH 16
+
 typedef struct {
     //13+4 bits indicating what we're doing
     ap_uint<3> op0_opcode;
@@ -35,6 +39,7 @@ typedef struct {
     bool op1_is_compressed;
     bool res_is_compressed;
     ap_uint<4> func_id;//up to 16 functions
+    ap_uint<4> msg_type;//eager, rendezvous step or RMA message, remote results only
 
     //count
     unsigned int count;
@@ -57,6 +62,11 @@ typedef struct {
 
     unsigned int mpi_tag;//required only on remote result
     unsigned int dst_rank;//required only on remote result
+    ap_uint<64> rndzv_arg;//required only on remote result with a rendezvous msg_type
+
+    bool credit_query;//no movement, answer with the queue depth
+    bool merge_result;//iteration of a loop, its result is merged into that of the next move
+    ap_uint<2> fanout;//multicast loop: the first iteration records its data at the fan-out block, the others replay it
 } move_instruction;
 
 typedef struct{
@@ -66,6 +76,8 @@ typedef struct{
     bool check_eth_tx;
     bool check_strm_tx;
     bool release_rxbuf;
+    bool report_credits;
+    bool merge_next;
     ap_uint<32> release_count = 0;
 } move_ack_instruction;
 
@@ -106,6 +118,9 @@ typedef struct{
     unsigned int mpi_tag;
     unsigned int max_seg_len;
     bool to_stream;
+    unsigned int msg_type;
+    ap_uint<64> rndzv_arg;
+    ap_uint<2> fanout;
 } packetizer_instruction;
 
 typedef struct{
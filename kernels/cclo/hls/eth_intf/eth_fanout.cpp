@@ -0,0 +1,69 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+#include "eth_intf.h"
+
+using namespace std;
+
+//sits in front of the packetizer and forwards its commands and data; data of recorded
+//messages is also kept in a buffer, from which replayed messages take their data instead
+//of the input, so a multicast message is read from memory once for all its destinations
+void eth_fanout(
+	STREAM<stream_word > & in,
+	STREAM<stream_word > & out,
+	STREAM<eth_header> & cmd_in,
+	STREAM<eth_header> & cmd_out
+)
+{
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE axis register both port=cmd_in
+#pragma HLS INTERFACE axis register both port=cmd_out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+	unsigned const bytes_per_word = DATA_WIDTH/8;
+
+	static ap_uint<DATA_WIDTH> buffer[FANOUT_BUFFER_WORDS];
+#pragma HLS BIND_STORAGE variable=buffer type=RAM_2P impl=URAM
+	static unsigned int wr_ptr = 0;
+	static unsigned int rd_ptr = 0;
+
+	eth_header cmdword = STREAM_READ(cmd_in);
+	unsigned int nwords = (cmdword.count + bytes_per_word - 1) / bytes_per_word;
+	//segments of a message follow each other in the buffer
+	if(cmdword.fanout_first){
+		wr_ptr = (cmdword.fanout == FANOUT_RECORD) ? 0 : wr_ptr;
+		rd_ptr = 0;
+	}
+	STREAM_WRITE(cmd_out, cmdword);
+
+	for(unsigned int i = 0; i < nwords; i++){
+	#pragma HLS PIPELINE II=1
+		stream_word outword;
+		if(cmdword.fanout == FANOUT_REPLAY){
+			outword.data = buffer[rd_ptr++];
+			outword.keep = -1;
+			outword.dest = cmdword.dst;
+			outword.last = (i == nwords - 1);
+		} else{
+			outword = STREAM_READ(in);
+			if(cmdword.fanout == FANOUT_RECORD && wr_ptr < FANOUT_BUFFER_WORDS){
+				buffer[wr_ptr++] = outword.data;
+			}
+		}
+		STREAM_WRITE(out, outword);
+	}
+}
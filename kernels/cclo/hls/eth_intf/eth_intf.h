@@ -50,7 +50,52 @@ typedef ap_axiu<DWIDTH8, 0, 0, 0> pkt8;
 #define HEADER_STRM_END	   HEADER_STRM_START+31
 #define HEADER_DST_START   HEADER_STRM_END+1
 #define HEADER_DST_END	   HEADER_DST_START+15
-#define HEADER_LENGTH      HEADER_DST_END+1
+//total byte count of the message a segment belongs to, identical in all its segments
+#define HEADER_MSG_START   HEADER_DST_END+1
+#define HEADER_MSG_END	   HEADER_MSG_START+31
+//message type (eager or one of the rendezvous steps, see ccl_offload_control.h)
+#define HEADER_TYPE_START  HEADER_MSG_END+1
+#define HEADER_TYPE_END	   HEADER_TYPE_START+7
+//rendezvous address: posted buffer in a CTS, write address of a rendezvous payload segment
+#define HEADER_ADDR_START  HEADER_TYPE_END+1
+#define HEADER_ADDR_END	   HEADER_ADDR_START+63
+#define HEADER_LENGTH      HEADER_ADDR_END+1
+
+//multicast at the fan-out block in front of the packetizer: the data of a recorded message is kept
+//and replayed for the messages which follow it to other destinations, so it is read once.
+//The fan-out state is carried along with the header but not sent with it
+#define FANOUT_NONE   0
+#define FANOUT_RECORD 1
+#define FANOUT_REPLAY 2
+//capacity of the fan-out buffer, in datapath words; multicast messages must fit
+//(MULTICAST_MAX_BYTES in ccl_offload_control.h)
+#define FANOUT_BUFFER_WORDS 4096
+
+//selective-repeat reliability layer of the UDP path, between the packetizers and the network.
+//Every datagram starts with a reliability word: its type, its sequence number in the stream of
+//datagrams to the peer (DATA only), the next sequence number expected from the peer and a bitmap
+//of the datagrams after it already received. The peer is the TDEST of the datagram, on egress
+//and on ingress
+#define UDP_REL_DATA 1
+#define UDP_REL_ACK  2
+#define UDP_REL_NACK 3
+#define UDP_REL_TYPE_START 0
+#define UDP_REL_TYPE_END   7
+#define UDP_REL_SEQ_START  UDP_REL_TYPE_END+1
+#define UDP_REL_SEQ_END    UDP_REL_SEQ_START+31
+#define UDP_REL_ACK_START  UDP_REL_SEQ_END+1
+#define UDP_REL_ACK_END    UDP_REL_ACK_START+31
+#define UDP_REL_SACK_START UDP_REL_ACK_END+1
+#define UDP_REL_SACK_END   UDP_REL_SACK_START+UDP_REL_WINDOW-1
+//peers (ranks on UDP) and datagrams in flight per peer, a power of two
+#define UDP_REL_MAX_PEERS 16
+#define UDP_REL_WINDOW 8
+//longest datagram kept for retransmission, in datapath words; longer datagrams are split
+#define UDP_REL_MAX_PKT_WORDS 32
+//invocations without acknowledgement before the unacknowledged datagrams to a peer are retransmitted
+#ifndef UDP_REL_TIMEOUT
+#define UDP_REL_TIMEOUT (1<<20)
+#endif
 
 struct eth_header{
 	ap_uint<32> count;
@@ -59,14 +104,24 @@ struct eth_header{
 	ap_uint<32> seqn;
 	ap_uint<32> strm;
 	ap_uint<16> dst;
-	eth_header() : count(0), tag(0), src(0), seqn(0), strm(0), dst(0) {}
+	ap_uint<32> msg_count;
+	ap_uint<8> msg_type;
+	ap_uint<64> addr;
+	ap_uint<2> fanout;
+	bool fanout_first;//first segment of a recorded or replayed message
+	eth_header() : count(0), tag(0), src(0), seqn(0), strm(0), dst(0), msg_count(0), msg_type(0), addr(0), fanout(FANOUT_NONE), fanout_first(false) {}
 	eth_header(ap_uint<HEADER_LENGTH> in) : 
 		count(in(HEADER_COUNT_END, HEADER_COUNT_START)),
 		tag(in(HEADER_TAG_END, HEADER_TAG_START)),
 		src(in(HEADER_SRC_END, HEADER_SRC_START)),
 		seqn(in(HEADER_SEQ_END, HEADER_SEQ_START)),
 		strm(in(HEADER_STRM_END, HEADER_STRM_START)),
-		dst(in(HEADER_DST_END, HEADER_DST_START)) {}
+		dst(in(HEADER_DST_END, HEADER_DST_START)),
+		msg_count(in(HEADER_MSG_END, HEADER_MSG_START)),
+		msg_type(in(HEADER_TYPE_END, HEADER_TYPE_START)),
+		addr(in(HEADER_ADDR_END, HEADER_ADDR_START)),
+		fanout(FANOUT_NONE),
+		fanout_first(false) {}
 	operator ap_uint<HEADER_LENGTH>(){
 		ap_uint<HEADER_LENGTH> ret;
 		ret(HEADER_COUNT_END, HEADER_COUNT_START) = count;
@@ -75,6 +130,9 @@ struct eth_header{
         ret(HEADER_SEQ_END, HEADER_SEQ_START) = seqn;
         ret(HEADER_STRM_END, HEADER_STRM_START) = strm;
 		ret(HEADER_DST_END, HEADER_DST_START) = dst;
+		ret(HEADER_MSG_END, HEADER_MSG_START) = msg_count;
+		ret(HEADER_TYPE_END, HEADER_TYPE_START) = msg_type;
+		ret(HEADER_ADDR_END, HEADER_ADDR_START) = addr;
 		return ret;
 	}
 };
@@ -84,6 +142,21 @@ typedef struct{
 	ap_uint<16> length;
 } eth_notification;
 
+//TCP sessions tracked by the receive path (tcp_rxHandler, tcp_depacketizer, rxbuf_session), which
+//drops data of sessions at or beyond it; per-session tables deeper than SESSION_TABLE_URAM_DEPTH
+//are held in URAM, which the bitstream does not initialize, so they are cleared after reset
+#ifndef MAX_SESSIONS
+#define MAX_SESSIONS 4096
+#endif
+#define SESSION_TABLE_URAM_DEPTH 1024
+
+void eth_fanout(
+	STREAM<stream_word > & in,
+	STREAM<stream_word > & out,
+	STREAM<eth_header> & cmd_in,
+	STREAM<eth_header> & cmd_out
+);
+
 void udp_packetizer(
 	STREAM<stream_word > & in,
 	STREAM<stream_word > & out,
@@ -101,6 +174,13 @@ void tcp_packetizer(
 	unsigned int max_pktsize
 );
 
+void udp_reliability(
+	STREAM<stream_word > & tx_in,
+	STREAM<stream_word > & tx_out,
+	STREAM<stream_word > & rx_in,
+	STREAM<stream_word > & rx_out
+);
+
 void udp_depacketizer(
 	STREAM<stream_word > & in,
 	STREAM<stream_word > & out,
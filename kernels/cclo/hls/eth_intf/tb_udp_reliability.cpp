@@ -0,0 +1,147 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "eth_intf.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+#define NPEERS 3
+#define NDATAGRAMS 60
+//percentages of datagrams dropped and delayed past the next one by the channel
+#define DROP_PCT 10
+#define REORDER_PCT 10
+
+typedef vector<stream_word> datagram;
+
+//payload word w of datagram n to peer p
+ap_uint<DATA_WIDTH> payload(unsigned int p, unsigned int n, unsigned int w){
+    ap_uint<DATA_WIDTH> ret = 0;
+    ret(31,0) = (p << 24) | (n << 8) | w;
+    ret(DATA_WIDTH-1, DATA_WIDTH-32) = ~ret(31,0);
+    return ret;
+}
+
+datagram make_datagram(unsigned int p, unsigned int n){
+    datagram ret;
+    //every fifth datagram is too long to keep, and is split by the block
+    unsigned int nwords = (n % 5 == 4) ? (2*UDP_REL_MAX_PKT_WORDS + 1 + p) : (1 + (n * 7 + p) % 24);
+    for(unsigned int w = 0; w < nwords; w++){
+        stream_word word;
+        word.data = payload(p, n, w);
+        word.keep = (w == nwords - 1) ? (ap_uint<DATA_WIDTH/8>)((1ULL << (1 + n % 63)) - 1) : (ap_uint<DATA_WIDTH/8>)(-1);
+        word.dest = p;
+        word.last = (w == nwords - 1);
+        ret.push_back(word);
+    }
+    return ret;
+}
+
+//the block talks to itself: datagrams it sends to a peer come back as if sent by that peer,
+//so the data of each peer must come out in order, while its acknowledgements drive the sender.
+//Split datagrams come out in parts, so the words of each peer are compared, with every
+//datagram ending where it was sent
+int main(){
+    STREAM<stream_word > tx_in, tx_out, rx_in, rx_out;
+    datagram sent_words[NPEERS];
+    datagram received[NPEERS];
+    datagram delayed, current;
+    int nerrors = 0;
+    unsigned int ndropped = 0, nreordered = 0;
+
+    srand(42);
+    for(unsigned int n = 0; n < NDATAGRAMS; n++){
+        for(unsigned int p = 0; p < NPEERS; p++){
+            for(auto &word : make_datagram(p, n)){
+                STREAM_WRITE(tx_in, word);
+                sent_words[p].push_back(word);
+            }
+        }
+    }
+
+    bool done = false;
+    for(unsigned long cycle = 0; cycle < 100000000 && !done; cycle++){
+        udp_reliability(tx_in, tx_out, rx_in, rx_out);
+        //lossy, reordering channel
+        while(!STREAM_IS_EMPTY(tx_out)){
+            stream_word word = STREAM_READ(tx_out);
+            current.push_back(word);
+            if(!word.last){
+                continue;
+            }
+            int r = rand() % 100;
+            if(r < DROP_PCT){
+                ndropped++;
+            } else if(r < DROP_PCT + REORDER_PCT && delayed.empty()){
+                delayed = current;
+                nreordered++;
+            } else{
+                for(auto &w : current){
+                    STREAM_WRITE(rx_in, w);
+                }
+                for(auto &w : delayed){
+                    STREAM_WRITE(rx_in, w);
+                }
+                delayed.clear();
+            }
+            current.clear();
+        }
+        //nothing else in flight, let a delayed datagram through
+        if(!delayed.empty() && STREAM_IS_EMPTY(rx_in)){
+            for(auto &w : delayed){
+                STREAM_WRITE(rx_in, w);
+            }
+            delayed.clear();
+        }
+        while(!STREAM_IS_EMPTY(rx_out)){
+            stream_word word = STREAM_READ(rx_out);
+            received[(unsigned int)word.dest].push_back(word);
+        }
+        done = true;
+        for(unsigned int p = 0; p < NPEERS; p++){
+            done &= (received[p].size() >= sent_words[p].size());
+        }
+    }
+
+    for(unsigned int p = 0; p < NPEERS; p++){
+        if(received[p].size() != sent_words[p].size()){
+            cout << "Peer " << p << ": received " << received[p].size() << " words, expected " << sent_words[p].size() << endl;
+            nerrors++;
+            continue;
+        }
+        for(unsigned int w = 0; w < sent_words[p].size(); w++){
+            if(received[p][w].data != sent_words[p][w].data || received[p][w].keep != sent_words[p][w].keep ||
+                (sent_words[p][w].last && !received[p][w].last)){
+                cout << "Peer " << p << ": word " << w << " corrupted or out of order" << endl;
+                nerrors++;
+                break;
+            }
+        }
+    }
+    if(!STREAM_IS_EMPTY(rx_out)){
+        cout << "Unexpected data delivered" << endl;
+        nerrors++;
+    }
+
+    cout << "Channel dropped " << ndropped << " and reordered " << nreordered << " datagrams" << endl;
+    if(nerrors == 0){
+        cout << "UDP reliability test passed" << endl;
+    }
+    return nerrors;
+}
@@ -55,8 +55,14 @@ void tcp_depacketizer(
 #pragma HLS PIPELINE II=1 style=flp
 	
 	unsigned constexpr bytes_per_word = DATA_WIDTH/8;
-	static unsigned int remaining[1024] = {0};//one RAMB36 for max 1024 sessions
-	static ap_uint<DEST_WIDTH> target_strm[1024] = {0};//one RAMB18 for max 1024 sessions
+	//tcp_rxHandler drops sessions at or beyond MAX_SESSIONS, so session ids here index the tables directly
+	static unsigned int remaining[MAX_SESSIONS];
+	static ap_uint<DEST_WIDTH> target_strm[MAX_SESSIONS];
+#if MAX_SESSIONS > SESSION_TABLE_URAM_DEPTH
+#pragma HLS BIND_STORAGE variable=remaining type=RAM_2P impl=URAM
+#pragma HLS BIND_STORAGE variable=target_strm type=RAM_2P impl=URAM
+#endif
+	static unsigned int nclear = 0;
 
 	static eth_notification notif;
 	static bool continue_notif = false;
@@ -68,6 +74,14 @@ void tcp_depacketizer(
 	stream_word inword;
 	eth_header hdr;
 
+	//clear one session per call after reset
+	if(nclear < MAX_SESSIONS){
+		remaining[nclear] = 0;
+		target_strm[nclear] = 0;
+		nclear++;
+		return;
+	}
+
 	if(STREAM_IS_EMPTY(notif_in) && STREAM_IS_EMPTY(in)) return;
 
 	//get new notification unless we're continuing an old one
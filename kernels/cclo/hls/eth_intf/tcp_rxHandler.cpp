@@ -107,7 +107,10 @@ void requestFSM(
         ap_uint<32> ipAddress = tcp_notification_pkt.data(63,32);
         ap_uint<16> dstPort = tcp_notification_pkt.data(79,64);
         ap_uint<1> closed = tcp_notification_pkt.data(80,80);
-        STREAM_WRITE(m_notif_out, ((eth_notification){.session_id=sessionID, .length=length}));
+        //data of sessions beyond the session tables is still read from the stack, but dropped
+        if(sessionID < MAX_SESSIONS){
+            STREAM_WRITE(m_notif_out, ((eth_notification){.session_id=sessionID, .length=length}));
+        }
 #ifndef ACCL_SYNTHESIS
         std::stringstream ss;
         ss << "TCP RX Handler: Requesting data length=" << length << "\n";
@@ -141,18 +144,22 @@ void consumeFSM(STREAM<pkt16>& s_axis_tcp_rx_meta,
     stream_word currWord;
     enum consumeFsmStateType {WAIT_PKG, CONSUME};
     static consumeFsmStateType  serverFsmState = WAIT_PKG;
+    static bool drop = false;
 
     switch (serverFsmState)
     {
     case WAIT_PKG:
         if (!STREAM_IS_EMPTY(s_axis_tcp_rx_meta) && !STREAM_IS_EMPTY(s_axis_tcp_rx_data))
         {
-            STREAM_READ(s_axis_tcp_rx_meta);
+            drop = (STREAM_READ(s_axis_tcp_rx_meta).data(15,0) >= MAX_SESSIONS);
             stream_word receiveWord = STREAM_READ(s_axis_tcp_rx_data);
             currWord.data = receiveWord.data;
             currWord.keep = receiveWord.keep;
             currWord.last = receiveWord.last;
-            STREAM_WRITE(m_data_out, currWord);
+            if (!drop)
+            {
+                STREAM_WRITE(m_data_out, currWord);
+            }
             if (!receiveWord.last)
             {
                 serverFsmState = CONSUME;
@@ -171,7 +178,10 @@ void consumeFSM(STREAM<pkt16>& s_axis_tcp_rx_meta,
             currWord.data = receiveWord.data;
             currWord.keep = receiveWord.keep;
             currWord.last = receiveWord.last;
-            STREAM_WRITE(m_data_out, currWord);
+            if (!drop)
+            {
+                STREAM_WRITE(m_data_out, currWord);
+            }
             if (receiveWord.last)
             {
                 bool decrReq = true;
@@ -258,6 +268,7 @@ void tcp_rxHandler(
     stream_word currWord;
     enum consumeFsmStateType {WAIT_PKG, CONSUME};
     static consumeFsmStateType  serverFsmState = WAIT_PKG;
+    static bool drop = false;
 
     if (!STREAM_IS_EMPTY(s_axis_tcp_notification))
     {
@@ -267,7 +278,10 @@ void tcp_rxHandler(
         ap_uint<32> ipAddress = tcp_notification_pkt.data(63,32);
         ap_uint<16> dstPort = tcp_notification_pkt.data(79,64);
         ap_uint<1> closed = tcp_notification_pkt.data(80,80);
-        STREAM_WRITE(m_notif_out, (eth_notification){.session_id=sessionID, .length=length});
+        //data of sessions beyond the session tables is still read from the stack, but dropped
+        if(sessionID < MAX_SESSIONS){
+            STREAM_WRITE(m_notif_out, ((eth_notification){.session_id=sessionID, .length=length}));
+        }
 
         // cout<<"notification session "<<sessionID<<" length "<<length<<endl;
 
@@ -285,12 +299,15 @@ void tcp_rxHandler(
     case WAIT_PKG:
         if (!STREAM_IS_EMPTY(s_axis_tcp_rx_meta) && !STREAM_IS_EMPTY(s_axis_tcp_rx_data))
         {
-            STREAM_READ(s_axis_tcp_rx_meta);
+            drop = (STREAM_READ(s_axis_tcp_rx_meta).data(15,0) >= MAX_SESSIONS);
             stream_word receiveWord = STREAM_READ(s_axis_tcp_rx_data);
             currWord.data = receiveWord.data;
             currWord.keep = receiveWord.keep;
             currWord.last = receiveWord.last;
-            STREAM_WRITE(m_data_out, currWord);
+            if (!drop)
+            {
+                STREAM_WRITE(m_data_out, currWord);
+            }
             if (!receiveWord.last)
             {
                 serverFsmState = CONSUME;
@@ -304,7 +321,10 @@ void tcp_rxHandler(
             currWord.data = receiveWord.data;
             currWord.keep = receiveWord.keep;
             currWord.last = receiveWord.last;
-            STREAM_WRITE(m_data_out, currWord);
+            if (!drop)
+            {
+                STREAM_WRITE(m_data_out, currWord);
+            }
             if (receiveWord.last)
             {
                 serverFsmState = WAIT_PKG;
@@ -0,0 +1,304 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+#include "eth_intf.h"
+
+using namespace std;
+
+//datagram slots of the tx replay and the rx reorder buffer, one per window position of each peer
+#define UDP_REL_SLOTS (UDP_REL_MAX_PEERS*UDP_REL_WINDOW)
+
+ap_uint<DATA_WIDTH> rel_header(ap_uint<8> type, ap_uint<32> seqn, ap_uint<32> ack, ap_uint<UDP_REL_WINDOW> sack){
+	ap_uint<DATA_WIDTH> ret = 0;
+	ret(UDP_REL_TYPE_END, UDP_REL_TYPE_START) = type;
+	ret(UDP_REL_SEQ_END, UDP_REL_SEQ_START) = seqn;
+	ret(UDP_REL_ACK_END, UDP_REL_ACK_START) = ack;
+	ret(UDP_REL_SACK_END, UDP_REL_SACK_START) = sack;
+	return ret;
+}
+
+//bit i is set if datagram expected+i has been received; received is indexed by window slot
+ap_uint<UDP_REL_WINDOW> rel_sack(ap_uint<32> expected, ap_uint<UDP_REL_WINDOW> received){
+	ap_uint<UDP_REL_WINDOW> ret;
+	for(unsigned int i = 0; i < UDP_REL_WINDOW; i++){
+	#pragma HLS UNROLL
+		ret[i] = received[(expected + i) % UDP_REL_WINDOW];
+	}
+	return ret;
+}
+
+//selective-repeat reliability for the UDP path. Datagrams from the packetizer are numbered per peer
+//and kept until acknowledged, at most UDP_REL_WINDOW per peer; datagrams from the network are delivered
+//to the depacketizer in order, those arriving early are kept until the gap before them is filled.
+//Receivers acknowledge cumulatively with a bitmap of the datagrams received past the gap, in an ACK
+//and on all data to the peer, and send a NACK for the first datagram missing from a gap.
+//Senders retransmit datagrams on NACK and, if not selectively acknowledged, on timeout.
+//Datagrams from the packetizer longer than UDP_REL_MAX_PKT_WORDS are sent as several numbered datagrams,
+//which the depacketizer reassembles like any other message split over datagrams
+void udp_reliability(
+	STREAM<stream_word > & tx_in,
+	STREAM<stream_word > & tx_out,
+	STREAM<stream_word > & rx_in,
+	STREAM<stream_word > & rx_out
+)
+{
+#pragma HLS INTERFACE axis register both port=tx_in
+#pragma HLS INTERFACE axis register both port=tx_out
+#pragma HLS INTERFACE axis register both port=rx_in
+#pragma HLS INTERFACE axis register both port=rx_out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+	//datagrams [tx_base, tx_next) to a peer are unacknowledged and kept for retransmission;
+	//per window slot, those selectively acknowledged are flagged in tx_sacked, those due in tx_retx
+	static ap_uint<DATA_WIDTH> tx_buf[UDP_REL_SLOTS*UDP_REL_MAX_PKT_WORDS];
+#pragma HLS BIND_STORAGE variable=tx_buf type=RAM_2P impl=URAM
+	static ap_uint<8> tx_len[UDP_REL_SLOTS];
+	static ap_uint<DATA_WIDTH/8> tx_keep[UDP_REL_SLOTS];
+	static ap_uint<32> tx_base[UDP_REL_MAX_PEERS];
+	static ap_uint<32> tx_next[UDP_REL_MAX_PEERS];
+	static ap_uint<UDP_REL_WINDOW> tx_sacked[UDP_REL_MAX_PEERS];
+	static ap_uint<UDP_REL_WINDOW> tx_retx[UDP_REL_MAX_PEERS];
+	static ap_uint<32> tx_timer[UDP_REL_MAX_PEERS];
+	//datagrams from a peer are delivered up to rx_expected; per window slot, rx_received flags
+	//those after it kept in the reorder buffer. rx_gap is set once the gap has been reported
+	static ap_uint<DATA_WIDTH> rx_buf[UDP_REL_SLOTS*UDP_REL_MAX_PKT_WORDS];
+#pragma HLS BIND_STORAGE variable=rx_buf type=RAM_2P impl=URAM
+	static ap_uint<8> rx_len[UDP_REL_SLOTS];
+	static ap_uint<DATA_WIDTH/8> rx_keep[UDP_REL_SLOTS];
+	static ap_uint<32> rx_expected[UDP_REL_MAX_PEERS];
+	static ap_uint<UDP_REL_WINDOW> rx_received[UDP_REL_MAX_PEERS];
+	static bool rx_gap[UDP_REL_MAX_PEERS];
+	static ap_uint<8> rx_ack_pending[UDP_REL_MAX_PEERS];
+	//first word of a datagram from the packetizer, held while the window to its peer is full
+	static bool held = false;
+	static stream_word held_word;
+	static ap_uint<32> now = 0;
+
+	stream_word inword, outword;
+	unsigned int peer, slot, nwords;
+	now++;
+
+	//process one datagram from the network
+	if(!STREAM_IS_EMPTY(rx_in)){
+		inword = STREAM_READ(rx_in);
+		peer = inword.dest;
+		ap_uint<8> type = inword.data(UDP_REL_TYPE_END, UDP_REL_TYPE_START);
+		ap_uint<32> seqn = inword.data(UDP_REL_SEQ_END, UDP_REL_SEQ_START);
+		ap_uint<32> ack = inword.data(UDP_REL_ACK_END, UDP_REL_ACK_START);
+		ap_uint<UDP_REL_WINDOW> sack = inword.data(UDP_REL_SACK_END, UDP_REL_SACK_START);
+		if(peer >= UDP_REL_MAX_PEERS){
+			//unknown peer, drop
+			while(!inword.last){
+				inword = STREAM_READ(rx_in);
+			}
+			return;
+		}
+		//acknowledgements, carried by every datagram: retire datagrams before ack, flag those sacked
+		ap_uint<32> progress = ack - tx_base[peer];
+		ap_uint<32> outstanding = tx_next[peer] - tx_base[peer];
+		if(progress <= outstanding){
+			for(unsigned int i = 0; i < UDP_REL_WINDOW; i++){
+			#pragma HLS UNROLL
+				slot = (tx_base[peer] + i) % UDP_REL_WINDOW;
+				if(i < progress){
+					tx_sacked[peer][slot] = 0;
+					tx_retx[peer][slot] = 0;
+				} else if(i - progress < outstanding - progress && sack[i - progress]){
+					tx_sacked[peer][slot] = 1;
+					tx_retx[peer][slot] = 0;
+				}
+			}
+			if(progress > 0){
+				tx_base[peer] = ack;
+				tx_timer[peer] = now;
+			}
+			//a NACK asks for the datagram at ack again
+			if(type == UDP_REL_NACK && ack != tx_next[peer]){
+				tx_retx[peer][ack % UDP_REL_WINDOW] = 1;
+			}
+		}
+		if(type == UDP_REL_DATA){
+			ap_uint<32> offset = seqn - rx_expected[peer];
+			if(offset == 0){
+				//in order: deliver, then whatever was waiting on it
+				do{
+					inword = STREAM_READ(rx_in);
+					STREAM_WRITE(rx_out, inword);
+				} while(!inword.last);
+				rx_expected[peer]++;
+				while(rx_received[peer][rx_expected[peer] % UDP_REL_WINDOW]){
+					slot = peer*UDP_REL_WINDOW + rx_expected[peer] % UDP_REL_WINDOW;
+					for(unsigned int i = 0; i < rx_len[slot]; i++){
+					#pragma HLS PIPELINE II=1
+						outword.data = rx_buf[slot*UDP_REL_MAX_PKT_WORDS + i];
+						outword.keep = (i == rx_len[slot] - 1) ? rx_keep[slot] : (ap_uint<DATA_WIDTH/8>)(-1);
+						outword.dest = peer;
+						outword.last = (i == rx_len[slot] - 1);
+						STREAM_WRITE(rx_out, outword);
+					}
+					rx_received[peer][rx_expected[peer] % UDP_REL_WINDOW] = 0;
+					rx_expected[peer]++;
+				}
+				rx_gap[peer] = false;
+				rx_ack_pending[peer] = UDP_REL_ACK;
+			} else if(offset < UDP_REL_WINDOW){
+				//early: keep it and report the gap before it, once
+				slot = peer*UDP_REL_WINDOW + seqn % UDP_REL_WINDOW;
+				nwords = 0;
+				do{
+					inword = STREAM_READ(rx_in);
+					if(nwords < UDP_REL_MAX_PKT_WORDS){
+						rx_buf[slot*UDP_REL_MAX_PKT_WORDS + nwords] = inword.data;
+					}
+					nwords++;
+				} while(!inword.last);
+				//too long to keep, only from a peer which does not split datagrams: drop it, as if lost
+				if(nwords <= UDP_REL_MAX_PKT_WORDS){
+					rx_len[slot] = nwords;
+					rx_keep[slot] = inword.keep;
+					rx_received[peer][seqn % UDP_REL_WINDOW] = 1;
+				}
+				if(!rx_gap[peer]){
+					rx_gap[peer] = true;
+					rx_ack_pending[peer] = UDP_REL_NACK;
+				} else if(rx_ack_pending[peer] == 0){
+					rx_ack_pending[peer] = UDP_REL_ACK;
+				}
+			} else{
+				//already delivered, so its acknowledgement was lost, or beyond the window: drop and acknowledge
+				while(!inword.last){
+					inword = STREAM_READ(rx_in);
+				}
+				if(rx_ack_pending[peer] == 0){
+					rx_ack_pending[peer] = UDP_REL_ACK;
+				}
+			}
+		}
+	}
+
+	//find the first peer owing an acknowledgement and the first with datagrams to retransmit;
+	//on timeout, everything to a peer which is not selectively acknowledged is retransmitted
+	int ack_peer = -1;
+	int retx_peer = -1;
+	for(unsigned int p = 0; p < UDP_REL_MAX_PEERS; p++){
+	#pragma HLS UNROLL
+		if(tx_next[p] != tx_base[p] && (ap_uint<32>)(now - tx_timer[p]) > UDP_REL_TIMEOUT){
+			for(unsigned int i = 0; i < UDP_REL_WINDOW; i++){
+			#pragma HLS UNROLL
+				slot = (tx_base[p] + i) % UDP_REL_WINDOW;
+				if(i < tx_next[p] - tx_base[p] && !tx_sacked[p][slot]){
+					tx_retx[p][slot] = 1;
+				}
+			}
+			tx_timer[p] = now;
+		}
+		if(ack_peer < 0 && rx_ack_pending[p] != 0){
+			ack_peer = p;
+		}
+		if(retx_peer < 0 && tx_retx[p] != 0){
+			retx_peer = p;
+		}
+	}
+
+	//send one datagram: acknowledgements first, then retransmissions, then new data
+	if(ack_peer >= 0){
+		peer = ack_peer;
+		outword.data = rel_header(rx_ack_pending[peer], 0, rx_expected[peer], rel_sack(rx_expected[peer], rx_received[peer]));
+		outword.keep = -1;
+		outword.dest = peer;
+		outword.last = 1;
+		STREAM_WRITE(tx_out, outword);
+		rx_ack_pending[peer] = 0;
+	} else if(retx_peer >= 0){
+		peer = retx_peer;
+		//oldest datagram due
+		ap_uint<32> seqn = tx_base[peer];
+		for(int i = UDP_REL_WINDOW - 1; i >= 0; i--){
+		#pragma HLS UNROLL
+			if(tx_retx[peer][(tx_base[peer] + i) % UDP_REL_WINDOW]){
+				seqn = tx_base[peer] + i;
+			}
+		}
+		tx_retx[peer][seqn % UDP_REL_WINDOW] = 0;
+		slot = peer*UDP_REL_WINDOW + seqn % UDP_REL_WINDOW;
+#ifndef ACCL_SYNTHESIS
+		std::stringstream ss;
+		ss << "UDP reliability: retransmit " << seqn << " to " << peer << "\n";
+		std::cout << ss.str();
+#endif
+		outword.data = rel_header(UDP_REL_DATA, seqn, rx_expected[peer], rel_sack(rx_expected[peer], rx_received[peer]));
+		outword.keep = -1;
+		outword.dest = peer;
+		outword.last = 0;
+		STREAM_WRITE(tx_out, outword);
+		for(unsigned int i = 0; i < tx_len[slot]; i++){
+		#pragma HLS PIPELINE II=1
+			outword.data = tx_buf[slot*UDP_REL_MAX_PKT_WORDS + i];
+			outword.keep = (i == tx_len[slot] - 1) ? tx_keep[slot] : (ap_uint<DATA_WIDTH/8>)(-1);
+			outword.last = (i == tx_len[slot] - 1);
+			STREAM_WRITE(tx_out, outword);
+		}
+	} else if(held || !STREAM_IS_EMPTY(tx_in)){
+		if(!held){
+			held_word = STREAM_READ(tx_in);
+			held = true;
+		}
+		peer = held_word.dest;
+		if(peer < UDP_REL_MAX_PEERS && tx_next[peer] - tx_base[peer] >= UDP_REL_WINDOW){
+			//window full, wait for acknowledgements
+			return;
+		}
+		held = false;
+		inword = held_word;
+		if(peer >= UDP_REL_MAX_PEERS){
+			//unknown peer, drop
+			while(!inword.last){
+				inword = STREAM_READ(tx_in);
+			}
+			return;
+		}
+		ap_uint<32> seqn = tx_next[peer];
+		slot = peer*UDP_REL_WINDOW + seqn % UDP_REL_WINDOW;
+		outword.data = rel_header(UDP_REL_DATA, seqn, rx_expected[peer], rel_sack(rx_expected[peer], rx_received[peer]));
+		outword.keep = -1;
+		outword.dest = peer;
+		outword.last = 0;
+		STREAM_WRITE(tx_out, outword);
+		//end the datagram after UDP_REL_MAX_PKT_WORDS words, the rest follows as the next one
+		nwords = 0;
+		while(true){
+		#pragma HLS PIPELINE II=1
+			tx_buf[slot*UDP_REL_MAX_PKT_WORDS + nwords] = inword.data;
+			nwords++;
+			if(nwords == UDP_REL_MAX_PKT_WORDS){
+				inword.last = 1;
+			}
+			STREAM_WRITE(tx_out, inword);
+			if(inword.last){
+				break;
+			}
+			inword = STREAM_READ(tx_in);
+		}
+		tx_len[slot] = nwords;
+		tx_keep[slot] = inword.keep;
+		tx_sacked[peer][seqn % UDP_REL_WINDOW] = 0;
+		tx_retx[peer][seqn % UDP_REL_WINDOW] = 0;
+		if(tx_next[peer] == tx_base[peer]){
+			tx_timer[peer] = now;
+		}
+		tx_next[peer] = seqn + 1;
+	}
+}
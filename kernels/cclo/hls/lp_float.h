@@ -0,0 +1,175 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#pragma once
+
+#include "ap_int.h"
+#include <stdint.h>
+
+//bit-level conversions between fp32 and the low-precision float formats
+//used on the compression lanes: bfloat16, fp8 E4M3 (OCP "FN" variant, no
+//infinities) and fp8 E5M2 (IEEE-like). All narrowing conversions round to
+//nearest, ties to even.
+
+inline ap_uint<16> fp32_to_bf16(ap_uint<32> x){
+#pragma HLS INLINE
+    unsigned int bits = x.to_uint();
+    if(((bits >> 23) & 0xff) == 0xff && (bits & 0x7fffff) != 0){
+        //NaN: keep sign and force a quiet NaN, truncation could otherwise yield infinity
+        return (bits >> 16) | 0x40;
+    }
+    //adding 0x7fff plus the lsb of the result rounds to nearest even,
+    //a mantissa carry correctly propagates into the exponent
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return bits >> 16;
+}
+
+//stateless pseudo-random dither for stochastic rounding, hashed from the value
+//and its position in the packet so that equal values in different lanes decorrelate
+inline unsigned int lp_dither(ap_uint<32> x, unsigned int idx){
+#pragma HLS INLINE
+    unsigned int h = x.to_uint() ^ (idx * 0x9e3779b9);
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+//stochastic rounding: round up with probability equal to the discarded fraction,
+//which keeps the rounding error zero-mean when partial sums are requantized every hop
+inline ap_uint<16> fp32_to_bf16_sr(ap_uint<32> x, unsigned int rnd){
+#pragma HLS INLINE
+    unsigned int bits = x.to_uint();
+    if(((bits >> 23) & 0xff) == 0xff){
+        //NaN or infinity
+        return fp32_to_bf16(x);
+    }
+    bits += rnd & 0xffff;
+    return bits >> 16;
+}
+
+inline ap_uint<32> bf16_to_fp32(ap_uint<16> x){
+#pragma HLS INLINE
+    return ((unsigned int)x.to_uint()) << 16;
+}
+
+//EW exponent bits, MW mantissa bits; FINITE formats have no infinities,
+//overflow saturates to the largest finite value and the all-ones encoding is NaN
+template<unsigned int EW, unsigned int MW, bool FINITE>
+ap_uint<8> fp32_to_fp8(ap_uint<32> x){
+#pragma HLS INLINE
+    int const bias = (1 << (EW-1)) - 1;
+    unsigned int const exp_max = (1 << EW) - 1;
+    unsigned int const max_finite = FINITE ? ((exp_max << MW) | ((1 << MW) - 2)) : (((exp_max - 1) << MW) | ((1 << MW) - 1));
+    unsigned int const inf = FINITE ? max_finite : (exp_max << MW);
+    unsigned int const nan = FINITE ? ((exp_max << MW) | ((1 << MW) - 1)) : ((exp_max << MW) | (1 << (MW-1)));
+
+    unsigned int bits = x.to_uint();
+    unsigned int sign = (bits >> 31) << 7;
+    unsigned int exp = (bits >> 23) & 0xff;
+    unsigned int man = bits & 0x7fffff;
+
+    if(exp == 0xff){
+        return sign | ((man != 0) ? nan : inf);
+    }
+    if(exp == 0){
+        //zeros and fp32 subnormals are far below the smallest fp8 subnormal
+        return sign;
+    }
+    int e = (int)exp - 127 + bias;
+    unsigned int full = man | (1 << 23);
+    //normals drop 23-MW bits, subnormals additionally shift by the exponent deficit
+    unsigned int shift = (e >= 1) ? (23 - MW) : (23 - MW + 1 - e);
+    if(shift > 25){
+        //anything below half the smallest subnormal rounds to zero
+        shift = 25;
+    }
+    unsigned int kept = full >> shift;
+    unsigned int rem = full & ((1 << shift) - 1);
+    unsigned int half = 1 << (shift - 1);
+    unsigned int round_up = (rem > half || (rem == half && (kept & 1))) ? 1 : 0;
+    //for normals, kept holds the implicit bit at position MW; adding the exponent
+    //field on top lets a rounding carry ripple into the exponent
+    unsigned int mag = (e >= 1) ? ((((unsigned int)e - 1) << MW) + kept) : kept;
+    mag += round_up;
+    if(mag > max_finite){
+        mag = inf;
+    }
+    return sign | mag;
+}
+
+template<unsigned int EW, unsigned int MW, bool FINITE>
+ap_uint<32> fp8_to_fp32(ap_uint<8> x){
+#pragma HLS INLINE
+    int const bias = (1 << (EW-1)) - 1;
+    unsigned int const exp_max = (1 << EW) - 1;
+
+    unsigned int bits = x.to_uint();
+    unsigned int sign = (bits >> 7) & 1;
+    unsigned int exp = (bits >> MW) & exp_max;
+    unsigned int man = bits & ((1 << MW) - 1);
+    unsigned int res_exp, res_man;
+
+    if(exp == exp_max && (!FINITE || man == (1 << MW) - 1)){
+        //infinity or NaN
+        res_exp = 0xff;
+        res_man = FINITE ? (1 << 22) : (man << (23 - MW));
+    } else if(exp == 0){
+        if(man == 0){
+            res_exp = 0;
+            res_man = 0;
+        } else{
+            //subnormal, normalize the mantissa
+            int e = 1 - bias + 127;
+            for(unsigned int i = 0; i < MW; i++){
+#pragma HLS UNROLL
+                if((man & (1 << MW)) == 0){
+                    man <<= 1;
+                    e--;
+                }
+            }
+            res_exp = e;
+            res_man = (man & ((1 << MW) - 1)) << (23 - MW);
+        }
+    } else{
+        res_exp = exp - bias + 127;
+        res_man = man << (23 - MW);
+    }
+    return (sign << 31) | (res_exp << 23) | res_man;
+}
+
+inline ap_uint<8> fp32_to_fp8e4m3(ap_uint<32> x){ return fp32_to_fp8<4, 3, true>(x); }
+inline ap_uint<32> fp8e4m3_to_fp32(ap_uint<8> x){ return fp8_to_fp32<4, 3, true>(x); }
+inline ap_uint<8> fp32_to_fp8e5m2(ap_uint<32> x){ return fp32_to_fp8<5, 2, false>(x); }
+inline ap_uint<32> fp8e5m2_to_fp32(ap_uint<8> x){ return fp8_to_fp32<5, 2, false>(x); }
+
+//bfloat16 storage type for the arithmetic plugins; operands widen exactly
+//to fp32 and results are rounded back to nearest even
+struct bfloat16 {
+    uint16_t bits;
+    bfloat16() {}
+    bfloat16(float f) {
+        uint32_t u = *reinterpret_cast<uint32_t*>(&f);
+        bits = fp32_to_bf16(u).to_uint();
+    }
+    operator float() const {
+        uint32_t u = bf16_to_fp32(bits).to_uint();
+        return *reinterpret_cast<float*>(&u);
+    }
+};
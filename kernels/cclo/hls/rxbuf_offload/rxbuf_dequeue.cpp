@@ -31,7 +31,7 @@ void rxbuf_dequeue(
 #pragma HLS INTERFACE axis 		port=eth_hdr
 #pragma HLS INTERFACE axis 		port=inflight_queue
 #pragma HLS INTERFACE axis 		port=notification_queue
-#pragma HLS INTERFACE m_axi 	port=rx_buffers depth=16*9 offset=slave num_read_outstanding=4 num_write_outstanding=4  bundle=mem
+#pragma HLS INTERFACE m_axi 	port=rx_buffers depth=16*12 offset=slave num_read_outstanding=4 num_write_outstanding=4  bundle=mem
 #pragma HLS INTERFACE s_axilite port=return
 #pragma HLS PIPELINE II=1 style=flp
 	//get rx_buffer pointer from inflight queue
@@ -41,6 +41,10 @@ void rxbuf_dequeue(
 	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + RX_LEN_OFFSET] = header.count;
 	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + RX_SRC_OFFSET] = header.src;
 	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + SEQUENCE_NUMBER_OFFSET] = header.seqn;
+	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + MSG_COUNT_OFFSET] = header.msg_count;
+	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + MSG_TYPE_OFFSET] = header.msg_type;
+	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + RNDZV_ADDRL_OFFSET] = header.addr(31,0);
+	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + RNDZV_ADDRH_OFFSET] = header.addr(63,32);
 	hlslib::axi::Status dma_status = hlslib::axi::Status(STREAM_READ(dma_sts));
 	//interpret dma sts and write new spare_sts
 	// 3-0 TAG 
@@ -54,6 +58,10 @@ void rxbuf_dequeue(
 		new_status = STATUS_RESERVED;
 	}
 	rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + STATUS_OFFSET] = new_status;
+	//rendezvous control and RMA messages are out of band, firmware picks them up from the descriptor
+	if(header.msg_type != MSG_EAGER && header.msg_type != MSG_RNDZV_RTS){
+		return;
+	}
 	//send to the DMA mover data required to identify/resolve a receive: tag, src, count, address
 	rxbuf_notification s;
 	// s.addr(31, 0) = rx_buffers[1 + spare_idx * SPARE_BUFFER_FIELDS + ADDRL_OFFSET];
@@ -27,7 +27,7 @@ void rxbuf_enqueue(
 ) {
 #pragma HLS INTERFACE axis 		port=dma_cmd
 #pragma HLS INTERFACE axis 		port=inflight_queue
-#pragma HLS INTERFACE m_axi 	port=rx_buffers	depth=9*16 offset=slave num_read_outstanding=4	num_write_outstanding=4 bundle=mem
+#pragma HLS INTERFACE m_axi 	port=rx_buffers	depth=12*16 offset=slave num_read_outstanding=4	num_write_outstanding=4 bundle=mem
 #pragma HLS INTERFACE s_axilite port=return
 #pragma HLS PIPELINE II=4
 
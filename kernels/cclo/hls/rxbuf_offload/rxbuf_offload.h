@@ -29,12 +29,16 @@ typedef struct {
     ap_uint<16> index;
     bool first;
     bool last;
+    bool direct;
 } rxbuf_status_control;
 
 typedef struct {
     bool active;
+    bool direct;
+    bool sink;
     unsigned int index;
     ap_uint<64> address;
+    unsigned int limit;
     unsigned int remaining;
     eth_header header;
 } rxbuf_session_descriptor;
@@ -70,5 +74,6 @@ void rxbuf_session(
 	STREAM<ap_uint<32> > &fragment_dma_sts, //status of a fragment write
     STREAM<eth_notification> &session_notification, //get notified when there is data for a session
     STREAM<eth_header> &eth_hdr_in, //input header of from depacketizer
-    STREAM<eth_header> &eth_hdr_out //forward header of message in completed RX buffer
+    STREAM<eth_header> &eth_hdr_out, //forward header of message in completed RX buffer
+    unsigned int *exchange_mem //ranges open to direct writes
 );
@@ -27,13 +27,19 @@ void rxbuf_session_status(
 ){
 #pragma HLS PIPELINE II=1 style=flp
 #pragma HLS INLINE off
-    static ap_uint<32> mem[512];//TODO make depth compile-time configurable
+    static ap_uint<32> mem[MAX_SESSIONS];
+#if MAX_SESSIONS > SESSION_TABLE_URAM_DEPTH
+#pragma HLS BIND_STORAGE variable=mem type=RAM_2P impl=URAM
+#endif
     hlslib::axi::Status tmp_sts, stored_sts;
     rxbuf_status_control cmd;
     if(!STREAM_IS_EMPTY(cmd_in)){
         cmd = STREAM_READ(cmd_in);
         tmp_sts = hlslib::axi::Status(STREAM_READ(sts_in));
-        if(cmd.first && cmd.last){
+        if(cmd.direct){
+            //rendezvous payload written directly to a posted buffer; no rx buffer
+            //is waiting on this status, completion is signalled by the FIN message
+        } else if(cmd.first && cmd.last){
             STREAM_WRITE(sts_out, tmp_sts);
         } else if(cmd.first){
             mem[cmd.index] = tmp_sts;
@@ -53,6 +59,22 @@ void rxbuf_session_status(
     }
 }
 
+//checks that a direct write of len bytes at addr falls within one of the ranges
+//granted by the firmware and driver in exchange memory, and within one DMA command
+bool direct_write_granted(unsigned int *exchange_mem, ap_uint<64> addr, unsigned int len){
+#pragma HLS INLINE off
+    bool granted = false;
+    for(int i = 0; i < DIRECT_GRANT_COUNT; i++){
+        unsigned int offset = DIRECT_GRANT_OFFSET/4 + i*DIRECT_GRANT_FIELDS;
+        ap_uint<64> base;
+        base(31,0) = exchange_mem[offset + DIRECT_GRANT_BASEL_OFFSET];
+        base(63,32) = exchange_mem[offset + DIRECT_GRANT_BASEH_OFFSET];
+        ap_uint<64> size = exchange_mem[offset + DIRECT_GRANT_SIZE_OFFSET];
+        granted |= (size != 0) && (addr >= base) && (addr + len <= base + size);
+    }
+    return granted && (len <= DMA_MAX_BTT);
+}
+
 void rxbuf_session_command(
 	STREAM<ap_uint<104> > &rxbuf_dma_cmd, 
 	STREAM<ap_uint<32> > &rxbuf_idx_in,
@@ -61,54 +83,111 @@ void rxbuf_session_command(
     STREAM<eth_notification> &session_notification,
     STREAM<eth_header> &eth_hdr_in,
     STREAM<eth_header> &eth_hdr_out,
-    STREAM<rxbuf_status_control> &status_instruction
+    STREAM<rxbuf_status_control> &status_instruction,
+    unsigned int *exchange_mem
 ){
 #pragma HLS PIPELINE II=1 style=flp
 #pragma HLS INLINE off
-    static rxbuf_session_descriptor mem[512];//TODO make depth compile-time configurable
+    static rxbuf_session_descriptor mem[MAX_SESSIONS];
+#if MAX_SESSIONS > SESSION_TABLE_URAM_DEPTH
+#pragma HLS BIND_STORAGE variable=mem type=RAM_2P impl=URAM
+#endif
+    static unsigned int nclear = 0;
+    //a fragment of sunk payload longer than the RX buffer is written in several commands
+    static bool pending = false;
+    static unsigned int pending_session;
+    static unsigned int pending_length;
+    unsigned constexpr bytes_per_word = DATA_WIDTH/8;
     eth_notification notif;
     rxbuf_session_descriptor desc;
     hlslib::axi::Command<64, 23> cmd;
     stream_word inword;
     eth_header hdr;
     rxbuf_status_control sts_command;
-    if(!STREAM_IS_EMPTY(session_notification)){
-        notif = STREAM_READ(session_notification);
+    unsigned int length;
+    //invalidate one descriptor per call after reset
+    if(nclear < MAX_SESSIONS){
+        desc.active = false;
+        mem[nclear] = desc;
+        nclear++;
+        return;
+    }
+    if(pending || !STREAM_IS_EMPTY(session_notification)){
+        if(pending){
+            notif.session_id = pending_session;
+            notif.length = pending_length;
+        } else{
+            notif = STREAM_READ(session_notification);
+        }
+        //the depacketizer does not forward sessions beyond the table, ignore any that get here
+        if(notif.session_id >= MAX_SESSIONS){
+            return;
+        }
         desc = mem[notif.session_id];
         if(desc.active){
             //descriptor exists, continue
             //issue command to datamover
             cmd.length = notif.length;
             cmd.address = desc.address;
-            STREAM_WRITE(fragment_dma_cmd, cmd);
             //prime the command to status parser
             sts_command.first = false;
         } else {
             //descriptor does not exist, initialize
-            cmd = hlslib::axi::Command<64, 23>(STREAM_READ(rxbuf_dma_cmd));//{undex, current write address, bytes remaining, header}
             desc.active = true;
-            desc.index = STREAM_READ(rxbuf_idx_in);
-            desc.address = cmd.address;
-            //issue a command to the datamover for this fragment
-            //(we can reuse the input command since it's indeterminate BTT and address is the same right now)
-            STREAM_WRITE(fragment_dma_cmd, cmd);
             //store header
 	        desc.header = STREAM_READ(eth_hdr_in);
             desc.remaining = desc.header.count;
+            //rendezvous payload goes to the address in the header, without taking a RX buffer,
+            //if it falls in a posted buffer or window; fragments never extend past the message,
+            //since the depacketizer splits notifications at message boundaries. Payload outside
+            //of the granted ranges is not limited to the size of a RX buffer, so it is sunk into one:
+            //all of it is written over the start of the buffer, which the firmware then discards
+            desc.direct = (desc.header.msg_type == MSG_RNDZV_DATA) &&
+                            direct_write_granted(exchange_mem, desc.header.addr, desc.header.count);
+            desc.sink = (desc.header.msg_type == MSG_RNDZV_DATA) && !desc.direct;
+            if(desc.direct){
+                desc.address = desc.header.addr;
+                cmd.length = notif.length;
+                cmd.address = desc.address;
+            } else {
+                cmd = hlslib::axi::Command<64, 23>(STREAM_READ(rxbuf_dma_cmd));//{undex, current write address, bytes remaining, header}
+                desc.index = STREAM_READ(rxbuf_idx_in);
+                desc.address = cmd.address;
+                //whole datapath words, so each command ends on a word boundary of the fragment
+                desc.limit = cmd.length & ~(bytes_per_word-1);
+            }
             //prime the command to status parser
             sts_command.first = true;
         }
-        //update address
-        desc.address += notif.length;
-        desc.remaining -= notif.length;
+        length = notif.length;
+        if(desc.sink){
+            if(length > desc.limit){
+                length = desc.limit;
+            }
+            cmd.length = length;
+        }
+        //issue a command to the datamover for this fragment
+        //(for the first fragment we can reuse the input command since it's indeterminate BTT and address is the same right now)
+        STREAM_WRITE(fragment_dma_cmd, cmd);
+        //sunk payload stays within the buffer, anything else moves on
+        if(!desc.sink){
+            desc.address += length;
+        }
+        desc.remaining -= length;
+        pending = (length < notif.length);
+        pending_session = notif.session_id;
+        pending_length = notif.length - length;
         //if remaining is zero, flush
         if(desc.remaining == 0){
-            STREAM_WRITE(rxbuf_idx_out, desc.index);
-            STREAM_WRITE(eth_hdr_out, desc.header);
+            if(!desc.direct){
+                STREAM_WRITE(rxbuf_idx_out, desc.index);
+                STREAM_WRITE(eth_hdr_out, desc.header);
+            }
             desc.active = false;
         }
         //command the status parser
         sts_command.index = notif.session_id;
+        sts_command.direct = desc.direct;
         sts_command.last = (desc.remaining == 0);
         STREAM_WRITE(status_instruction, sts_command);
         //store descriptor
@@ -129,7 +208,9 @@ void rxbuf_session(
     STREAM<eth_notification> &session_notification, //get notified when there is data for a session
     STREAM<eth_header> &eth_hdr_in,
     //status to dequeuer
-    STREAM<eth_header> &eth_hdr_out //forward header of message in completed RX buffer
+    STREAM<eth_header> &eth_hdr_out, //forward header of message in completed RX buffer
+    //exchange memory, holding the ranges open to direct writes
+    unsigned int *exchange_mem
 ){
 #pragma HLS INTERFACE axis register both port=rxbuf_dma_cmd
 #pragma HLS INTERFACE axis register both port=rxbuf_dma_sts
@@ -140,6 +221,7 @@ void rxbuf_session(
 #pragma HLS INTERFACE axis register both port=session_notification
 #pragma HLS INTERFACE axis register both port=eth_hdr_in
 #pragma HLS INTERFACE axis register both port=eth_hdr_out
+#pragma HLS INTERFACE m_axi port=exchange_mem offset=off num_read_outstanding=4 num_write_outstanding=4 bundle=mem
 #pragma HLS INTERFACE ap_ctrl_none port=return
 #pragma HLS DATAFLOW disable_start_propagation
     //how this works:
@@ -169,6 +251,10 @@ void rxbuf_session(
     //  we store address+length in the data store
     //  we read one word from data_in, extract header and store it in the data store
     //  we copy length bytes from data_in to data_out
+    //  except for rendezvous payload, which targets the address in its header instead of a RX buffer
+    //  if that lies in a range granted in exchange memory, and is not forwarded to the dequeuer on completion
+    //  rendezvous payload outside the granted ranges is sunk into its RX buffer: every fragment is written
+    //  at the buffer start, in as many commands as needed to stay within the buffer length
 
     //separately, we need to monitor statuses from the dma; we do this in a separate process (dataflow function)
     //on each fragment command we send to the datamover, we also send an command, including the buffer id to the status monitoring process,
@@ -191,7 +277,8 @@ void rxbuf_session(
         session_notification, 
         eth_hdr_in,
         eth_hdr_out, 
-        status_instruction
+        status_instruction,
+        exchange_mem
     );
     rxbuf_session_status(status_instruction, fragment_dma_sts, rxbuf_dma_sts);
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "rxbuf_offload.h"
+#include "Axi.h"
+#include <iostream>
+
+using namespace std;
+
+#define NSESSIONS 4096
+#define FRAGMENT_BYTES 1024
+#define RXBUF_BASE 0x100000000ULL
+#define RXBUF_STRIDE 0x10000ULL
+#define GRANT_BASE 0x200000000ULL
+
+unsigned int exchange_mem[2048];
+
+//every session receives one message in two fragments; all sessions get their first fragment
+//before any gets its second, and in a different order, so all descriptors are live at once
+unsigned int first_order(unsigned int i){
+    return (i * 1237) % NSESSIONS;
+}
+
+unsigned int second_order(unsigned int i){
+    return (i * 2731 + 17) % NSESSIONS;
+}
+
+int main(){
+    STREAM<ap_uint<104> > rxbuf_dma_cmd, fragment_dma_cmd;
+    STREAM<ap_uint<32> > rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_sts;
+    STREAM<eth_notification> session_notification;
+    STREAM<eth_header> eth_hdr_in, eth_hdr_out;
+    hlslib::axi::Command<64, 23> cmd;
+    hlslib::axi::Status sts;
+    eth_notification notif;
+    eth_header hdr;
+    int nerrors = 0;
+
+    //let the session table clear after reset
+    for(unsigned int i = 0; i < MAX_SESSIONS; i++){
+        rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+    }
+
+    for(unsigned int i = 0; i < NSESSIONS; i++){
+        unsigned int s = first_order(i);
+        notif.session_id = s;
+        notif.length = FRAGMENT_BYTES;
+        STREAM_WRITE(session_notification, notif);
+        hdr = eth_header();
+        hdr.count = 2*FRAGMENT_BYTES;
+        hdr.tag = s;
+        hdr.msg_type = MSG_EAGER;
+        STREAM_WRITE(eth_hdr_in, hdr);
+        cmd.address = RXBUF_BASE + s*RXBUF_STRIDE;
+        cmd.length = 2*FRAGMENT_BYTES;
+        STREAM_WRITE(rxbuf_dma_cmd, (ap_uint<104>)cmd);
+        STREAM_WRITE(rxbuf_idx_in, s);
+        STREAM_WRITE(fragment_dma_sts, (ap_uint<32>)sts);
+        rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+        //the first fragment reuses the RX buffer command
+        cmd = hlslib::axi::Command<64, 23>(STREAM_READ(fragment_dma_cmd));
+        if(cmd.address != RXBUF_BASE + s*RXBUF_STRIDE){
+            cout << "Session " << s << ": first fragment written to " << hex << cmd.address << dec << endl;
+            nerrors++;
+        }
+        if(!STREAM_IS_EMPTY(rxbuf_idx_out) || !STREAM_IS_EMPTY(eth_hdr_out) || !STREAM_IS_EMPTY(rxbuf_dma_sts)){
+            cout << "Session " << s << ": completed after first fragment" << endl;
+            nerrors++;
+        }
+    }
+
+    //a session beyond the table is ignored and does not disturb the others
+    notif.session_id = MAX_SESSIONS;
+    notif.length = FRAGMENT_BYTES;
+    STREAM_WRITE(session_notification, notif);
+    rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+    if(!STREAM_IS_EMPTY(fragment_dma_cmd) || !STREAM_IS_EMPTY(rxbuf_idx_out) || !STREAM_IS_EMPTY(eth_hdr_out)){
+        cout << "Session " << MAX_SESSIONS << " beyond the table was not ignored" << endl;
+        nerrors++;
+    }
+
+    for(unsigned int i = 0; i < NSESSIONS; i++){
+        unsigned int s = second_order(i);
+        notif.session_id = s;
+        notif.length = FRAGMENT_BYTES;
+        STREAM_WRITE(session_notification, notif);
+        STREAM_WRITE(fragment_dma_sts, (ap_uint<32>)sts);
+        rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+        cmd = hlslib::axi::Command<64, 23>(STREAM_READ(fragment_dma_cmd));
+        if(cmd.address != RXBUF_BASE + s*RXBUF_STRIDE + FRAGMENT_BYTES || cmd.length != FRAGMENT_BYTES){
+            cout << "Session " << s << ": second fragment written to " << hex << cmd.address << dec << " length " << cmd.length << endl;
+            nerrors++;
+        }
+        if(STREAM_IS_EMPTY(rxbuf_idx_out) || STREAM_IS_EMPTY(eth_hdr_out) || STREAM_IS_EMPTY(rxbuf_dma_sts)){
+            cout << "Session " << s << ": not completed after second fragment" << endl;
+            nerrors++;
+            continue;
+        }
+        unsigned int idx = STREAM_READ(rxbuf_idx_out);
+        hdr = STREAM_READ(eth_hdr_out);
+        STREAM_READ(rxbuf_dma_sts);
+        if(idx != s || hdr.tag != s || hdr.count != 2*FRAGMENT_BYTES){
+            cout << "Session " << s << ": completed buffer " << idx << " with tag " << hdr.tag << " count " << hdr.count << endl;
+            nerrors++;
+        }
+    }
+
+    if(!STREAM_IS_EMPTY(fragment_dma_cmd) || !STREAM_IS_EMPTY(rxbuf_idx_out) || !STREAM_IS_EMPTY(eth_hdr_out) || !STREAM_IS_EMPTY(rxbuf_dma_sts)){
+        cout << "Unexpected output after all sessions completed" << endl;
+        nerrors++;
+    }
+
+    //rendezvous payload goes directly to a granted range, and to a RX buffer otherwise
+    unsigned int grant = DIRECT_GRANT_OFFSET/4 + DIRECT_GRANT_RNDZV*DIRECT_GRANT_FIELDS;
+    exchange_mem[grant + DIRECT_GRANT_BASEL_OFFSET] = GRANT_BASE & 0xffffffff;
+    exchange_mem[grant + DIRECT_GRANT_BASEH_OFFSET] = GRANT_BASE >> 32;
+    exchange_mem[grant + DIRECT_GRANT_SIZE_OFFSET] = FRAGMENT_BYTES;
+    for(unsigned int s = 0; s < 2; s++){
+        //the first message fits the grant, the second extends past it
+        notif.session_id = s;
+        notif.length = FRAGMENT_BYTES;
+        STREAM_WRITE(session_notification, notif);
+        hdr = eth_header();
+        hdr.count = FRAGMENT_BYTES;
+        hdr.msg_type = MSG_RNDZV_DATA;
+        hdr.addr = GRANT_BASE + s*FRAGMENT_BYTES/2;
+        STREAM_WRITE(eth_hdr_in, hdr);
+        cmd.address = RXBUF_BASE + s*RXBUF_STRIDE;
+        cmd.length = FRAGMENT_BYTES;
+        STREAM_WRITE(rxbuf_dma_cmd, (ap_uint<104>)cmd);
+        STREAM_WRITE(rxbuf_idx_in, s);
+        STREAM_WRITE(fragment_dma_sts, (ap_uint<32>)sts);
+        rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+        cmd = hlslib::axi::Command<64, 23>(STREAM_READ(fragment_dma_cmd));
+        bool granted = (s == 0);
+        if(cmd.address != (granted ? (unsigned long long)hdr.addr : RXBUF_BASE + s*RXBUF_STRIDE)){
+            cout << "Rendezvous payload " << s << " written to " << hex << cmd.address << dec << endl;
+            nerrors++;
+        }
+        if(granted == STREAM_IS_EMPTY(rxbuf_dma_cmd) || granted != STREAM_IS_EMPTY(rxbuf_idx_out)){
+            cout << "Rendezvous payload " << s << (granted ? " took" : " did not take") << " a RX buffer" << endl;
+            nerrors++;
+        }
+        while(!STREAM_IS_EMPTY(rxbuf_dma_cmd)) STREAM_READ(rxbuf_dma_cmd);
+        while(!STREAM_IS_EMPTY(rxbuf_idx_in)) STREAM_READ(rxbuf_idx_in);
+        while(!STREAM_IS_EMPTY(rxbuf_idx_out)) STREAM_READ(rxbuf_idx_out);
+        while(!STREAM_IS_EMPTY(eth_hdr_out)) STREAM_READ(eth_hdr_out);
+        while(!STREAM_IS_EMPTY(rxbuf_dma_sts)) STREAM_READ(rxbuf_dma_sts);
+    }
+
+    //rendezvous payload outside the grants, longer than the RX buffer and in fragments longer than it,
+    //is written in commands which all stay within the buffer, and completes the buffer once
+    notif.session_id = 2;
+    hdr = eth_header();
+    hdr.count = 3*FRAGMENT_BYTES;
+    hdr.msg_type = MSG_RNDZV_DATA;
+    hdr.addr = GRANT_BASE + 2*FRAGMENT_BYTES;
+    STREAM_WRITE(eth_hdr_in, hdr);
+    cmd.address = RXBUF_BASE + 2*RXBUF_STRIDE;
+    cmd.length = FRAGMENT_BYTES;
+    STREAM_WRITE(rxbuf_dma_cmd, (ap_uint<104>)cmd);
+    STREAM_WRITE(rxbuf_idx_in, 2);
+    unsigned int written = 0;
+    for(unsigned int f = 0; f < 2; f++){
+        notif.length = 3*FRAGMENT_BYTES/2;
+        STREAM_WRITE(session_notification, notif);
+        //statuses of the two commands expected for the fragment
+        sts.bytesReceived = FRAGMENT_BYTES;
+        STREAM_WRITE(fragment_dma_sts, (ap_uint<32>)sts);
+        sts.bytesReceived = FRAGMENT_BYTES/2;
+        STREAM_WRITE(fragment_dma_sts, (ap_uint<32>)sts);
+        for(unsigned int i = 0; i < 4; i++){
+            rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+            while(!STREAM_IS_EMPTY(fragment_dma_cmd)){
+                cmd = hlslib::axi::Command<64, 23>(STREAM_READ(fragment_dma_cmd));
+                if(cmd.address < RXBUF_BASE + 2*RXBUF_STRIDE || cmd.address + cmd.length > RXBUF_BASE + 2*RXBUF_STRIDE + FRAGMENT_BYTES){
+                    cout << "Sunk rendezvous payload written to " << hex << cmd.address << dec << " length " << cmd.length << endl;
+                    nerrors++;
+                }
+                written += cmd.length;
+            }
+        }
+    }
+    for(unsigned int i = 0; i < 4; i++){
+        rxbuf_session(rxbuf_dma_cmd, rxbuf_dma_sts, rxbuf_idx_in, rxbuf_idx_out, fragment_dma_cmd, fragment_dma_sts, session_notification, eth_hdr_in, eth_hdr_out, exchange_mem);
+    }
+    if(written != 3*FRAGMENT_BYTES){
+        cout << "Sunk rendezvous payload: " << written << " bytes commanded" << endl;
+        nerrors++;
+    }
+    if(STREAM_IS_EMPTY(rxbuf_idx_out) || STREAM_READ(rxbuf_idx_out) != 2 || STREAM_IS_EMPTY(eth_hdr_out) || STREAM_IS_EMPTY(rxbuf_dma_sts)){
+        cout << "Sunk rendezvous payload did not complete its RX buffer" << endl;
+        nerrors++;
+    } else{
+        STREAM_READ(eth_hdr_out);
+        sts = hlslib::axi::Status(STREAM_READ(rxbuf_dma_sts));
+        if(sts.bytesReceived != 3*FRAGMENT_BYTES){
+            cout << "Sunk rendezvous payload completed with " << sts.bytesReceived << " bytes" << endl;
+            nerrors++;
+        }
+    }
+    if(!STREAM_IS_EMPTY(fragment_dma_cmd) || !STREAM_IS_EMPTY(rxbuf_idx_out) || !STREAM_IS_EMPTY(rxbuf_dma_sts)){
+        cout << "Unexpected output after sunk rendezvous payload" << endl;
+        nerrors++;
+    }
+
+    if(nerrors == 0){
+        cout << "RX buffer session test passed for " << NSESSIONS << " sessions" << endl;
+    }
+    return nerrors;
+}
@@ -358,10 +358,10 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
 
   # Create instance: fifo_eth_packetizer_cmd, and set properties
   set fifo_eth_packetizer_cmd [ create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 fifo_eth_packetizer_cmd ]
-  set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {24} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] $fifo_eth_packetizer_cmd
+  set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {36} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] $fifo_eth_packetizer_cmd
   # Create instance: fifo_eth_depacketizer_sts, and set properties
   set fifo_eth_depacketizer_sts [ create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 fifo_eth_depacketizer_sts ]
-  set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {24} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] $fifo_eth_depacketizer_sts
+  set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {36} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] $fifo_eth_depacketizer_sts
    # Create instance: fifo_eth_packetizer_sts, and set properties
   set fifo_eth_packetizer_sts [ create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 fifo_eth_packetizer_sts ]
   set_property -dict [ list  CONFIG.HAS_TLAST {1}  CONFIG.TDATA_NUM_BYTES {4} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] $fifo_eth_packetizer_sts
@@ -456,7 +456,7 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
     set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {4} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] [get_bd_cells fifo_dmasts_session]
 
     create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 fifo_hdr_session
-    set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {24} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] [get_bd_cells fifo_hdr_session]
+    set_property -dict [ list CONFIG.HAS_TLAST {1} CONFIG.TDATA_NUM_BYTES {36} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] [get_bd_cells fifo_hdr_session]
   
 
     connect_bd_intf_net [get_bd_intf_pins rxbuf_enqueue/dma_cmd] [get_bd_intf_pins fifo_dmacmd_session/S_AXIS] 
@@ -511,6 +511,8 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
   set_property -dict [ list CONFIG.HAS_TLAST {0} CONFIG.TDATA_NUM_BYTES {4} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] [get_bd_cells fifo_dma_mover_command]
   create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 fifo_dma_mover_error
   set_property -dict [ list CONFIG.HAS_TLAST {0} CONFIG.TDATA_NUM_BYTES {4} CONFIG.FIFO_DEPTH {32} CONFIG.FIFO_MEMORY_TYPE {distributed}] [get_bd_cells fifo_dma_mover_error]
+  # Create collective sequencer, expanding collective descriptors into moves on their way to the DMA mover
+  set collective_sequencer [ create_bd_cell -type ip -vlnv xilinx.com:hls:collective_sequencer:1.0 collective_sequencer ]
   connect_bd_intf_net [get_bd_intf_pins fifo_dma0_mm2s_cmd/S_AXIS] [get_bd_intf_pins dma_mover/dma0_read_cmd]
   connect_bd_intf_net [get_bd_intf_pins fifo_dma0_mm2s_sts/M_AXIS] [get_bd_intf_pins dma_mover/dma0_read_sts]
   connect_bd_intf_net [get_bd_intf_pins fifo_dma1_mm2s_cmd/S_AXIS] [get_bd_intf_pins dma_mover/dma1_read_cmd]
@@ -522,12 +524,18 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
 
   #interconnect to access exchange memory
   set dma_memory_ic [create_bd_cell -type ip -vlnv xilinx.com:ip:axi_crossbar:2.1 dma_memory_ic]
-  set_property -dict [list CONFIG.NUM_SI {4} CONFIG.NUM_MI {1}] $dma_memory_ic
+  set_property -dict [list CONFIG.NUM_SI {5} CONFIG.NUM_MI {1}] $dma_memory_ic
   connect_bd_intf_net [get_bd_intf_pins rxbuf_enqueue/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S00_AXI]
   connect_bd_intf_net [get_bd_intf_pins rxbuf_dequeue/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S01_AXI]
   connect_bd_intf_net [get_bd_intf_pins rxbuf_seek/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S02_AXI]
   connect_bd_intf_net [get_bd_intf_pins dma_mover/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S03_AXI]
+  connect_bd_intf_net [get_bd_intf_pins collective_sequencer/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S04_AXI]
   connect_bd_intf_net [get_bd_intf_pins exchange_mem/S_AXI_BYP] [get_bd_intf_pins dma_memory_ic/M00_AXI]
+  if { $fanInSupport == 1 } {
+    # the session handler checks direct writes against the ranges granted in exchange memory
+    set_property -dict [list CONFIG.NUM_SI {6}] $dma_memory_ic
+    connect_bd_intf_net [get_bd_intf_pins rxbuf_session/m_axi_mem] [get_bd_intf_pins dma_memory_ic/S05_AXI]
+  }
   
   # Create interface connections
   connect_bd_intf_net -intf_net microblaze_0_dlmb_1 [get_bd_intf_pins microblaze_0/DLMB] [get_bd_intf_pins microblaze_0_local_memory/DLMB]
@@ -557,10 +565,12 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
   connect_bd_intf_net [get_bd_intf_pins call_req] [get_bd_intf_pins microblaze_0/S0_AXIS]
   connect_bd_intf_net [get_bd_intf_pins call_ack] [get_bd_intf_pins microblaze_0/M0_AXIS]
 
-  connect_bd_intf_net [get_bd_intf_pins dma_mover/error] [get_bd_intf_pins fifo_dma_mover_error/S_AXIS]
+  connect_bd_intf_net [get_bd_intf_pins dma_mover/error] [get_bd_intf_pins collective_sequencer/sts_in]
+  connect_bd_intf_net [get_bd_intf_pins collective_sequencer/sts_out] [get_bd_intf_pins fifo_dma_mover_error/S_AXIS]
   connect_bd_intf_net [get_bd_intf_pins fifo_dma_mover_error/M_AXIS] [get_bd_intf_pins microblaze_0/S1_AXIS]
   connect_bd_intf_net [get_bd_intf_pins microblaze_0/M1_AXIS] [get_bd_intf_pins fifo_dma_mover_command/S_AXIS]
-  connect_bd_intf_net [get_bd_intf_pins fifo_dma_mover_command/M_AXIS] [get_bd_intf_pins dma_mover/command]
+  connect_bd_intf_net [get_bd_intf_pins fifo_dma_mover_command/M_AXIS] [get_bd_intf_pins collective_sequencer/cmd_in]
+  connect_bd_intf_net [get_bd_intf_pins collective_sequencer/cmd_out] [get_bd_intf_pins dma_mover/command]
 
   connect_bd_intf_net [get_bd_intf_pins dma_mover/rxbuf_req] [get_bd_intf_pins rxbuf_seek/rx_seek_request]
   connect_bd_intf_net [get_bd_intf_pins dma_mover/rxbuf_release_req] [get_bd_intf_pins rxbuf_seek/rx_release_request]
@@ -606,6 +616,7 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
                                       [get_bd_pins rxbuf_dequeue/ap_clk] \
                                       [get_bd_pins rxbuf_seek/ap_clk] \
                                       [get_bd_pins dma_mover/ap_clk] \
+                                      [get_bd_pins collective_sequencer/ap_clk] \
                                       [get_bd_pins fifo_dma_mover_command/s_axis_aclk] \
                                       [get_bd_pins fifo_dma_mover_error/s_axis_aclk] \
                                       [get_bd_pins dma_memory_ic/aclk]
@@ -638,6 +649,7 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
                                                                    [get_bd_pins rxbuf_dequeue/ap_rst_n] \
                                                                    [get_bd_pins rxbuf_seek/ap_rst_n] \
                                                                    [get_bd_pins dma_mover/ap_rst_n] \
+                                                                   [get_bd_pins collective_sequencer/ap_rst_n] \
                                                                    [get_bd_pins fifo_dma_mover_command/s_axis_aresetn] \
                                                                    [get_bd_pins fifo_dma_mover_error/s_axis_aresetn] \
                                                                    [get_bd_pins dma_memory_ic/aresetn]
@@ -655,6 +667,7 @@ proc create_hier_cell_control { parentCell nameHier {mbDebugLevel 0} {fanInSuppo
                               [get_bd_cells fifo_dma1_mm2s_sts] \
                               [get_bd_cells fifo_dma1_mm2s_cmd] \
                               [get_bd_cells dma_mover] \
+                              [get_bd_cells collective_sequencer] \
                               [get_bd_cells fifo_dma_mover_command] \
                               [get_bd_cells fifo_dma_mover_error] \
                               [get_bd_cells fifo_dma0_mm2s_cmd] \
@@ -24,7 +24,10 @@
 # enableCompression - 0/1 - enables compression feature
 # enableExtKrnlStream - 0/1 - enables PL stream attachments, providing support for non-memory send/recv
 # debugLevel - 0/1/2 - enables DEBUG/TRACE support for the control microblaze
-proc create_root_design { netStackType enableDMA enableArithmetic enableCompression enableExtKrnlStream debugLevel enableFanIn } {
+# enableFanIn - 0/1 - enables fan-in of many TCP sessions, with direct writes of rendezvous payload
+# enableUdpReliability - 0/1 - inserts selective-repeat retransmission on the UDP path; requires a UDP stack
+#                              which sets the RX TDEST to the index of the sending peer, as it does for TX
+proc create_root_design { netStackType enableDMA enableArithmetic enableCompression enableExtKrnlStream debugLevel enableFanIn enableUdpReliability } {
 
   if { ( $enableDMA == 0 ) && ( $enableExtKrnlStream == 0) } {
       catch {common::send_gid_msg -severity "ERROR" "No data sources and sinks enabled, please enable either DMAs or Streams"}
@@ -243,6 +246,7 @@ proc create_root_design { netStackType enableDMA enableArithmetic enableCompress
   assign_bd_address -offset 0x00070000 -range 0x00010000 -target_address_space [get_bd_addr_spaces control/microblaze_0/Data] [get_bd_addr_segs control/rxbuf_offload/rxbuf_seek/s_axi_control/Reg]
 
   assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/dma_offload/dma_mover/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
+  assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/dma_offload/collective_sequencer/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
   assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/rxbuf_offload/rxbuf_dequeue/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
   assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/rxbuf_offload/rxbuf_enqueue/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
   assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/rxbuf_offload/rxbuf_seek/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
@@ -293,6 +297,7 @@ proc create_root_design { netStackType enableDMA enableArithmetic enableCompress
   
     if { $enableFanIn == 1 } {
       connect_bd_intf_net [get_bd_intf_pins eth_rx_subsystem/m_axis_notification] [get_bd_intf_pins control/eth_depacketizer_notif]
+      assign_bd_address -offset 0x00000000 -range 0x00002000 -target_address_space [get_bd_addr_spaces control/rxbuf_offload/rxbuf_session/Data_m_axi_mem] [get_bd_addr_segs control/exchange_mem/axi_bram_ctrl_bypass/S_AXI/Mem0]
     }
 
     connect_bd_intf_net [get_bd_intf_ports s_axis_eth_rx_data] [get_bd_intf_pins eth_rx_subsystem/s_axis_rx_data]
@@ -329,12 +334,23 @@ proc create_root_design { netStackType enableDMA enableArithmetic enableCompress
     create_udp_tx_subsystem [current_bd_instance .] eth_tx_subsystem
     create_udp_rx_subsystem [current_bd_instance .] eth_rx_subsystem
 
-    connect_bd_intf_net [get_bd_intf_ports s_axis_eth_rx_data] [get_bd_intf_pins eth_rx_subsystem/s_axis_data]
+    if { $enableUdpReliability == 1 } {
+      # selective-repeat retransmission between the packetizers and the network
+      set udp_reliability_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:udp_reliability:1.0 udp_reliability_0 ]
+      connect_bd_intf_net [get_bd_intf_ports s_axis_eth_rx_data] [get_bd_intf_pins udp_reliability_0/rx_in]
+      connect_bd_intf_net [get_bd_intf_pins udp_reliability_0/rx_out] [get_bd_intf_pins eth_rx_subsystem/s_axis_data]
+      connect_bd_intf_net [get_bd_intf_pins eth_tx_subsystem/m_axis_data] [get_bd_intf_pins udp_reliability_0/tx_in]
+      connect_bd_intf_net [get_bd_intf_ports m_axis_eth_tx_data] [get_bd_intf_pins udp_reliability_0/tx_out]
+      connect_bd_net [get_bd_ports ap_clk] [get_bd_pins udp_reliability_0/ap_clk]
+      connect_bd_net [get_bd_pins control/encore_aresetn] [get_bd_pins udp_reliability_0/ap_rst_n]
+    } else {
+      connect_bd_intf_net [get_bd_intf_ports s_axis_eth_rx_data] [get_bd_intf_pins eth_rx_subsystem/s_axis_data]
+      connect_bd_intf_net [get_bd_intf_pins eth_tx_subsystem/m_axis_data] [get_bd_intf_ports m_axis_eth_tx_data]
+    }
     connect_bd_intf_net [get_bd_intf_pins control/eth_depacketizer_sts] [get_bd_intf_pins eth_rx_subsystem/m_axis_status]
     connect_bd_intf_net [get_bd_intf_pins control/eth_packetizer_cmd] [get_bd_intf_pins eth_tx_subsystem/s_axis_command]
     connect_bd_intf_net [get_bd_intf_pins axis_switch_0/M02_AXIS] [get_bd_intf_pins eth_tx_subsystem/s_axis_data]
     connect_bd_intf_net [get_bd_intf_pins eth_rx_subsystem/m_axis_data] [get_bd_intf_pins axis_switch_0/S02_AXIS]
-    connect_bd_intf_net [get_bd_intf_ports m_axis_eth_tx_data] [get_bd_intf_pins eth_tx_subsystem/m_axis_data]
     connect_bd_intf_net [get_bd_intf_pins control/eth_packetizer_sts] [get_bd_intf_pins eth_tx_subsystem/m_axis_sts]
 
     connect_bd_intf_net -intf_net udp_packetizer_control [get_bd_intf_pins control_xbar/M00_AXI] [get_bd_intf_pins eth_tx_subsystem/s_axi_control]
@@ -70,19 +70,24 @@ proc create_udp_tx_subsystem { parentCell nameHier } {
 
   # Create TX instances and set properties
   set udp_packetizer_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:udp_packetizer:1.0 udp_packetizer_0 ]
+  set eth_fanout_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:eth_fanout:1.0 eth_fanout_0 ]
 
   # Create interface connections
   connect_bd_intf_net -intf_net status [get_bd_intf_pins m_axis_sts] [get_bd_intf_pins udp_packetizer_0/sts]
   connect_bd_intf_net -intf_net control [get_bd_intf_pins s_axi_control] [get_bd_intf_pins udp_packetizer_0/s_axi_control]
-  connect_bd_intf_net -intf_net command [get_bd_intf_pins s_axis_command] [get_bd_intf_pins udp_packetizer_0/cmd]
+  connect_bd_intf_net -intf_net command [get_bd_intf_pins s_axis_command] [get_bd_intf_pins eth_fanout_0/cmd_in]
+  connect_bd_intf_net -intf_net fanout2pkt_cmd [get_bd_intf_pins eth_fanout_0/cmd_out] [get_bd_intf_pins udp_packetizer_0/cmd]
   connect_bd_intf_net -intf_net pkt2fifo [get_bd_intf_pins m_axis_data] [get_bd_intf_pins tx_fifo/M_AXIS]
-  connect_bd_intf_net -intf_net in2pkt [get_bd_intf_pins s_axis_data] [get_bd_intf_pins udp_packetizer_0/in_r]
+  connect_bd_intf_net -intf_net in2fanout [get_bd_intf_pins s_axis_data] [get_bd_intf_pins eth_fanout_0/in_r]
+  connect_bd_intf_net -intf_net in2pkt [get_bd_intf_pins eth_fanout_0/out_r] [get_bd_intf_pins udp_packetizer_0/in_r]
   connect_bd_intf_net -intf_net fifo2out [get_bd_intf_pins tx_fifo/S_AXIS] [get_bd_intf_pins udp_packetizer_0/out_r]
 
   # Create port connections
   connect_bd_net -net ap_clk [get_bd_pins ap_clk]  [get_bd_pins tx_fifo/s_axis_aclk] \
+                                                   [get_bd_pins eth_fanout_0/ap_clk] \
                                                    [get_bd_pins udp_packetizer_0/ap_clk]
   connect_bd_net -net ap_rst_n [get_bd_pins ap_rst_n] [get_bd_pins tx_fifo/s_axis_aresetn] \
+                                                      [get_bd_pins eth_fanout_0/ap_rst_n] \
                                                       [get_bd_pins udp_packetizer_0/ap_rst_n]
 
   # Restore current instance
@@ -148,12 +153,15 @@ proc create_tcp_tx_subsystem { parentCell nameHier } {
   # Create TX instances and set properties
   set tcp_packetizer_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:tcp_packetizer:1.0 tcp_packetizer_0 ]
   set tcp_txHandler_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:tcp_txHandler:1.0 tcp_txHandler_0 ]
+  set eth_fanout_0 [ create_bd_cell -type ip -vlnv xilinx.com:hls:eth_fanout:1.0 eth_fanout_0 ]
 
   # Create interface connections
   connect_bd_intf_net -intf_net control [get_bd_intf_pins s_axi_control] [get_bd_intf_pins tcp_packetizer_0/s_axi_control]
   connect_bd_intf_net -intf_net Conn3 [get_bd_intf_pins m_axis_tx_data] [get_bd_intf_pins tx_fifo/M_AXIS]
-  connect_bd_intf_net -intf_net cmd_V_1 [get_bd_intf_pins s_axis_pktcmd] [get_bd_intf_pins tcp_packetizer_0/cmd]
-  connect_bd_intf_net -intf_net in_r_1 [get_bd_intf_pins s_axis_tx_data] [get_bd_intf_pins tcp_packetizer_0/in_r]
+  connect_bd_intf_net -intf_net cmd_V_1 [get_bd_intf_pins s_axis_pktcmd] [get_bd_intf_pins eth_fanout_0/cmd_in]
+  connect_bd_intf_net -intf_net eth_fanout_0_cmd_out [get_bd_intf_pins eth_fanout_0/cmd_out] [get_bd_intf_pins tcp_packetizer_0/cmd]
+  connect_bd_intf_net -intf_net in_r_1 [get_bd_intf_pins s_axis_tx_data] [get_bd_intf_pins eth_fanout_0/in_r]
+  connect_bd_intf_net -intf_net eth_fanout_0_out_r [get_bd_intf_pins eth_fanout_0/out_r] [get_bd_intf_pins tcp_packetizer_0/in_r]
   connect_bd_intf_net -intf_net status [get_bd_intf_pins m_axis_packetizer_sts] [get_bd_intf_pins tcp_packetizer_0/sts]
   connect_bd_intf_net -intf_net s_axis_tx_status_1 [get_bd_intf_pins s_axis_tx_status] [get_bd_intf_pins tcp_txHandler_0/s_axis_tcp_tx_status]
   connect_bd_intf_net -intf_net tcp_packetizer_0_cmd_txHandler [get_bd_intf_pins tcp_packetizer_0/cmd_txHandler] [get_bd_intf_pins tcp_txHandler_0/cmd_txHandler]
@@ -163,9 +171,11 @@ proc create_tcp_tx_subsystem { parentCell nameHier } {
 
   # Create port connections
   connect_bd_net -net ap_clk [get_bd_pins ap_clk]  [get_bd_pins tcp_packetizer_0/ap_clk] \
+                                                   [get_bd_pins eth_fanout_0/ap_clk] \
                                                    [get_bd_pins tcp_txHandler_0/ap_clk] \
                                                    [get_bd_pins tx_fifo/s_axis_aclk]
   connect_bd_net -net ap_rst_n [get_bd_pins ap_rst_n] [get_bd_pins tcp_packetizer_0/ap_rst_n] \
+                                                      [get_bd_pins eth_fanout_0/ap_rst_n] \
                                                       [get_bd_pins tcp_txHandler_0/ap_rst_n] \
                                                       [get_bd_pins tx_fifo/s_axis_aresetn]
 
@@ -0,0 +1,142 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_int.h"
+#include "lp_stream_conv.h"
+
+//pack (in_width/out_width) input words into each output word;
+//a partial output word is flushed on TLAST with its unused lanes masked off
+template<class CONV>
+void stream_narrow(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+    unsigned const iw = CONV::in_width;
+    unsigned const ow = CONV::out_width;
+    unsigned const simd = DATA_WIDTH / iw;
+    unsigned const ratio = iw / ow;
+
+    int done = 0;
+    unsigned int idx = 0;
+    unsigned int elem = 0;
+    stream_word in_block;
+    stream_word wword;
+    wword.keep = 0;
+
+    while(done == 0) {
+#pragma HLS PIPELINE II=1
+        in_block = STREAM_READ(in);
+        for (unsigned int j = 0; j < simd; j++) {
+#pragma HLS UNROLL
+            unsigned int lane = idx*simd + j;
+            ap_uint<iw> in_word = in_block.data((j+1)*iw-1,j*iw);
+            wword.data((lane+1)*ow-1,lane*ow) = CONV::apply(in_word, elem+j);
+            wword.keep((lane+1)*(ow/8)-1,lane*(ow/8)) = (in_block.keep((j+1)*(iw/8)-1,j*(iw/8)) == ((1<<(iw/8))-1)) ? ((1<<(ow/8))-1) : 0;
+        }
+        elem += simd;
+        done = (in_block.last == 1);
+        if(done || idx == ratio-1){
+            wword.last = in_block.last;
+            STREAM_WRITE(out, wword);
+            wword.keep = 0;
+            idx = 0;
+        } else{
+            idx++;
+        }
+    }
+}
+
+//unpack each input word into (out_width/in_width) output words; emission
+//stops early at TLAST once the remaining input lanes are empty
+template<class CONV>
+void stream_widen(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+    unsigned const iw = CONV::in_width;
+    unsigned const ow = CONV::out_width;
+    unsigned const simd = DATA_WIDTH / ow;
+    unsigned const ratio = ow / iw;
+
+    int done = 0;
+    unsigned int idx = 0;
+    stream_word in_block;
+    stream_word wword;
+
+    while(done == 0) {
+#pragma HLS PIPELINE II=1
+        if(idx == 0){
+            in_block = STREAM_READ(in);
+        }
+        for (unsigned int j = 0; j < simd; j++) {
+#pragma HLS UNROLL
+            unsigned int lane = idx*simd + j;
+            ap_uint<iw> in_word = in_block.data((lane+1)*iw-1,lane*iw);
+            wword.data((j+1)*ow-1,j*ow) = CONV::apply(in_word);
+            wword.keep((j+1)*(ow/8)-1,j*(ow/8)) = (in_block.keep((lane+1)*(iw/8)-1,lane*(iw/8)) == ((1<<(iw/8))-1)) ? ((1<<(ow/8))-1) : 0;
+        }
+        ap_uint<DATA_WIDTH/8> remaining_keep = in_block.keep >> ((idx+1)*simd*(iw/8));
+        bool last_chunk = (idx == ratio-1) || (remaining_keep == 0);
+        wword.last = (in_block.last == 1) && last_chunk;
+        STREAM_WRITE(out, wword);
+        done = (wword.last == 1);
+        idx = last_chunk ? 0 : idx+1;
+    }
+}
+
+void fp_bf16_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_narrow<conv_fp32_bf16>(in, out);
+}
+
+void fp_bf16_sr_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_narrow<conv_fp32_bf16_sr>(in, out);
+}
+
+void bf16_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_widen<conv_bf16_fp32>(in, out);
+}
+
+void fp_fp8e4m3_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_narrow<conv_fp32_fp8e4m3>(in, out);
+}
+
+void fp8e4m3_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_widen<conv_fp8e4m3_fp32>(in, out);
+}
+
+void fp_fp8e5m2_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_narrow<conv_fp32_fp8e5m2>(in, out);
+}
+
+void fp8e5m2_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_widen<conv_fp8e5m2_fp32>(in, out);
+}
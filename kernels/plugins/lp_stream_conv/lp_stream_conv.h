@@ -0,0 +1,71 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "streamdefines.h"
+#include "lp_float.h"
+
+//element converters used by the generic narrowing/widening stream kernels;
+//narrowing converters also receive the element index within the packet
+struct conv_fp32_bf16 {
+    static const unsigned int in_width = 32;
+    static const unsigned int out_width = 16;
+    static ap_uint<16> apply(ap_uint<32> x, unsigned int idx){ return fp32_to_bf16(x); }
+};
+struct conv_fp32_bf16_sr {
+    static const unsigned int in_width = 32;
+    static const unsigned int out_width = 16;
+    static ap_uint<16> apply(ap_uint<32> x, unsigned int idx){ return fp32_to_bf16_sr(x, lp_dither(x, idx)); }
+};
+struct conv_bf16_fp32 {
+    static const unsigned int in_width = 16;
+    static const unsigned int out_width = 32;
+    static ap_uint<32> apply(ap_uint<16> x){ return bf16_to_fp32(x); }
+};
+struct conv_fp32_fp8e4m3 {
+    static const unsigned int in_width = 32;
+    static const unsigned int out_width = 8;
+    static ap_uint<8> apply(ap_uint<32> x, unsigned int idx){ return fp32_to_fp8e4m3(x); }
+};
+struct conv_fp8e4m3_fp32 {
+    static const unsigned int in_width = 8;
+    static const unsigned int out_width = 32;
+    static ap_uint<32> apply(ap_uint<8> x){ return fp8e4m3_to_fp32(x); }
+};
+struct conv_fp32_fp8e5m2 {
+    static const unsigned int in_width = 32;
+    static const unsigned int out_width = 8;
+    static ap_uint<8> apply(ap_uint<32> x, unsigned int idx){ return fp32_to_fp8e5m2(x); }
+};
+struct conv_fp8e5m2_fp32 {
+    static const unsigned int in_width = 8;
+    static const unsigned int out_width = 32;
+    static ap_uint<32> apply(ap_uint<8> x){ return fp8e5m2_to_fp32(x); }
+};
+
+template<class CONV>
+void stream_narrow(STREAM<stream_word> & in, STREAM<stream_word> & out);
+
+template<class CONV>
+void stream_widen(STREAM<stream_word> & in, STREAM<stream_word> & out);
+
+void fp_bf16_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void fp_bf16_sr_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void bf16_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void fp_fp8e4m3_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void fp8e4m3_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void fp_fp8e5m2_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void fp8e5m2_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
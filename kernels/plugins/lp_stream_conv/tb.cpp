@@ -0,0 +1,191 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_axi_sdata.h"
+#include "hls_stream.h"
+#include "ap_int.h"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "lp_stream_conv.h"
+
+using namespace hls;
+using namespace std;
+
+typedef void (*stream_conv)(STREAM<stream_word> &, STREAM<stream_word> &);
+
+//compress len fp32 elements through narrow, check against the scalar
+//conversion, then decompress through widen and check against the scalar decode
+template<class NARROW, class WIDEN>
+int test_lane(stream_conv narrow, stream_conv widen, int len){
+    unsigned const cw = NARROW::out_width;
+    unsigned const simd_in = DATA_WIDTH/32;
+    unsigned const simd_c = DATA_WIDTH/cw;
+
+    STREAM<stream_word> in;
+    STREAM<stream_word> compressed;
+    STREAM<stream_word> out;
+    vector<ap_uint<32> > src(len);
+    stream_word inword;
+
+    for(int i=0; i<len; i++){
+        //wide dynamic range, including values which under/overflow fp8
+        float f = (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f);
+        f = ldexpf(f, (rand() % 40) - 20);
+        src[i] = *reinterpret_cast<ap_uint<32>*>(&f);
+    }
+    for(int i=0; i<len; i+=simd_in){
+        inword.data = 0;
+        inword.keep = 0;
+        for(int j=0; j<simd_in && i+j<len; j++){
+            inword.data((j+1)*32-1,j*32) = src[i+j];
+            inword.keep((j+1)*4-1,j*4) = 15;
+        }
+        inword.last = (i+simd_in >= len);
+        STREAM_WRITE(in, inword);
+    }
+
+    narrow(in, compressed);
+
+    //check compressed stream and replay it into the decompressor
+    STREAM<stream_word> compressed_copy;
+    for(int i=0; i<len; i+=simd_c){
+        stream_word cword = STREAM_READ(compressed);
+        STREAM_WRITE(compressed_copy, cword);
+        if(cword.last != (i+simd_c >= len)){
+            cout << "Mismatch on compressed tlast" << endl;
+            return 1;
+        }
+        for(int j=0; j<simd_c; j++){
+            bool valid = (i+j < len);
+            if(cword.keep((j+1)*(cw/8)-1,j*(cw/8)) != (valid ? ((1<<(cw/8))-1) : 0)){
+                cout << "Mismatch on compressed tkeep" << endl;
+                return 1;
+            }
+            if(valid && cword.data((j+1)*cw-1,j*cw) != NARROW::apply(src[i+j], i+j)){
+                cout << "Mismatch on compressed element " << i+j << endl;
+                return 1;
+            }
+        }
+    }
+
+    widen(compressed_copy, out);
+
+    for(int i=0; i<len; i+=simd_in){
+        stream_word outword = STREAM_READ(out);
+        if(outword.last != (i+simd_in >= len)){
+            cout << "Mismatch on decompressed tlast" << endl;
+            return 1;
+        }
+        for(int j=0; j<simd_in; j++){
+            bool valid = (i+j < len);
+            if(outword.keep((j+1)*4-1,j*4) != (valid ? 15 : 0)){
+                cout << "Mismatch on decompressed tkeep" << endl;
+                return 1;
+            }
+            if(valid && outword.data((j+1)*32-1,j*32) != WIDEN::apply(NARROW::apply(src[i+j], i+j))){
+                cout << "Mismatch on decompressed element " << i+j << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+float to_float(ap_uint<32> x){
+    uint32_t u = x.to_uint();
+    return *reinterpret_cast<float*>(&u);
+}
+
+ap_uint<32> from_float(float f){
+    return *reinterpret_cast<uint32_t*>(&f);
+}
+
+//stochastic rounding must round up with probability equal to the discarded fraction
+int test_sr_probability(){
+    //1 + 2^-9 sits a quarter of a bf16 ulp above 1.0
+    float f = 1.0f + 1.0f/512;
+    int nup = 0;
+    int ntrials = 10000;
+    for(int i=0; i<ntrials; i++){
+        if(to_float(bf16_to_fp32(conv_fp32_bf16_sr::apply(from_float(f), i))) > 1.0f){
+            nup++;
+        }
+    }
+    float p = (float)nup/ntrials;
+    cout << "Stochastic rounding up-probability " << p << " (expected 0.25)" << endl;
+    return (p < 0.22f || p > 0.28f);
+}
+
+//model a ring reduction in which each hop decompresses the incoming partial sum,
+//adds its fp32 contribution and recompresses, and report the error against an
+//exact reference; skewed inputs add many small contributions to a large one
+template<class NARROW, class WIDEN>
+void ring_accuracy(const char *label, int nranks, bool skewed){
+    int const len = 4096;
+    double bias = 0, rms = 0;
+    for(int i=0; i<len; i++){
+        double exact = 0;
+        float acc = 0;
+        for(int r=0; r<nranks; r++){
+            float x = skewed ? ((r == 0) ? 1.0f : 1e-3f*(static_cast <float> (rand()) / static_cast <float> (RAND_MAX))) :
+                               (2.0f*static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 1.0f);
+            exact += x;
+            acc = (r == 0) ? x : to_float(WIDEN::apply(NARROW::apply(from_float(acc), r*len+i))) + x;
+        }
+        double err = to_float(WIDEN::apply(NARROW::apply(from_float(acc), nranks*len+i))) - exact;
+        bias += err;
+        rms += err*err;
+    }
+    cout << label << " ranks=" << nranks << (skewed ? " skewed" : " uniform") << " bias=" << bias/len << " rms=" << sqrt(rms/len) << endl;
+}
+
+int main(){
+    srand(42);
+    //lengths cover full words, a partial last word and a partial compressed word
+    int lengths[] = {16, 64, 216, 1000};
+    for(int len : lengths){
+        if(test_lane<conv_fp32_bf16, conv_bf16_fp32>(fp_bf16_stream_conv, bf16_fp_stream_conv, len)){
+            cout << "bf16 lane failed for " << len << " elements" << endl;
+            return 1;
+        }
+        if(test_lane<conv_fp32_bf16_sr, conv_bf16_fp32>(fp_bf16_sr_stream_conv, bf16_fp_stream_conv, len)){
+            cout << "bf16 stochastic rounding lane failed for " << len << " elements" << endl;
+            return 1;
+        }
+        if(test_lane<conv_fp32_fp8e4m3, conv_fp8e4m3_fp32>(fp_fp8e4m3_stream_conv, fp8e4m3_fp_stream_conv, len)){
+            cout << "fp8 E4M3 lane failed for " << len << " elements" << endl;
+            return 1;
+        }
+        if(test_lane<conv_fp32_fp8e5m2, conv_fp8e5m2_fp32>(fp_fp8e5m2_stream_conv, fp8e5m2_fp_stream_conv, len)){
+            cout << "fp8 E5M2 lane failed for " << len << " elements" << endl;
+            return 1;
+        }
+    }
+    if(test_sr_probability()){
+        return 1;
+    }
+    //accuracy of bf16 wire compression with round-to-nearest-even vs stochastic rounding
+    for(int nranks = 2; nranks <= 64; nranks *= 2){
+        for(int skewed = 0; skewed < 2; skewed++){
+            ring_accuracy<conv_fp32_bf16, conv_bf16_fp32>("bf16 RNE", nranks, skewed);
+            ring_accuracy<conv_fp32_bf16_sr, conv_bf16_fp32>("bf16 SR ", nranks, skewed);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_int.h"
+#include "q8_stream_conv.h"
+
+void fp_q8_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+    unsigned const simd = DATA_WIDTH / 32;
+
+    bool done = false;
+    unsigned int nblk = 0;
+    stream_word in_block;
+    stream_word wword;
+    stream_word trailer;
+    trailer.keep = 0;
+
+    while(!done) {
+        ap_uint<DATA_WIDTH> blk[Q8_BLOCK_WORDS];
+        ap_uint<DATA_WIDTH/8> blk_keep[Q8_BLOCK_WORDS];
+#pragma HLS ARRAY_PARTITION variable=blk complete
+#pragma HLS ARRAY_PARTITION variable=blk_keep complete
+        unsigned int max_mag = 0;
+        //gather one block, tracking the largest magnitude in it
+        for (unsigned int i = 0; i < Q8_BLOCK_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+            if(!done){
+                in_block = STREAM_READ(in);
+                blk[i] = in_block.data;
+                blk_keep[i] = in_block.keep;
+                done = (in_block.last == 1);
+                for (unsigned int j = 0; j < simd; j++) {
+#pragma HLS UNROLL
+                    unsigned int mag = in_block.data((j+1)*32-2,j*32);
+                    max_mag = (mag > max_mag) ? mag : max_mag;
+                }
+            } else{
+                blk[i] = 0;
+                blk_keep[i] = 0;
+            }
+        }
+        unsigned int scale_exp = q8_scale_exp(max_mag);
+        for (unsigned int i = 0; i < Q8_BLOCK_WORDS; i++) {
+#pragma HLS UNROLL
+            for (unsigned int j = 0; j < simd; j++) {
+#pragma HLS UNROLL
+                unsigned int lane = i*simd + j;
+                wword.data((lane+1)*8-1,lane*8) = q8_quantize(blk[i]((j+1)*32-1,j*32), scale_exp);
+                wword.keep(lane,lane) = (blk_keep[i]((j+1)*4-1,j*4) == 15) ? 1 : 0;
+            }
+        }
+        wword.last = 0;
+        STREAM_WRITE(out, wword);
+        //record the scale, flush the trailer once full or at the end of the packet
+        trailer.data((nblk+1)*32-1,nblk*32) = scale_exp << 23;
+        trailer.keep((nblk+1)*4-1,nblk*4) = 15;
+        nblk++;
+        if(nblk == Q8_GROUP_BLOCKS || done){
+            trailer.last = done;
+            STREAM_WRITE(out, trailer);
+            trailer.keep = 0;
+            nblk = 0;
+        }
+    }
+}
+
+void q8_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+    unsigned const simd = DATA_WIDTH / 32;
+
+    bool done = false;
+    stream_word in_block;
+    stream_word wword;
+
+    while(!done) {
+        ap_uint<DATA_WIDTH> grp[Q8_GROUP_BLOCKS];
+        ap_uint<DATA_WIDTH/8> grp_keep[Q8_GROUP_BLOCKS];
+        unsigned int nblk = 0;
+        bool trailer = false;
+        //buffer a group of blocks until the trailer carrying their scales arrives
+        while(!trailer) {
+#pragma HLS PIPELINE II=1
+            in_block = STREAM_READ(in);
+            trailer = (nblk == Q8_GROUP_BLOCKS) || (in_block.last == 1);
+            if(!trailer){
+                grp[nblk] = in_block.data;
+                grp_keep[nblk] = in_block.keep;
+                nblk++;
+            }
+        }
+        done = (in_block.last == 1);
+        for (unsigned int b = 0; b < nblk; b++) {
+            unsigned int scale_exp = in_block.data(b*32+30,b*32+23);
+            for (unsigned int i = 0; i < Q8_BLOCK_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+                for (unsigned int j = 0; j < simd; j++) {
+#pragma HLS UNROLL
+                    unsigned int lane = i*simd + j;
+                    wword.data((j+1)*32-1,j*32) = q8_dequantize(grp[b]((lane+1)*8-1,lane*8), scale_exp);
+                    wword.keep((j+1)*4-1,j*4) = (grp_keep[b](lane,lane) == 1) ? 15 : 0;
+                }
+                wword.last = done && (b == nblk-1) && (i == Q8_BLOCK_WORDS-1);
+                STREAM_WRITE(out, wword);
+            }
+        }
+    }
+}
+
+//sum two block-quantized streams without leaving the integer domain: operands are
+//aligned to a common power-of-two scale by shifts (the finer operand is truncated
+//when the scales are more than 8 octaves apart), added exactly, then renormalized
+//to int8 with a single round-to-nearest-even
+void reduce_sum_q8(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+    bool done = false;
+    ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> op_block;
+    stream_word wword;
+    stream_word trailer;
+
+    while(!done) {
+        ap_uint<DATA_WIDTH> grp0[Q8_GROUP_BLOCKS];
+        ap_uint<DATA_WIDTH> grp1[Q8_GROUP_BLOCKS];
+        ap_uint<DATA_WIDTH/8> grp_keep[Q8_GROUP_BLOCKS];
+        unsigned int nblk = 0;
+        bool is_trailer = false;
+        //operands share the same block structure, buffer a group from both
+        while(!is_trailer) {
+#pragma HLS PIPELINE II=1
+            op_block = STREAM_READ(in);
+            is_trailer = (nblk == Q8_GROUP_BLOCKS) || (op_block.last == 1);
+            if(!is_trailer){
+                grp0[nblk] = op_block.data(DATA_WIDTH-1,0);
+                grp1[nblk] = op_block.data(2*DATA_WIDTH-1,DATA_WIDTH);
+                grp_keep[nblk] = op_block.keep(DATA_WIDTH/8-1,0);
+                nblk++;
+            }
+        }
+        done = (op_block.last == 1);
+        trailer.data = 0;
+        for (unsigned int b = 0; b < nblk; b++) {
+#pragma HLS PIPELINE II=1
+            int e0 = op_block.data(b*32+30,b*32+23);
+            int e1 = op_block.data(DATA_WIDTH+b*32+30,DATA_WIDTH+b*32+23);
+            int emax = (e0 > e1) ? e0 : e1;
+            int emin = (e0 > e1) ? e1 : e0;
+            int m = (emax - emin > 8) ? (emax - 8) : emin;
+            int t[Q8_BLOCK_ELEMS];
+#pragma HLS ARRAY_PARTITION variable=t complete
+            unsigned int maxabs = 0;
+            for (unsigned int j = 0; j < Q8_BLOCK_ELEMS; j++) {
+#pragma HLS UNROLL
+                int a = (int)(signed char)grp0[b]((j+1)*8-1,j*8).to_uint();
+                int c = (int)(signed char)grp1[b]((j+1)*8-1,j*8).to_uint();
+                a = (e0 >= m) ? a * (1 << (e0 - m)) : (a >> (m - e0));
+                c = (e1 >= m) ? c * (1 << (e1 - m)) : (c >> (m - e1));
+                t[j] = a + c;
+                unsigned int abs_t = (t[j] < 0) ? -t[j] : t[j];
+                maxabs = (abs_t > maxabs) ? abs_t : maxabs;
+            }
+            //smallest right shift which brings every lane back into int8 range
+            unsigned int r = 0;
+            for (unsigned int k = 0; k < 10; k++) {
+#pragma HLS UNROLL
+                if(((maxabs + ((1 << r) >> 1)) >> r) > 127){
+                    r++;
+                }
+            }
+            unsigned int scale_exp = m + r;
+            for (unsigned int j = 0; j < Q8_BLOCK_ELEMS; j++) {
+#pragma HLS UNROLL
+                unsigned int mag = (t[j] < 0) ? -t[j] : t[j];
+                unsigned int kept = mag >> r;
+                if(r > 0){
+                    unsigned int rem = mag & ((1 << r) - 1);
+                    unsigned int half = 1 << (r - 1);
+                    kept += (rem > half || (rem == half && (kept & 1))) ? 1 : 0;
+                }
+                if(kept > 127){
+                    kept = 127;
+                }
+                wword.data((j+1)*8-1,j*8) = (t[j] < 0) ? (256 - kept) : kept;
+            }
+            wword.keep = grp_keep[b];
+            wword.last = 0;
+            STREAM_WRITE(out, wword);
+            trailer.data((b+1)*32-1,b*32) = scale_exp << 23;
+        }
+        trailer.keep = op_block.keep(DATA_WIDTH/8-1,0);
+        trailer.last = op_block.last;
+        STREAM_WRITE(out, trailer);
+    }
+}
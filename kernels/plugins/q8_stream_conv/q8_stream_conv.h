@@ -0,0 +1,96 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "streamdefines.h"
+#include "ap_int.h"
+
+//Block-scaled int8 format. Every block of Q8_BLOCK_ELEMS fp32 values is quantized
+//against a shared power-of-two fp32 scale into one datapath word of int8 values.
+//The scales of up to Q8_GROUP_BLOCKS consecutive blocks follow their data words in
+//a trailer word, which is only partially filled at the end of a packet, so the
+//compressed size is exactly 68 bytes per 64 elements. The matching arithmetic
+//config uses elem_ratio_log=6 and compressed_elem_bytes=68; counts (and segment
+//counts) must be multiples of Q8_BLOCK_ELEMS.
+#define Q8_BLOCK_ELEMS (DATA_WIDTH/8)
+#define Q8_BLOCK_WORDS (Q8_BLOCK_ELEMS*32/DATA_WIDTH)
+#define Q8_GROUP_BLOCKS (DATA_WIDTH/32)
+
+//block scale exponent (fp32 exponent field of the scale) from the largest
+//magnitude in the block, such that it quantizes to [64, 127]
+inline unsigned int q8_scale_exp(unsigned int max_mag){
+#pragma HLS INLINE
+    unsigned int max_exp = max_mag >> 23;
+    //magnitudes of 127.5 or more relative to the scale would round to 128
+    if((max_mag & 0x7fffff) >= 0x7f0000){
+        max_exp++;
+    }
+    return (max_exp > 7) ? (max_exp - 6) : 1;
+}
+
+//round-to-nearest-even quantization of an fp32 value against scale 2^(scale_exp-127)
+inline ap_uint<8> q8_quantize(ap_uint<32> x, unsigned int scale_exp){
+#pragma HLS INLINE
+    unsigned int bits = x.to_uint();
+    unsigned int exp = (bits >> 23) & 0xff;
+    if(exp == 0){
+        return 0;
+    }
+    unsigned int full = (bits & 0x7fffff) | (1 << 23);
+    int sh = 23 + (int)scale_exp - (int)exp;
+    if(sh > 25){
+        return 0;
+    }
+    if(sh < 1){
+        //value above the block maximum, saturate
+        sh = 1;
+    }
+    unsigned int kept = full >> sh;
+    unsigned int rem = full & ((1 << sh) - 1);
+    unsigned int half = 1 << (sh - 1);
+    kept += (rem > half || (rem == half && (kept & 1))) ? 1 : 0;
+    if(kept > 127){
+        kept = 127;
+    }
+    return (bits >> 31) ? (ap_uint<8>)(256 - kept) : (ap_uint<8>)kept;
+}
+
+inline ap_uint<32> q8_dequantize(ap_uint<8> q, unsigned int scale_exp){
+#pragma HLS INLINE
+    unsigned int qu = q.to_uint();
+    unsigned int sign = (qu >> 7) & 1;
+    unsigned int mag = sign ? (256 - qu) : qu;
+    if(mag == 0){
+        return 0;
+    }
+    //normalize the magnitude, at most 8 significant bits
+    unsigned int p = 7;
+    for(unsigned int i = 0; i < 7; i++){
+#pragma HLS UNROLL
+        if((mag & (1 << p)) == 0){
+            p--;
+        }
+    }
+    unsigned int exp = scale_exp + p;
+    if(exp > 254){
+        return (sign << 31) | (0xff << 23);
+    }
+    return (sign << 31) | (exp << 23) | ((mag << (23 - p)) & 0x7fffff);
+}
+
+void fp_q8_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void q8_fp_stream_conv(STREAM<stream_word> & in, STREAM<stream_word> & out);
+void reduce_sum_q8(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
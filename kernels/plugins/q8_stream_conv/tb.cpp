@@ -0,0 +1,200 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_axi_sdata.h"
+#include "hls_stream.h"
+#include "ap_int.h"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "q8_stream_conv.h"
+
+using namespace std;
+
+float to_float(ap_uint<32> x){
+    uint32_t u = x.to_uint();
+    return *reinterpret_cast<float*>(&u);
+}
+
+ap_uint<32> from_float(float f){
+    return *reinterpret_cast<uint32_t*>(&f);
+}
+
+float scale_of(unsigned int scale_exp){
+    return ldexpf(1.0f, (int)scale_exp - 127);
+}
+
+void write_fp32(STREAM<stream_word> & s, vector<float> & src){
+    unsigned const simd = DATA_WIDTH/32;
+    stream_word w;
+    for(unsigned int i=0; i<src.size(); i+=simd){
+        for(unsigned int j=0; j<simd; j++){
+            w.data((j+1)*32-1,j*32) = from_float(src[i+j]);
+        }
+        w.keep = -1;
+        w.last = (i+simd >= src.size());
+        STREAM_WRITE(s, w);
+    }
+}
+
+//read back a compressed packet, checking its framing, and return values and block scales
+int read_q8(STREAM<stream_word> & s, int len, vector<int> & q, vector<unsigned int> & scale_exp){
+    int nblocks = len/Q8_BLOCK_ELEMS;
+    for(int b=0; b<nblocks; b+=Q8_GROUP_BLOCKS){
+        int ngrp = min(Q8_GROUP_BLOCKS, nblocks-b);
+        for(int k=0; k<ngrp; k++){
+            stream_word w = STREAM_READ(s);
+            if(w.last != 0){
+                cout << "Unexpected tlast on data word" << endl;
+                return 1;
+            }
+            for(int j=0; j<Q8_BLOCK_ELEMS; j++){
+                q.push_back((signed char)w.data((j+1)*8-1,j*8).to_uint());
+            }
+        }
+        stream_word t = STREAM_READ(s);
+        if(t.last != (b+ngrp == nblocks)){
+            cout << "Mismatch on trailer tlast" << endl;
+            return 1;
+        }
+        for(int k=0; k<Q8_GROUP_BLOCKS; k++){
+            if(t.keep((k+1)*4-1,k*4) != ((k < ngrp) ? 15 : 0)){
+                cout << "Mismatch on trailer tkeep" << endl;
+                return 1;
+            }
+            if(k < ngrp){
+                scale_exp.push_back(t.data(k*32+30,k*32+23).to_uint());
+            }
+        }
+    }
+    return 0;
+}
+
+int test_roundtrip(int len){
+    STREAM<stream_word> in, compressed, copy, out;
+    vector<float> src(len);
+    for(int i=0; i<len; i++){
+        //vary the dynamic range from block to block
+        src[i] = ldexpf(static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f, (i/Q8_BLOCK_ELEMS) % 20 - 10);
+    }
+    write_fp32(in, src);
+    fp_q8_stream_conv(in, compressed);
+    //duplicate the compressed stream, one copy for checking, one for decompression
+    int nwords = (len/Q8_BLOCK_ELEMS) + (len/Q8_BLOCK_ELEMS + Q8_GROUP_BLOCKS - 1)/Q8_GROUP_BLOCKS;
+    STREAM<stream_word> check;
+    for(int i=0; i<nwords; i++){
+        stream_word w = STREAM_READ(compressed);
+        STREAM_WRITE(check, w);
+        STREAM_WRITE(copy, w);
+    }
+    if(!STREAM_IS_EMPTY(compressed)){
+        cout << "Compressed stream longer than 68B per block" << endl;
+        return 1;
+    }
+    vector<int> q;
+    vector<unsigned int> scale_exp;
+    if(read_q8(check, len, q, scale_exp)){
+        return 1;
+    }
+    q8_fp_stream_conv(copy, out);
+    unsigned const simd = DATA_WIDTH/32;
+    for(int i=0; i<len; i+=simd){
+        stream_word w = STREAM_READ(out);
+        if(w.last != (i+simd >= len)){
+            cout << "Mismatch on decompressed tlast" << endl;
+            return 1;
+        }
+        for(int j=0; j<simd; j++){
+            float s = scale_of(scale_exp[(i+j)/Q8_BLOCK_ELEMS]);
+            float r = to_float(w.data((j+1)*32-1,j*32));
+            if(r != q[i+j]*s || fabs(r - src[i+j]) > s/2){
+                cout << "Mismatch on element " << i+j << ": " << src[i+j] << " -> " << r << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int test_reduce(int len){
+    STREAM<stream_word> in0, in1, c0, c1, res;
+    STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > op;
+    vector<float> src0(len), src1(len);
+    for(int i=0; i<len; i++){
+        src0[i] = ldexpf(static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f, (i/Q8_BLOCK_ELEMS) % 12);
+        src1[i] = ldexpf(static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f, 11 - (i/Q8_BLOCK_ELEMS) % 12);
+    }
+    write_fp32(in0, src0);
+    write_fp32(in1, src1);
+    fp_q8_stream_conv(in0, c0);
+    fp_q8_stream_conv(in1, c1);
+    //keep a reference copy of the dequantized operands
+    STREAM<stream_word> r0, r1;
+    vector<int> q0, q1, qr;
+    vector<unsigned int> e0, e1, er;
+    int nwords = (len/Q8_BLOCK_ELEMS) + (len/Q8_BLOCK_ELEMS + Q8_GROUP_BLOCKS - 1)/Q8_GROUP_BLOCKS;
+    for(int i=0; i<nwords; i++){
+        stream_word w0 = STREAM_READ(c0);
+        stream_word w1 = STREAM_READ(c1);
+        STREAM_WRITE(r0, w0);
+        STREAM_WRITE(r1, w1);
+        ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> w;
+        w.data(DATA_WIDTH-1,0) = w0.data;
+        w.data(2*DATA_WIDTH-1,DATA_WIDTH) = w1.data;
+        w.keep(DATA_WIDTH/8-1,0) = w0.keep;
+        w.keep(2*DATA_WIDTH/8-1,DATA_WIDTH/8) = w1.keep;
+        w.last = w0.last;
+        STREAM_WRITE(op, w);
+    }
+    if(read_q8(r0, len, q0, e0) || read_q8(r1, len, q1, e1)){
+        return 1;
+    }
+    reduce_sum_q8(op, res);
+    if(read_q8(res, len, qr, er)){
+        return 1;
+    }
+    for(int i=0; i<len; i++){
+        int b = i/Q8_BLOCK_ELEMS;
+        float exact = q0[i]*scale_of(e0[b]) + q1[i]*scale_of(e1[b]);
+        float r = qr[i]*scale_of(er[b]);
+        //one rounding to the result scale, plus truncation of an operand more than 8 octaves finer
+        float tol = scale_of(er[b])/2 + ((abs((int)e0[b]-(int)e1[b]) > 8) ? scale_of(max(e0[b],e1[b])-8) : 0);
+        if(fabs(r - exact) > tol){
+            cout << "Mismatch on reduced element " << i << ": " << exact << " -> " << r << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(){
+    srand(42);
+    //lengths cover a single block, a full group and partial trailing groups
+    int lengths[] = {64, 1024, 1088, 2560};
+    for(int len : lengths){
+        if(test_roundtrip(len)){
+            cout << "Block quantization round trip failed for " << len << " elements" << endl;
+            return 1;
+        }
+        if(test_reduce(len)){
+            cout << "Block quantized reduction failed for " << len << " elements" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
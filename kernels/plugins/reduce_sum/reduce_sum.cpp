@@ -24,8 +24,8 @@
 using namespace hls;
 using namespace std;
 
-template<unsigned int data_width, unsigned int dest_width, typename T>
-void stream_add(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in,
+template<unsigned int data_width, unsigned int dest_width, typename T, template<typename> class OP>
+void stream_reduce(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in,
                 STREAM<ap_axiu<data_width,0,0,dest_width> > & out) {
 
 	unsigned const dwb = 8*sizeof(T);
@@ -45,8 +45,8 @@ void stream_add(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in,
 			ap_uint<dwb> op2_word = op2((j+1)*dwb-1,j*dwb);
 			T op1_word_t = *reinterpret_cast<T*>(&op1_word);
 			T op2_word_t = *reinterpret_cast<T*>(&op2_word);
-			T sum = op1_word_t + op2_word_t;
-			ap_uint<dwb> res_word = *reinterpret_cast<ap_uint<dwb>*>(&sum);
+			T result = OP<T>::apply(op1_word_t, op2_word_t);
+			ap_uint<dwb> res_word = *reinterpret_cast<ap_uint<dwb>*>(&result);
 			res((j+1)*dwb-1,j*dwb) = res_word;
 		}
 		ap_axiu<data_width,0,0,dest_width> wword;
@@ -59,6 +59,12 @@ void stream_add(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in,
 	}
 }
 
+template<unsigned int data_width, unsigned int dest_width, typename T>
+void stream_add(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in,
+                STREAM<ap_axiu<data_width,0,0,dest_width> > & out) {
+	stream_reduce<data_width, dest_width, T, reduce_op_sum>(in, out);
+}
+
 void reduce_sum_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
 #pragma HLS INTERFACE axis register both port=in
 #pragma HLS INTERFACE axis register both port=out
@@ -87,6 +93,35 @@ void reduce_sum_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STRE
 stream_add<DATA_WIDTH, DEST_WIDTH, int64_t>(in, out);
 }
 
+//bfloat16 lanes compute in fp32 and round the result to nearest even
+void reduce_sum_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_add<DATA_WIDTH, DEST_WIDTH, bfloat16>(in, out);
+}
+
+void reduce_max_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, bfloat16, reduce_op_max>(in, out);
+}
+
+void reduce_min_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, bfloat16, reduce_op_min>(in, out);
+}
+
+void reduce_prod_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, bfloat16, reduce_op_prod>(in, out);
+}
+
 #ifdef REDUCE_HALF_PRECISION
 void reduce_sum_half(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
 #pragma HLS INTERFACE axis register both port=in
@@ -94,4 +129,130 @@ void reduce_sum_half(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<
 #pragma HLS INTERFACE ap_ctrl_none port=return
 stream_add<DATA_WIDTH, DEST_WIDTH, half>(in, out);
 }
-#endif
\ No newline at end of file
+#endif
+
+void reduce_max_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, float, reduce_op_max>(in, out);
+}
+
+void reduce_max_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, double, reduce_op_max>(in, out);
+}
+
+void reduce_max_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_max>(in, out);
+}
+
+void reduce_max_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_max>(in, out);
+}
+
+void reduce_min_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, float, reduce_op_min>(in, out);
+}
+
+void reduce_min_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, double, reduce_op_min>(in, out);
+}
+
+void reduce_min_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_min>(in, out);
+}
+
+void reduce_min_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_min>(in, out);
+}
+
+void reduce_prod_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, float, reduce_op_prod>(in, out);
+}
+
+void reduce_prod_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, double, reduce_op_prod>(in, out);
+}
+
+void reduce_prod_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_prod>(in, out);
+}
+
+void reduce_prod_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_prod>(in, out);
+}
+
+void reduce_band_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_band>(in, out);
+}
+
+void reduce_band_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_band>(in, out);
+}
+
+void reduce_bor_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_bor>(in, out);
+}
+
+void reduce_bor_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_bor>(in, out);
+}
+
+void reduce_bxor_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int32_t, reduce_op_bxor>(in, out);
+}
+
+void reduce_bxor_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+stream_reduce<DATA_WIDTH, DEST_WIDTH, int64_t, reduce_op_bxor>(in, out);
+}
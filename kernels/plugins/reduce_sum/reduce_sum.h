@@ -17,12 +17,28 @@
 
 #include "streamdefines.h"
 #include "ap_int.h"
+#include "lp_float.h"
 #include <stdint.h>
 
 #ifndef DATA_TYPE
 #define DATA_TYPE float
 #endif
 
+//element-wise reduction operators, applied to each SIMD lane of the arithmetic plugin
+template<typename T> struct reduce_op_sum  { static T apply(T a, T b){ return a + b; } };
+//floating point max/min propagate NaN from either operand, so the result does not depend
+//on the order in which ranks are combined; a != a only holds for NaN
+template<typename T> struct reduce_op_max  { static T apply(T a, T b){ return (a > b || a != a) ? a : b; } };
+template<typename T> struct reduce_op_min  { static T apply(T a, T b){ return (a < b || a != a) ? a : b; } };
+template<typename T> struct reduce_op_prod { static T apply(T a, T b){ return a * b; } };
+//bitwise operators are only defined for integer types
+template<typename T> struct reduce_op_band { static T apply(T a, T b){ return a & b; } };
+template<typename T> struct reduce_op_bor  { static T apply(T a, T b){ return a | b; } };
+template<typename T> struct reduce_op_bxor { static T apply(T a, T b){ return a ^ b; } };
+
+template<unsigned int data_width, unsigned int dest_width, typename T, template<typename> class OP>
+void stream_reduce(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in, STREAM<ap_axiu<data_width,0,0,dest_width> > & out);
+
 template<unsigned int data_width, unsigned int dest_width, typename T>
 void stream_add(STREAM<ap_axiu<2*data_width,0,0,dest_width> > & in, STREAM<ap_axiu<data_width,0,0,dest_width> > & out);
 
@@ -30,6 +46,28 @@ void reduce_sum_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM
 void reduce_sum_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
 void reduce_sum_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
 void reduce_sum_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_max_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_max_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_max_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_max_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_min_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_min_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_min_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_min_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_prod_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_prod_double(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_prod_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_prod_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_band_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_band_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_bor_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_bor_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_bxor_int32_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_bxor_int64_t(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_sum_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_max_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_min_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
+void reduce_prod_bfloat16(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
 #ifdef REDUCE_HALF_PRECISION
 void reduce_sum_half(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) ;
 #endif
@@ -21,35 +21,35 @@
 #include<iostream>
 #include <cstdlib>
 #include <stdint.h>
+#include "reduce_sum.h"
 
 using namespace hls;
 using namespace std;
 
-#ifndef DATA_WIDTH
-#define DATA_WIDTH 512
-#endif
-
 #ifndef DATA_TYPE
 #define DATA_TYPE float
 #endif
 
-#define specialization(dt, dw) reduce_sum_ ## dt ## _ ## dw
-#define top(dt, dw) specialization(dt, dw)
+#ifndef REDUCE_FUNC
+#define REDUCE_FUNC sum
+#endif
 
-void top(DATA_TYPE, DATA_WIDTH)(stream<ap_axiu<2*DATA_WIDTH,0,0,0> > & in,
-				stream<ap_axiu<DATA_WIDTH,0,0,0> > & out);
+#define specialization(fn, dt) reduce_ ## fn ## _ ## dt
+#define top(fn, dt) specialization(fn, dt)
+#define op_specialization(fn) reduce_op_ ## fn
+#define golden_op(fn) op_specialization(fn)
 
 int main(){
 
-    stream<ap_axiu<2*DATA_WIDTH,0,0,0> > in;
-    stream<ap_axiu<DATA_WIDTH,0,0,0> > out;
-    stream<ap_axiu<DATA_WIDTH,0,0,0> > golden;
+    STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > in;
+    STREAM<stream_word> out;
+    STREAM<stream_word> golden;
     
     ap_uint<DATA_WIDTH> inword1;
     ap_uint<DATA_WIDTH> inword2;
-    ap_axiu<2*DATA_WIDTH,0,0,0> inword;
-    ap_axiu<DATA_WIDTH,0,0,0> outword;
-    ap_axiu<DATA_WIDTH,0,0,0> goldenword;
+    ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> inword;
+    stream_word outword;
+    stream_word goldenword;
 
     srand(42);
 
@@ -61,12 +61,13 @@ int main(){
 
     for(int i=len; i>0; i-=(DATA_WIDTH/8)){
         for(int j=0; j<simd; j++){
-            h1 = (static_cast <DATA_TYPE> (rand()) / static_cast <DATA_TYPE> (RAND_MAX));
-            h2 = (static_cast <DATA_TYPE> (rand()) / static_cast <DATA_TYPE> (RAND_MAX)); 
-            DATA_TYPE sum = h1+h2;
+            //small signed operands, so products stay in range for integer types
+            h1 = static_cast <DATA_TYPE> (rand() % 2000 - 1000) / static_cast <DATA_TYPE> (100);
+            h2 = static_cast <DATA_TYPE> (rand() % 2000 - 1000) / static_cast <DATA_TYPE> (100);
+            DATA_TYPE result = golden_op(REDUCE_FUNC)<DATA_TYPE>::apply(h1, h2);
             inword1((j+1)*dwt-1,j*dwt) = *reinterpret_cast<ap_uint<DATA_WIDTH>*>(&h1);
             inword2((j+1)*dwt-1,j*dwt) = *reinterpret_cast<ap_uint<DATA_WIDTH>*>(&h2);
-            goldenword.data((j+1)*dwt-1,j*dwt) = *reinterpret_cast<ap_uint<DATA_WIDTH>*>(&sum);
+            goldenword.data((j+1)*dwt-1,j*dwt) = *reinterpret_cast<ap_uint<DATA_WIDTH>*>(&result);
         }
         inword.data(DATA_WIDTH-1, 0) = inword1;
         inword.data(2*DATA_WIDTH-1, DATA_WIDTH) = inword2;
@@ -74,16 +75,16 @@ int main(){
         inword.keep = (((long long)1<<i)-1);
         goldenword.last = inword.last;
         goldenword.keep = inword.keep;
-        in.write(inword);
-        golden.write(goldenword);
+        STREAM_WRITE(in, inword);
+        STREAM_WRITE(golden, goldenword);
     }
     
-    top(DATA_TYPE, DATA_WIDTH)(in, out);
+    top(REDUCE_FUNC, DATA_TYPE)(in, out);
     
     //parse data
     for(int i=len; i>0; i-=(DATA_WIDTH/8)){
-        outword = out.read();
-        goldenword = golden.read();
+        outword = STREAM_READ(out);
+        goldenword = STREAM_READ(golden);
         if(outword.data != goldenword.data){
             cout << hex << outword.data << ":" << goldenword.data << dec << endl;
             for(int j=0; j<simd; j++){
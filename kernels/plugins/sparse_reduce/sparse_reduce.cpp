@@ -0,0 +1,139 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_axi_sdata.h"
+#include "hls_stream.h"
+#include "ap_int.h"
+#include <stdint.h>
+#include "sparse_reduce.h"
+
+using namespace std;
+
+static float pair_value(ap_uint<SPARSE_PAIR_BITS> p){
+#pragma HLS INLINE
+    uint32_t u = p(63,32).to_uint();
+    return *reinterpret_cast<float*>(&u);
+}
+
+static ap_uint<SPARSE_PAIR_BITS> make_pair(unsigned int idx, float val){
+#pragma HLS INLINE
+    ap_uint<SPARSE_PAIR_BITS> p;
+    p(31,0) = idx;
+    p(63,32) = *reinterpret_cast<uint32_t*>(&val);
+    return p;
+}
+
+//pair i of a buffered operand; slots past the valid length read as empty
+static ap_uint<SPARSE_PAIR_BITS> get_pair(ap_uint<DATA_WIDTH> buf[SPARSE_MAX_WORDS], unsigned int i, unsigned int npairs){
+#pragma HLS INLINE
+    if(i >= npairs){
+        return make_pair(SPARSE_EMPTY_INDEX, 0.0f);
+    }
+    unsigned int lane = i % SPARSE_PAIRS_PER_WORD;
+    return buf[i / SPARSE_PAIRS_PER_WORD]((lane+1)*SPARSE_PAIR_BITS-1, lane*SPARSE_PAIR_BITS);
+}
+
+//the operands arrive in lock-step but are consumed at data-dependent rates by the merge,
+//so both are buffered for the duration of the packet before being merged. If the operands
+//exceed the buffers, the union exceeds their capacity or an operand is itself overflowed,
+//the last pair of the result is replaced by the overflow marker
+void reduce_sparse_sum_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out) {
+#pragma HLS INTERFACE axis register both port=in
+#pragma HLS INTERFACE axis register both port=out
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+    ap_uint<DATA_WIDTH> op0[SPARSE_MAX_WORDS];
+    ap_uint<DATA_WIDTH> op1[SPARSE_MAX_WORDS];
+#pragma HLS BIND_STORAGE variable=op0 type=ram_2p impl=uram
+#pragma HLS BIND_STORAGE variable=op1 type=ram_2p impl=uram
+
+    unsigned int nwords = 0;
+    unsigned int npairs = 0;
+    //valid (non-empty) pairs of each operand, the merge has to consume all of them
+    unsigned int nvalid0 = 0, nvalid1 = 0;
+    bool overflow = false;
+    ap_uint<DATA_WIDTH/8> last_keep = 0;
+    int done = 0;
+    while(done == 0) {
+#pragma HLS PIPELINE II=1
+        ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> op_block = STREAM_READ(in);
+        //a partially kept last word holds fewer pairs
+        last_keep = op_block.keep(DATA_WIDTH/8-1,0);
+        unsigned int kept_pairs = 0, valid0 = 0, valid1 = 0;
+        for(unsigned int j=0; j<SPARSE_PAIRS_PER_WORD; j++){
+#pragma HLS UNROLL
+            unsigned int ia = op_block.data(j*SPARSE_PAIR_BITS+31, j*SPARSE_PAIR_BITS).to_uint();
+            unsigned int ib = op_block.data(DATA_WIDTH+j*SPARSE_PAIR_BITS+31, DATA_WIDTH+j*SPARSE_PAIR_BITS).to_uint();
+            if(last_keep[j*SPARSE_PAIR_BITS/8]){
+                kept_pairs++;
+                if(ia != SPARSE_EMPTY_INDEX) valid0++;
+                if(ib != SPARSE_EMPTY_INDEX) valid1++;
+                overflow |= (ia == SPARSE_OVERFLOW_INDEX) || (ib == SPARSE_OVERFLOW_INDEX);
+            }
+        }
+        if(nwords < SPARSE_MAX_WORDS){
+            op0[nwords] = op_block.data(DATA_WIDTH-1,0);
+            op1[nwords] = op_block.data(2*DATA_WIDTH-1,DATA_WIDTH);
+            npairs += kept_pairs;
+            nvalid0 += valid0;
+            nvalid1 += valid1;
+        } else{
+            overflow = true;
+        }
+        nwords++;
+        done = (op_block.last == 1);
+    }
+
+    unsigned int i = 0, j = 0;
+    ap_uint<DATA_WIDTH> res = 0;
+    for(unsigned int k = 0; k < nwords*SPARSE_PAIRS_PER_WORD; k++){
+#pragma HLS PIPELINE II=1
+        ap_uint<SPARSE_PAIR_BITS> a = get_pair(op0, i, npairs);
+        ap_uint<SPARSE_PAIR_BITS> b = get_pair(op1, j, npairs);
+        unsigned int ia = a(31,0).to_uint();
+        unsigned int ib = b(31,0).to_uint();
+        ap_uint<SPARSE_PAIR_BITS> r;
+        if(ia < ib){
+            r = a;
+            i++;
+        } else if(ib < ia){
+            r = b;
+            j++;
+        } else if(ia == SPARSE_EMPTY_INDEX){
+            //both exhausted, pad
+            r = make_pair(SPARSE_EMPTY_INDEX, 0.0f);
+        } else{
+            r = make_pair(ia, pair_value(a) + pair_value(b));
+            i++;
+            j++;
+        }
+        //pairs left over once the capacity is filled do not fit the result
+        if(k == npairs-1 && (overflow || i < nvalid0 || j < nvalid1)){
+            r = make_pair(SPARSE_OVERFLOW_INDEX, 0.0f);
+        }
+        unsigned int lane = k % SPARSE_PAIRS_PER_WORD;
+        res((lane+1)*SPARSE_PAIR_BITS-1, lane*SPARSE_PAIR_BITS) = r;
+        if(lane == SPARSE_PAIRS_PER_WORD-1){
+            stream_word wword;
+            bool last = (k == nwords*SPARSE_PAIRS_PER_WORD-1);
+            wword.data = res;
+            wword.last = last;
+            wword.keep = last ? last_keep : (ap_uint<DATA_WIDTH/8>)(-1);
+            STREAM_WRITE(out, wword);
+        }
+    }
+}
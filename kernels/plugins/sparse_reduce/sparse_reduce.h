@@ -0,0 +1,40 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "streamdefines.h"
+#include "ap_int.h"
+
+//Sparse operands are packets of (index, value) pairs, a 32-bit unsigned index in the
+//low half and an fp32 value in the high half of each 64-bit pair, sorted by
+//ascending index without duplicates. Unused slots at the end hold SPARSE_EMPTY_INDEX
+//with a zero value. Both operands and the result have the same capacity: the result
+//is the sorted union of the operands with values of equal indices summed, padded
+//with empty slots. Callers size the capacity for the union of all contributions;
+//if pairs do not fit, the last slot of the result holds SPARSE_OVERFLOW_INDEX instead,
+//which carries through later merges and which the driver reports as an error.
+//A merge only spans one packet, so a sparse buffer must fit in a single segment
+//of at most SPARSE_MAX_PAIRS pairs, pairs past that are dropped and flagged as well.
+#define SPARSE_PAIR_BITS 64
+#define SPARSE_PAIRS_PER_WORD (DATA_WIDTH/SPARSE_PAIR_BITS)
+#ifndef SPARSE_MAX_PAIRS
+#define SPARSE_MAX_PAIRS 8192
+#endif
+#define SPARSE_MAX_WORDS (SPARSE_MAX_PAIRS/SPARSE_PAIRS_PER_WORD)
+#define SPARSE_EMPTY_INDEX 0xFFFFFFFF
+#define SPARSE_OVERFLOW_INDEX 0xFFFFFFFE
+
+void reduce_sparse_sum_float(STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > & in, STREAM<stream_word> & out);
@@ -0,0 +1,148 @@
+/*******************************************************************************
+#  Copyright (C) 2021 Xilinx, Inc
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+# *******************************************************************************/
+
+#include "ap_axi_sdata.h"
+#include "hls_stream.h"
+#include "ap_int.h"
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include <set>
+#include "sparse_reduce.h"
+
+using namespace std;
+
+typedef pair<unsigned int, float> sparse_pair;
+
+ap_uint<SPARSE_PAIR_BITS> to_bits(sparse_pair p){
+    ap_uint<SPARSE_PAIR_BITS> b;
+    b(31,0) = p.first;
+    b(63,32) = *reinterpret_cast<uint32_t*>(&p.second);
+    return b;
+}
+
+sparse_pair from_bits(ap_uint<SPARSE_PAIR_BITS> b){
+    uint32_t u = b(63,32).to_uint();
+    return sparse_pair(b(31,0).to_uint(), *reinterpret_cast<float*>(&u));
+}
+
+//random sorted, duplicate-free contribution of nnz pairs out of a dense range, padded to capacity
+vector<sparse_pair> random_sparse(unsigned int nnz, unsigned int range, unsigned int capacity){
+    set<unsigned int> idx;
+    while(idx.size() < nnz){
+        idx.insert(rand() % range);
+    }
+    vector<sparse_pair> v;
+    for(unsigned int i : idx){
+        v.push_back(sparse_pair(i, (float)(rand() % 1000) / 8));
+    }
+    while(v.size() < capacity){
+        v.push_back(sparse_pair(SPARSE_EMPTY_INDEX, 0.0f));
+    }
+    return v;
+}
+
+int test_merge(unsigned int nnz0, unsigned int nnz1, unsigned int range, unsigned int capacity, bool overflow=false){
+    STREAM<ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> > in;
+    STREAM<stream_word> out;
+
+    vector<sparse_pair> a = random_sparse(nnz0, range, capacity);
+    vector<sparse_pair> b = random_sparse(nnz1, range, capacity);
+    map<unsigned int, float> golden;
+    for(unsigned int i=0; i<capacity; i++){
+        if(a[i].first != SPARSE_EMPTY_INDEX) golden[a[i].first] += a[i].second;
+        if(b[i].first != SPARSE_EMPTY_INDEX) golden[b[i].first] += b[i].second;
+    }
+
+    unsigned int nwords = (capacity + SPARSE_PAIRS_PER_WORD - 1) / SPARSE_PAIRS_PER_WORD;
+    for(unsigned int w=0; w<nwords; w++){
+        ap_axiu<2*DATA_WIDTH,0,0,DEST_WIDTH> word;
+        word.data = 0;
+        word.keep = 0;
+        for(unsigned int j=0; j<SPARSE_PAIRS_PER_WORD; j++){
+            unsigned int k = w*SPARSE_PAIRS_PER_WORD + j;
+            if(k < capacity){
+                word.data((j+1)*SPARSE_PAIR_BITS-1, j*SPARSE_PAIR_BITS) = to_bits(a[k]);
+                word.data(DATA_WIDTH+(j+1)*SPARSE_PAIR_BITS-1, DATA_WIDTH+j*SPARSE_PAIR_BITS) = to_bits(b[k]);
+                word.keep((j+1)*SPARSE_PAIR_BITS/8-1, j*SPARSE_PAIR_BITS/8) = 0xff;
+                word.keep(DATA_WIDTH/8+(j+1)*SPARSE_PAIR_BITS/8-1, DATA_WIDTH/8+j*SPARSE_PAIR_BITS/8) = 0xff;
+            }
+        }
+        word.last = (w == nwords-1);
+        STREAM_WRITE(in, word);
+    }
+
+    reduce_sparse_sum_float(in, out);
+
+    vector<sparse_pair> res;
+    for(unsigned int w=0; w<nwords; w++){
+        stream_word word = STREAM_READ(out);
+        if(word.last != (w == nwords-1)){
+            cout << "Mismatch on tlast" << endl;
+            return 1;
+        }
+        for(unsigned int j=0; j<SPARSE_PAIRS_PER_WORD; j++){
+            if(word.keep[j*SPARSE_PAIR_BITS/8]){
+                res.push_back(from_bits(word.data((j+1)*SPARSE_PAIR_BITS-1, j*SPARSE_PAIR_BITS)));
+            }
+        }
+    }
+    if(res.size() != capacity){
+        cout << "Result has " << res.size() << " pairs, expected " << capacity << endl;
+        return 1;
+    }
+    //pairs which do not fit are flagged in the last slot the plugin buffers
+    unsigned int flag = min(capacity, (unsigned int)SPARSE_MAX_PAIRS) - 1;
+    if(overflow || res[flag].first == SPARSE_OVERFLOW_INDEX){
+        if(!overflow || res[flag].first != SPARSE_OVERFLOW_INDEX){
+            cout << (overflow ? "Overflow not flagged" : "Unexpected overflow flag") << endl;
+            return 1;
+        }
+        return 0;
+    }
+    //result must be the sorted union with summed values, followed by padding
+    unsigned int k = 0;
+    for(auto const & g : golden){
+        if(res[k].first != g.first || res[k].second != g.second){
+            cout << "Mismatch at pair " << k << ": (" << res[k].first << "," << res[k].second << ") expected (" << g.first << "," << g.second << ")" << endl;
+            return 1;
+        }
+        k++;
+    }
+    for(; k<capacity; k++){
+        if(res[k].first != SPARSE_EMPTY_INDEX){
+            cout << "Expected padding at pair " << k << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(){
+    int nerrors = 0;
+    //disjoint-ish, heavily overlapping, one side empty, and a partially kept last word
+    nerrors += test_merge(100, 100, 100000, 256);
+    nerrors += test_merge(200, 200, 256, 512);
+    nerrors += test_merge(0, 64, 1000, 64);
+    nerrors += test_merge(7, 9, 50, 21);
+    nerrors += test_merge(SPARSE_MAX_PAIRS/2, SPARSE_MAX_PAIRS/2, 1<<20, SPARSE_MAX_PAIRS);
+    //union beyond capacity, and operands beyond the plugin buffers
+    nerrors += test_merge(192, 192, 1<<20, 256, true);
+    nerrors += test_merge(64, 64, 1<<20, SPARSE_MAX_PAIRS + SPARSE_PAIRS_PER_WORD, true);
+    return nerrors;
+}
@@ -27,11 +27,15 @@
 #include "ap_int.h"
 #include <stdint.h>
 #include "reduce_sum.h"
+#include "lp_stream_conv.h"
+#include "q8_stream_conv.h"
+#include "sparse_reduce.h"
 #include "eth_intf.h"
 #include "dummy_tcp_stack.h"
 #include "stream_segmenter.h"
 #include "rxbuf_offload.h"
 #include "dma_mover.h"
+#include "collective_sequencer.h"
 #include "ccl_offload_control.h"
 #include <zmqpp/zmqpp.hpp>
 #include <string>
@@ -182,11 +186,96 @@ void arithmetic(Stream<stream_word > &op0, Stream<stream_word > &op1, Stream<str
         // case 4:
         //     stream_add<512, half>(op_int, res_int);
         //     break;
+        case 5:
+            reduce_max_float(op_int, res);
+            break;
+        case 6:
+            reduce_max_double(op_int, res);
+            break;
+        case 7:
+            reduce_max_int32_t(op_int, res);
+            break;
+        case 8:
+            reduce_max_int64_t(op_int, res);
+            break;
+        case 9:
+            reduce_min_float(op_int, res);
+            break;
+        case 10:
+            reduce_min_double(op_int, res);
+            break;
+        case 11:
+            reduce_min_int32_t(op_int, res);
+            break;
+        case 12:
+            reduce_min_int64_t(op_int, res);
+            break;
+        case 13:
+            reduce_prod_float(op_int, res);
+            break;
+        case 14:
+            reduce_prod_double(op_int, res);
+            break;
+        case 15:
+            reduce_prod_int32_t(op_int, res);
+            break;
+        case 16:
+            reduce_prod_int64_t(op_int, res);
+            break;
+        case 17:
+            reduce_band_int32_t(op_int, res);
+            break;
+        case 18:
+            reduce_band_int64_t(op_int, res);
+            break;
+        case 19:
+            reduce_bor_int32_t(op_int, res);
+            break;
+        case 20:
+            reduce_bor_int64_t(op_int, res);
+            break;
+        case 21:
+            reduce_bxor_int32_t(op_int, res);
+            break;
+        case 22:
+            reduce_bxor_int64_t(op_int, res);
+            break;
+        case 23:
+            reduce_sum_bfloat16(op_int, res);
+            break;
+        case 24:
+            reduce_max_bfloat16(op_int, res);
+            break;
+        case 25:
+            reduce_min_bfloat16(op_int, res);
+            break;
+        case 26:
+            reduce_prod_bfloat16(op_int, res);
+            break;
+        case 27:
+            reduce_sum_q8(op_int, res);
+            break;
+        case 28:
+            reduce_sparse_sum_float(op_int, res);
+            break;
     }
     //load result stream
     cout << "Arith packet processed" << endl;
 }
 
+//buffer one packet from a compression lane input, starting with an already popped word,
+//and run it through a low-precision or block-quantization conversion plugin
+void lp_conversion(void (*conv)(Stream<stream_word> &, Stream<stream_word> &), stream_word first, Stream<stream_word> &op0, Stream<stream_word> &res){
+    Stream<stream_word> op_int("clane_op");
+    stream_word tmp = first;
+    op_int.Push(tmp);
+    while(tmp.last == 0){
+        tmp = op0.Pop();
+        op_int.Push(tmp);
+    }
+    conv(op_int, res);
+}
+
 void compression(Stream<stream_word> &op0, Stream<stream_word> &res){ 
     stream_word tmp_op0;
     stream_word tmp_res;
@@ -219,6 +308,33 @@ void compression(Stream<stream_word> &op0, Stream<stream_word> &res){
             }
             res.Push(tmp_res);
             break;
+        case 3:
+            lp_conversion(fp_bf16_stream_conv, tmp_op0, op0, res);
+            break;
+        case 4:
+            lp_conversion(bf16_fp_stream_conv, tmp_op0, op0, res);
+            break;
+        case 5:
+            lp_conversion(fp_fp8e4m3_stream_conv, tmp_op0, op0, res);
+            break;
+        case 6:
+            lp_conversion(fp8e4m3_fp_stream_conv, tmp_op0, op0, res);
+            break;
+        case 7:
+            lp_conversion(fp_fp8e5m2_stream_conv, tmp_op0, op0, res);
+            break;
+        case 8:
+            lp_conversion(fp8e5m2_fp_stream_conv, tmp_op0, op0, res);
+            break;
+        case 9:
+            lp_conversion(fp_bf16_sr_stream_conv, tmp_op0, op0, res);
+            break;
+        case 10:
+            lp_conversion(fp_q8_stream_conv, tmp_op0, op0, res);
+            break;
+        case 11:
+            lp_conversion(q8_fp_stream_conv, tmp_op0, op0, res);
+            break;
     }
 }
 
@@ -311,6 +427,8 @@ void sim_bd(zmq_intf_context *ctx, bool use_tcp, unsigned int local_rank, unsign
     Stream<stream_word > accl_to_krnl_seg;
 
     Stream<eth_header > eth_tx_cmd;
+    Stream<eth_header > eth_tx_cmd_fanout;
+    Stream<stream_word > eth_tx_data_fanout;
     Stream<ap_uint<32> > eth_tx_sts;
     Stream<eth_header > eth_rx_sts;
     Stream<eth_header > eth_rx_sts_sess;
@@ -321,6 +439,9 @@ void sim_bd(zmq_intf_context *ctx, bool use_tcp, unsigned int local_rank, unsign
     Stream<ap_uint<104>, 32> enq2sess_dma_cmd;
     Stream<ap_uint<32>, 32> sess2deq_dma_sts;
 
+    Stream<ap_axiu<32,0,0,0>, 32> sequencer_cmd;
+    Stream<ap_axiu<32,0,0,0>, 32> sequencer_sts;
+
     Stream<rxbuf_notification> eth_rx_notif;
     Stream<rxbuf_signature> eth_rx_seek_req;
     Stream<rxbuf_seek_result> eth_rx_seek_ack;
@@ -371,12 +492,18 @@ void sim_bd(zmq_intf_context *ctx, bool use_tcp, unsigned int local_rank, unsign
             inflight_rxbuf, inflight_rxbuf_sess,
             dma_write_cmd_int[0], dma_write_sts_int[0],
             eth_notif_out_dpkt,
-            eth_rx_sts, eth_rx_sts_sess
+            eth_rx_sts, eth_rx_sts_sess,
+            cfgmem
         );
     }
+    //collective sequencer, in front of the move offload
+    HLSLIB_FREERUNNING_FUNCTION(
+        collective_sequencer, cfgmem, cmd_fifos[CMD_DMA_MOVE], sts_fifos[STS_DMA_MOVE],
+        sequencer_cmd, sequencer_sts
+    );
     //move offload
     HLSLIB_FREERUNNING_FUNCTION(
-        dma_mover, cfgmem, cmd_fifos[CMD_DMA_MOVE], sts_fifos[STS_DMA_MOVE],
+        dma_mover, cfgmem, sequencer_cmd, sequencer_sts,
         eth_rx_seek_req, eth_rx_seek_ack, rxbuf_release_req,
         dma_read_cmd_int[0], dma_read_cmd_int[1], dma_write_cmd_int[1], 
         dma_read_sts_int[0], dma_read_sts_int[1], dma_write_sts_int[1], 
@@ -407,9 +534,10 @@ void sim_bd(zmq_intf_context *ctx, bool use_tcp, unsigned int local_rank, unsign
     HLSLIB_FREERUNNING_FUNCTION(compression, clane0_op, clane0_res);
     HLSLIB_FREERUNNING_FUNCTION(compression, clane1_op, clane1_res);
     HLSLIB_FREERUNNING_FUNCTION(compression, clane2_op, clane2_res);
-    //network PACK/DEPACK
+    //network PACK/DEPACK, behind the multicast fan-out
+    HLSLIB_FREERUNNING_FUNCTION(eth_fanout, switch_m[SWITCH_M_ETH_TX], eth_tx_data_fanout, eth_tx_cmd, eth_tx_cmd_fanout);
     if(use_tcp){
-        HLSLIB_FREERUNNING_FUNCTION(tcp_packetizer, switch_m[SWITCH_M_ETH_TX], eth_tx_data_int, eth_tx_cmd, cmd_txHandler, eth_tx_sts, max_words_per_pkt);
+        HLSLIB_FREERUNNING_FUNCTION(tcp_packetizer, eth_tx_data_fanout, eth_tx_data_int, eth_tx_cmd_fanout, cmd_txHandler, eth_tx_sts, max_words_per_pkt);
         HLSLIB_FREERUNNING_FUNCTION(tcp_depacketizer, eth_rx_data_int, switch_s[SWITCH_S_ETH_RX], eth_rx_sts, eth_notif_out, eth_notif_out_dpkt);
         HLSLIB_FREERUNNING_FUNCTION(tcp_rxHandler, eth_notif,  eth_read_pkg, eth_rx_meta,  eth_rx_data_stack, eth_rx_data_int, eth_notif_out);
         HLSLIB_FREERUNNING_FUNCTION(tcp_txHandler, eth_tx_data_int, cmd_txHandler, eth_tx_meta,  eth_tx_data_stack,  eth_tx_status);
@@ -431,8 +559,10 @@ void sim_bd(zmq_intf_context *ctx, bool use_tcp, unsigned int local_rank, unsign
             eth_rx_data, eth_tx_data
         );
     } else{
-        HLSLIB_FREERUNNING_FUNCTION(udp_packetizer, switch_m[SWITCH_M_ETH_TX], eth_tx_data, eth_tx_cmd, eth_tx_sts, max_words_per_pkt);
-        HLSLIB_FREERUNNING_FUNCTION(udp_depacketizer, eth_rx_data, switch_s[SWITCH_S_ETH_RX], eth_rx_sts);
+        HLSLIB_FREERUNNING_FUNCTION(udp_packetizer, eth_tx_data_fanout, eth_tx_data_int, eth_tx_cmd_fanout, eth_tx_sts, max_words_per_pkt);
+        HLSLIB_FREERUNNING_FUNCTION(udp_depacketizer, eth_rx_data_int, switch_s[SWITCH_S_ETH_RX], eth_rx_sts);
+        //retransmission of datagrams lost on the (lossy) emulated network
+        HLSLIB_FREERUNNING_FUNCTION(udp_reliability, eth_tx_data_int, eth_tx_data, eth_rx_data, eth_rx_data_int);
     }
     //emulated external kernel
     HLSLIB_FREERUNNING_FUNCTION(dummy_external_kernel, accl_to_krnl_data, krnl_to_accl_data);
@@ -461,6 +591,9 @@ int main(int argc, char** argv){
     string eth_type = argv[1];
     unsigned int starting_port = atoi(argv[2]);
 
-    zmq_intf_context ctx = zmq_intf(starting_port, local_rank, world_size);
+    //optional network model options follow, e.g. latency_us=5 drop_rate=0.01
+    network_model model = parse_network_model(argc, argv, 3);
+
+    zmq_intf_context ctx = zmq_intf(starting_port, local_rank, world_size, model);
     sim_bd(&ctx, eth_type == "tcp", local_rank, world_size);
 }
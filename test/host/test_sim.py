@@ -19,9 +19,12 @@ import sys
 import numpy as np
 import time
 sys.path.append('../../driver/pynq/')
-from accl import accl, ACCLReduceFunctions, ACCLStreamFlags
-from accl import SimBuffer
+from accl import accl, ACCLReduceFunctions, ACCLStreamFlags, ACCLMessage
+from accl import ACCL_EXTENDED_ARITH_CONFIG, ACCL_SR_ARITH_CONFIG, ACCL_Q8_INT_ARITH_CONFIG
+from accl import SimBuffer, CCLOp, CCLOCfgFunc, ring_order_from_topology
+from accl import ACCL_SPARSE_PAIR_DTYPE, ACCL_SPARSE_EMPTY_INDEX, sparse_pack, sparse_densify
 import argparse
+import os
 import itertools
 import math
 from mpi4py import MPI
@@ -89,6 +92,191 @@ def test_sendrecv(cclo_inst, world_size, local_rank, count):
     if err_count == 0:
         print("Send/recv succeeded")
 
+def test_probe(cclo_inst, world_size, local_rank, count):
+    # send a message whose size the receiver does not know, probe it, then receive it into a buffer sized from the probe
+    next_rank = (local_rank+1)%world_size
+    prev_rank = (local_rank+world_size-1)%world_size
+    op_buf, _, _ = get_buffers(count+local_rank, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.send(0, op_buf, count+local_rank, next_rank, tag=5)
+    msg = cclo_inst.probe(0)
+    expected = ACCLMessage(prev_rank, 5, 4*(count+prev_rank))
+    # a different tag does not match while the probed message is pending
+    if msg != expected or cclo_inst.iprobe(0, src=prev_rank, tag=6) is not None:
+        print("Probe failed, got ", msg, " expected ", expected)
+        return
+    _, _, res_buf = get_buffers(msg.nbytes//4, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.mrecv(0, res_buf, msg)
+    sent = MPI.COMM_WORLD.sendrecv(op_buf.buf, dest=next_rank, source=prev_rank)
+    if not np.isclose(sent, res_buf.buf).all() or cclo_inst.iprobe(0) is not None:
+        print("Matched receive failed")
+    else:
+        print("Probe succeeded")
+
+def test_sendrecv_rendezvous(cclo_inst, world_size, local_rank, count):
+    # messages above the threshold are written directly into the receive buffer (TCP only, eager otherwise);
+    # the rendezvous send blocks until the receive is posted, so alternate the order between neighbours
+    next_rank = (local_rank+1)%world_size
+    prev_rank = (local_rank+world_size-1)%world_size
+    cclo_inst.set_rendezvous_threshold(4*count)
+    err_count = 0
+    for n in [4*count, count//2]:
+        op_buf, _, res_buf = get_buffers(n, np.float32, np.float32, np.float32, cclo_inst)
+        if local_rank % 2 == 0:
+            cclo_inst.send(0, op_buf, n, next_rank, tag=3)
+            cclo_inst.recv(0, res_buf, n, prev_rank, tag=3)
+        else:
+            cclo_inst.recv(0, res_buf, n, prev_rank, tag=3)
+            cclo_inst.send(0, op_buf, n, next_rank, tag=3)
+        sent = MPI.COMM_WORLD.sendrecv(op_buf.buf, dest=next_rank, source=prev_rank)
+        if not np.isclose(sent, res_buf.buf).all():
+            err_count += 1
+            print("Rendezvous send/recv failed for ", n, " elements")
+    cclo_inst.set_rendezvous_threshold()
+    if err_count == 0:
+        print("Rendezvous send/recv succeeded")
+
+def test_rma(cclo_inst, world_size, local_rank, count):
+    # each rank puts into the upper half of the window of the next rank, fences,
+    # then gets it back; puts are written directly into the window (TCP only)
+    next_rank = (local_rank+1)%world_size
+    prev_rank = (local_rank+world_size-1)%world_size
+    op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+    _, _, win_buf = get_buffers(2*count, np.float32, np.float32, np.float32, cclo_inst)
+    key = cclo_inst.create_window(0, win_buf, len(cclo_inst.windows))
+    cclo_inst.put(key, op_buf, count, next_rank, displ=count)
+    cclo_inst.flush(key)
+    MPI.COMM_WORLD.barrier()
+    win_buf.sync_from_device()
+    sent = MPI.COMM_WORLD.sendrecv(op_buf.buf, dest=next_rank, source=prev_rank)
+    if not np.isclose(sent, win_buf.buf[count:]).all() or not (win_buf.buf[:count] == 0).all():
+        print("RMA put failed")
+        return
+    cclo_inst.get(key, res_buf, count, next_rank, displ=count)
+    if not np.isclose(op_buf.buf, res_buf.buf).all():
+        print("RMA get failed")
+        return
+    # accesses beyond the end of the target window are rejected
+    try:
+        cclo_inst.put(key, op_buf, count, next_rank, displ=count+1)
+        print("RMA put failed to detect out of window access")
+        return
+    except Exception:
+        pass
+    MPI.COMM_WORLD.barrier()
+    print("RMA put/get succeeded")
+
+def test_split(cclo_inst, world_size, local_rank, count):
+    # allreduce within even and odd ranks, in reverse rank order, then a broadcast
+    # on a duplicate of the world and on a group; all communicators share the world's sessions
+    color = local_rank % 2
+    sub_comm = cclo_inst.split(0, color, world_size - local_rank)
+    dup_comm = cclo_inst.dup(0)
+    op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.allreduce(sub_comm, op_buf, res_buf, count, ACCLReduceFunctions.SUM)
+    mpi_sub = MPI.COMM_WORLD.Split(color, world_size - local_rank)
+    expected = mpi_sub.allreduce(op_buf.buf[0:count], op=MPI.SUM)
+    if cclo_inst.communicators[sub_comm]["local_rank"] != mpi_sub.Get_rank() or not np.isclose(expected, res_buf.buf[0:count]).all():
+        print("Split communicator allreduce failed")
+        return
+    cclo_inst.bcast(dup_comm, op_buf, count, 0)
+    expected = MPI.COMM_WORLD.bcast(op_buf.buf[0:count] if local_rank == 0 else None, root=0)
+    if not np.isclose(expected, op_buf.buf[0:count]).all():
+        print("Duplicate communicator broadcast failed")
+        return
+    # the upper half of the ranks in reverse order, rooted at the last rank
+    group = list(range(world_size-1, world_size//2 - 1, -1))
+    grp_comm = cclo_inst.create(0, group)
+    expected = MPI.COMM_WORLD.bcast(op_buf.buf[0:count] if local_rank == group[0] else None, root=group[0])
+    if grp_comm is not None:
+        cclo_inst.bcast(grp_comm, op_buf if local_rank == group[0] else res_buf, count, 0)
+        if cclo_inst.communicators[grp_comm]["local_rank"] != group.index(local_rank) or (local_rank != group[0] and not np.isclose(expected, res_buf.buf[0:count]).all()):
+            print("Created communicator broadcast failed")
+            return
+    print("Communicator split/dup/create succeeded")
+
+def test_hierarchical(cclo_inst, world_size, local_rank, count):
+    # pairs of consecutive ranks form a node, results must match the flat collectives
+    if "topology" not in cclo_inst.communicators[0]:
+        cclo_inst.set_topology(0, [r//2 for r in range(world_size)])
+    op_buf, _, res_buf = get_buffers(count*world_size, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.hierarchical_allreduce(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM)
+    expected = MPI.COMM_WORLD.allreduce(op_buf.buf[0:count], op=MPI.SUM)
+    if not np.isclose(expected, res_buf.buf[0:count]).all():
+        print("Hierarchical allreduce failed")
+        return
+    root = world_size - 1
+    cclo_inst.hierarchical_bcast(0, op_buf, count, root)
+    expected = MPI.COMM_WORLD.bcast(op_buf.buf[0:count] if local_rank == root else None, root=root)
+    if not np.isclose(expected, op_buf.buf[0:count]).all():
+        print("Hierarchical broadcast failed")
+        return
+    op_buf[:] = [1.0*(local_rank+i) for i in range(op_buf.size)]
+    cclo_inst.hierarchical_allgather(0, op_buf, res_buf, count)
+    for i in range(world_size):
+        if not np.isclose(res_buf.buf[i*count:(i+1)*count], [1.0*(i+j) for j in range(count)]).all():
+            print("Hierarchical allgather failed for src rank", i)
+            return
+    print("Hierarchical collectives succeeded")
+
+def test_ring_order(cclo_inst, world_size, local_rank, count):
+    # alternate ranks between two racks, the ring then visits even ranks before odd ones
+    topo_file = f"ring_topology_{local_rank}.txt"
+    with open(topo_file, "w") as f:
+        f.write("# rank rack\n")
+        f.writelines(f"{r} rack{r%2}\n" for r in range(world_size))
+    order = ring_order_from_topology(topo_file, world_size)
+    os.remove(topo_file)
+    if order != list(range(0, world_size, 2)) + list(range(1, world_size, 2)):
+        print("Ring order from topology failed, got ", order)
+        return
+    cclo_inst.set_ring_order(0, order)
+    try:
+        op_buf, _, res_buf = get_buffers(count*world_size, np.float32, np.float32, np.float32, cclo_inst)
+        cclo_inst.allreduce(0, op_buf, res_buf, count*world_size, ACCLReduceFunctions.SUM)
+        expected = MPI.COMM_WORLD.allreduce(op_buf.buf, op=MPI.SUM)
+        if not np.isclose(expected, res_buf.buf).all():
+            print("Ring order allreduce failed")
+            return
+        # reduce-scatter leaves each rank with the chunk of its next in ring
+        cclo_inst.reduce_scatter(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM)
+        chunk = order[(order.index(local_rank)+1) % world_size]
+        if not np.isclose(expected[chunk*count:(chunk+1)*count], res_buf.buf[0:count]).all():
+            print("Ring order reduce-scatter failed")
+            return
+        cclo_inst.allgather(0, op_buf, res_buf, count)
+        expected = np.concatenate(MPI.COMM_WORLD.allgather(op_buf.buf[0:count]))
+        if not np.isclose(expected, res_buf.buf).all():
+            print("Ring order allgather failed")
+            return
+        cclo_inst.gather(0, op_buf, res_buf, count, 0)
+        if local_rank == 0 and not np.isclose(expected, res_buf.buf).all():
+            print("Ring order gather failed")
+            return
+    finally:
+        cclo_inst.set_ring_order(0, list(range(world_size)))
+    print("Ring order collectives succeeded")
+
+def test_recv_up_to(cclo_inst, world_size, local_rank, count):
+    # receive a message of unknown size into a buffer large enough for any of the senders
+    next_rank = (local_rank+1)%world_size
+    prev_rank = (local_rank+world_size-1)%world_size
+    op_buf, _, res_buf = get_buffers(count+world_size, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.send(0, op_buf, count+local_rank, next_rank, tag=7)
+    # a too small max_count leaves the message pending
+    try:
+        cclo_inst.recv_up_to(0, res_buf, max_count=count+prev_rank-1)
+        print("Receive up to failed to detect truncation")
+        return
+    except Exception:
+        pass
+    msg = cclo_inst.recv_up_to(0, res_buf)
+    expected = ACCLMessage(prev_rank, 7, 4*(count+prev_rank))
+    sent = MPI.COMM_WORLD.sendrecv(op_buf.buf[:count+local_rank], dest=next_rank, source=prev_rank)
+    if msg != expected or not np.isclose(sent, res_buf.buf[:count+prev_rank]).all():
+        print("Receive up to failed, got ", msg, " expected ", expected)
+    else:
+        print("Receive up to succeeded")
+
 def test_sendrecv_plkernel(cclo_inst, world_size, local_rank, count):
     #NOTE: this requires loopback on the external stream interface
     err_count = 0
@@ -249,6 +437,264 @@ def test_allreduce(cclo_inst, world_size, local_rank, root, count, func):
     if err_count == 0:
         print("Allreduce succeeded")
 
+def test_reduce_funcs(cclo_inst, world_size, local_rank, count):
+    # ring reduce-scatter and all-reduce with reduction functions other than SUM, checked against numpy
+    op_buf, _, res_buf = get_buffers(world_size*count, np.float32, np.float32, np.float32, cclo_inst)
+    op_buf[:] = np.random.uniform(-100, 100, op_buf.size).astype(np.float32)
+    operands = np.stack(MPI.COMM_WORLD.allgather(op_buf.buf))
+    err_count = 0
+    for func, reduce in [(ACCLReduceFunctions.MAX, np.max), (ACCLReduceFunctions.MIN, np.min)]:
+        reduced = reduce(operands, axis=0)
+        cclo_inst.reduce_scatter(0, op_buf, res_buf, count, func)
+        offset = (local_rank + world_size + 1) % world_size
+        if not np.isclose(res_buf.buf[0:count], reduced[offset*count:(offset+1)*count]).all():
+            err_count += 1
+            print("Reduce-scatter failed with", func.name)
+        cclo_inst.allreduce(0, op_buf, res_buf, world_size*count, func)
+        if not np.isclose(res_buf.buf, reduced).all():
+            err_count += 1
+            print("Allreduce failed with", func.name)
+    if err_count == 0:
+        print("Reduce function test succeeded")
+
+def test_allreduce_dual_ring(cclo_inst, world_size, local_rank, count, nruns):
+    # check against MPI, then compare the time of single and dual ring allreduce
+    op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+    cclo_inst.allreduce(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM, dual_ring=True)
+    expected = MPI.COMM_WORLD.allreduce(op_buf.buf, op=MPI.SUM)
+    if not np.isclose(expected, res_buf.buf).all():
+        print("Dual ring allreduce failed")
+        return
+    for dual_ring in [False, True]:
+        MPI.COMM_WORLD.barrier()
+        start = time.perf_counter()
+        for _ in range(nruns):
+            cclo_inst.allreduce(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM, dual_ring=dual_ring)
+        duration_us = (time.perf_counter() - start)*1e6/nruns
+        print(f"Allreduce {'dual' if dual_ring else 'single'} ring of {count} elements: {duration_us:.2f} us")
+    print("Dual ring allreduce succeeded")
+
+def test_allreduce_pipeline_sweep(cclo_inst, world_size, local_rank, nruns):
+    # allreduce time with and without pipelining, from one to 16 blocks of one segment per rank
+    block = world_size*(cclo_inst.segment_size//4)
+    for nblocks in [1, 2, 4, 8, 16]:
+        count = nblocks*block
+        op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+        expected = MPI.COMM_WORLD.allreduce(op_buf.buf, op=MPI.SUM)
+        times = []
+        for threshold in [0xFFFF_FFFF, 0]:
+            cclo_inst.set_pipeline_threshold(threshold)
+            MPI.COMM_WORLD.barrier()
+            start = time.perf_counter()
+            for _ in range(nruns):
+                cclo_inst.allreduce(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM)
+            times.append((time.perf_counter() - start)*1e6/nruns)
+            if not np.isclose(expected, res_buf.buf).all():
+                print("Allreduce failed for ", count, " elements with pipeline threshold ", threshold)
+                cclo_inst.set_pipeline_threshold()
+                return
+        print(f"Allreduce of {count} elements: {times[0]:.2f} us sequential, {times[1]:.2f} us pipelined")
+    cclo_inst.set_pipeline_threshold()
+
+def test_sequencer(cclo_inst, world_size, local_rank, count, nruns):
+    # ring collectives expanded by the collective sequencer and by the firmware, checked against MPI
+    op_buf, _, res_buf = get_buffers(world_size*count, np.float32, np.float32, np.float32, cclo_inst)
+    op_buf[:] = [1.0*(local_rank+i) for i in range(op_buf.size)]
+    gathered = MPI.COMM_WORLD.allgather(op_buf.buf[0:count])
+    reduced = MPI.COMM_WORLD.allreduce(op_buf.buf, op=MPI.SUM)
+    reduced_max = MPI.COMM_WORLD.allreduce(op_buf.buf, op=MPI.MAX)
+    err_count = 0
+    for enable in [True, False]:
+        cclo_inst.set_sequencer(enable)
+        mode = "sequencer" if enable else "firmware"
+        cclo_inst.allgather(0, op_buf, res_buf, count)
+        if not np.isclose(res_buf.buf, np.concatenate(gathered)).all():
+            err_count += 1
+            print("Allgather failed with", mode)
+        cclo_inst.reduce_scatter(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM)
+        offset = (local_rank + world_size + 1) % world_size
+        if not np.isclose(res_buf.buf[0:count], reduced[offset*count:(offset+1)*count]).all():
+            err_count += 1
+            print("Reduce-scatter failed with", mode)
+        cclo_inst.allreduce(0, op_buf, res_buf, world_size*count, ACCLReduceFunctions.SUM)
+        if not np.isclose(res_buf.buf, reduced).all():
+            err_count += 1
+            print("Allreduce failed with", mode)
+        cclo_inst.reduce_scatter(0, op_buf, res_buf, count, ACCLReduceFunctions.MAX)
+        if not np.isclose(res_buf.buf[0:count], reduced_max[offset*count:(offset+1)*count]).all():
+            err_count += 1
+            print("Reduce-scatter with MAX failed with", mode)
+        cclo_inst.allreduce(0, op_buf, res_buf, world_size*count, ACCLReduceFunctions.MAX)
+        if not np.isclose(res_buf.buf, reduced_max).all():
+            err_count += 1
+            print("Allreduce with MAX failed with", mode)
+        MPI.COMM_WORLD.barrier()
+        start = time.perf_counter()
+        for _ in range(nruns):
+            cclo_inst.allreduce(0, op_buf, res_buf, world_size*count, ACCLReduceFunctions.SUM)
+        duration_us = (time.perf_counter() - start)*1e6/nruns
+        print(f"Allreduce of {world_size*count} elements with {mode}: {duration_us:.2f} us")
+    cclo_inst.set_sequencer()
+    if err_count == 0:
+        print("Sequencer test succeeded")
+
+def test_multicast(cclo_inst, world_size, local_rank, count, nruns):
+    # broadcast from each root with and without multicast, checked against MPI
+    op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+    err_count = 0
+    for enable in [True, False]:
+        cclo_inst.set_multicast(enable)
+        mode = "multicast" if enable else "unicast"
+        for root in range(world_size):
+            op_buf.buf[:] = [1.0*(root+i) for i in range(op_buf.size)]
+            res_buf.buf[:] = 0
+            cclo_inst.bcast(0, op_buf if root == local_rank else res_buf, count, root=root)
+            if local_rank != root and not np.isclose(op_buf.buf, res_buf.buf).all():
+                err_count += 1
+                print("Bcast from", root, "failed with", mode)
+        MPI.COMM_WORLD.barrier()
+        start = time.perf_counter()
+        for _ in range(nruns):
+            cclo_inst.bcast(0, op_buf if local_rank == 0 else res_buf, count, root=0)
+        duration_us = (time.perf_counter() - start)*1e6/nruns
+        print(f"Bcast of {count} elements with {mode}: {duration_us:.2f} us")
+    cclo_inst.set_multicast()
+    if err_count == 0:
+        print("Multicast test succeeded")
+
+def test_allreduce_compressed(cclo_inst, world_size, local_rank, count, nruns):
+    # accuracy and throughput of a fp32 allreduce over an uncompressed, a bf16 and an int8 wire
+    try:
+        import ml_dtypes
+    except ImportError:
+        print("Compressed allreduce benchmark requires ml_dtypes, skipping")
+        return
+    op_buf, _, res_buf = get_buffers(count, np.float32, np.float32, np.float32, cclo_inst)
+    # one large contribution plus many small ones, where requantizing partial sums drifts
+    op_buf[:] = (1.0 if local_rank == 0 else 1e-3)*np.random.rand(count).astype(np.float32)
+    exact = MPI.COMM_WORLD.allreduce(op_buf.buf[0:count].astype(np.float64), op=MPI.SUM)
+    wires = [("fp32 wire", None), ("bf16 wire", np.dtype(ml_dtypes.bfloat16))]
+    if count % 64 == 0:
+        # block-scaled int8 packs whole 64-element blocks
+        wires.append(("int8 wire", np.dtype(np.int8)))
+    for label, compress_dtype in wires:
+        MPI.COMM_WORLD.barrier()
+        start = time.perf_counter()
+        for _ in range(nruns):
+            cclo_inst.allreduce(0, op_buf, res_buf, count, ACCLReduceFunctions.SUM, compress_dtype=compress_dtype)
+        duration_us = (time.perf_counter() - start)*1e6/nruns
+        err = res_buf.buf[0:count].astype(np.float64) - exact
+        print(f"Allreduce {label}: {duration_us:.2f} us, bias {err.mean():.3e}, rms {np.sqrt((err**2).mean()):.3e}")
+
+def test_open_con_bench(cclo_inst, nruns):
+    # session establishment time against communicator size, on synthetic communicators
+    # written to scratch exchange memory; the dummy TCP stack accepts every connection
+    scratch = cclo_inst.vtable_addr
+    max_ranks = (cclo_inst.exchmem_top - scratch)//28 - 1
+    nranks = 2
+    while nranks <= max_ranks:
+        ranks = [{"ip": f"10.0.{i//256}.{i%256}", "port": 5500+i, "max_segment_size": cclo_inst.segment_size} for i in range(nranks)]
+        start = time.perf_counter()
+        for _ in range(nruns):
+            cclo_inst.write_communicator(scratch, ranks, 0)
+            cclo_inst.call_sync(scenario=CCLOp.config, comm=scratch, function=CCLOCfgFunc.open_con)
+        duration_us = (time.perf_counter() - start)*1e6/nruns
+        if cclo_inst.get_retcode() != 0:
+            print("Open connection failed for ", nranks, " ranks")
+            return
+        print(f"Open connection to {nranks} ranks: {duration_us:.2f} us")
+        nranks *= 2
+
+def get_vcounts(world_size, count):
+    # non-uniform per-rank counts, packed displacements
+    counts = [count + i for i in range(world_size)]
+    displs = [sum(counts[:i]) for i in range(world_size)]
+    return counts, displs
+
+def test_scatterv(cclo_inst, world_size, local_rank, root, count):
+    err_count = 0
+    dt = [np.float32]
+    counts, displs = get_vcounts(world_size, count)
+    for op_dt, res_dt in itertools.product(dt, repeat=2):
+        op_buf, _, res_buf = get_buffers(sum(counts), op_dt, op_dt, res_dt, cclo_inst)
+        op_buf[:] = [1.0*i for i in range(op_buf.size)]
+        cclo_inst.scatterv(0, op_buf, res_buf, counts, root=root)
+
+        lo, hi = displs[local_rank], displs[local_rank]+counts[local_rank]
+        if not np.isclose(op_buf.buf[lo:hi], res_buf.buf[0:counts[local_rank]]).all():
+            err_count += 1
+            print("Scatterv failed on pair ", op_dt, res_dt)
+    if err_count == 0:
+        print("Scatterv succeeded")
+
+def test_gatherv(cclo_inst, world_size, local_rank, root, count):
+    err_count = 0
+    dt = [np.float32]
+    counts, displs = get_vcounts(world_size, count)
+    for op_dt, res_dt in itertools.product(dt, repeat=2):
+        op_buf, _, res_buf = get_buffers(sum(counts), op_dt, op_dt, res_dt, cclo_inst)
+        op_buf[:] = [1.0*(local_rank+i) for i in range(op_buf.size)]
+        cclo_inst.gatherv(0, op_buf, res_buf, counts, root=root)
+
+        if local_rank == root:
+            for i in range(world_size):
+                if not np.isclose(res_buf.buf[displs[i]:displs[i]+counts[i]], [1.0*(i+j) for j in range(counts[i])]).all():
+                    err_count += 1
+                    print("Gatherv failed for src rank", i, "on pair ", op_dt, res_dt)
+    if err_count == 0:
+        print("Gatherv succeeded")
+
+def test_allgatherv(cclo_inst, world_size, local_rank, count):
+    err_count = 0
+    dt = [np.float32]
+    counts, displs = get_vcounts(world_size, count)
+    for op_dt, res_dt in itertools.product(dt, repeat=2):
+        op_buf, _, res_buf = get_buffers(sum(counts), op_dt, op_dt, res_dt, cclo_inst)
+        op_buf[:] = [1.0*(local_rank+i) for i in range(op_buf.size)]
+        cclo_inst.allgatherv(0, op_buf, res_buf, counts)
+
+        for i in range(world_size):
+            if not np.isclose(res_buf.buf[displs[i]:displs[i]+counts[i]], [1.0*(i+j) for j in range(counts[i])]).all():
+                err_count += 1
+                print("Allgatherv failed for src rank", i, "on pair ", op_dt, res_dt)
+    if err_count == 0:
+        print("Allgatherv succeeded")
+
+def test_reduce_scatterv(cclo_inst, world_size, local_rank, count, func):
+    err_count = 0
+    dt = [np.float32]
+    counts, displs = get_vcounts(world_size, count)
+    for op_dt, res_dt in itertools.product(dt, repeat=2):
+        op_buf, _, res_buf = get_buffers(sum(counts), op_dt, op_dt, res_dt, cclo_inst)
+        op_buf[:] = [1.0*i for i in range(op_buf.size)]
+        cclo_inst.reduce_scatterv(0, op_buf, res_buf, counts, func)
+
+        full_reduce_result = world_size*op_buf.buf
+        lo, hi = displs[local_rank], displs[local_rank]+counts[local_rank]
+        if not np.isclose(res_buf.buf[0:counts[local_rank]], full_reduce_result[lo:hi]).all():
+            err_count += 1
+            print("Reduce-scatterv failed on pair ", op_dt, res_dt)
+    if err_count == 0:
+        print("Reduce-scatterv succeeded")
+
+def test_sparse_allreduce(cclo_inst, world_size, local_rank, count):
+    # count is the pair capacity, shared equally between the contributions of all ranks
+    nnz = count // world_size
+    dense_size = 4*count
+    op_buf = SimBuffer(np.zeros((count,), dtype=ACCL_SPARSE_PAIR_DTYPE), cclo_inst.cclo.socket)
+    res_buf = SimBuffer(np.zeros((count,), dtype=ACCL_SPARSE_PAIR_DTYPE), cclo_inst.cclo.socket)
+    indices = np.random.choice(dense_size, nnz, replace=False)
+    values = np.random.randn(nnz).astype(np.float32)
+    sparse_pack(op_buf.buf, indices, values)
+    cclo_inst.sparse_allreduce(0, op_buf, res_buf, count)
+
+    expected = MPI.COMM_WORLD.allreduce(sparse_densify(op_buf.buf, dense_size), op=MPI.SUM)
+    valid = res_buf.buf['index'][res_buf.buf['index'] != ACCL_SPARSE_EMPTY_INDEX]
+    if not (np.diff(valid.astype(np.int64)) > 0).all() or not np.isclose(sparse_densify(res_buf.buf, dense_size), expected).all():
+        print("Sparse allreduce failed")
+    else:
+        print("Sparse allreduce succeeded")
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='Tests for ACCL (emulation mode)')
     parser.add_argument('--nruns',      type=int,            default=1,     help='How many times to run each test')
@@ -270,6 +716,27 @@ if __name__ == "__main__":
     parser.add_argument('--reduce',     action='store_true', default=False, help='Run reduce test')
     parser.add_argument('--reduce_scatter', action='store_true', default=False, help='Run reduce-scatter test')
     parser.add_argument('--allreduce',  action='store_true', default=False, help='Run all-reduce test')
+    parser.add_argument('--scatterv',   action='store_true', default=False, help='Run scatterv test')
+    parser.add_argument('--gatherv',    action='store_true', default=False, help='Run gatherv test')
+    parser.add_argument('--allgatherv', action='store_true', default=False, help='Run allgatherv test')
+    parser.add_argument('--reduce_scatterv', action='store_true', default=False, help='Run reduce-scatterv test')
+    parser.add_argument('--probe',      action='store_true', default=False, help='Run probe and matched receive test')
+    parser.add_argument('--recv_up_to', action='store_true', default=False, help='Run variable-length receive test')
+    parser.add_argument('--rendezvous', action='store_true', default=False, help='Run rendezvous send/receive test (with --tcp)')
+    parser.add_argument('--rma',        action='store_true', default=False, help='Run one-sided put/get test (with --tcp)')
+    parser.add_argument('--split',      action='store_true', default=False, help='Run communicator split/dup test')
+    parser.add_argument('--hierarchical', action='store_true', default=False, help='Run two-level allreduce/bcast/allgather test')
+    parser.add_argument('--ring_order', action='store_true', default=False, help='Run ring collectives on a rack-grouped ring order')
+    parser.add_argument('--open_con_bench', action='store_true', default=False, help='Run connection establishment benchmark against communicator size (with --tcp)')
+    parser.add_argument('--sparse_allreduce', action='store_true', default=False, help='Run sparse (index, value) all-reduce test')
+    parser.add_argument('--reduce_funcs', action='store_true', default=False, help='Run reduce-scatter/all-reduce with MAX and MIN')
+    parser.add_argument('--allreduce_dual_ring', action='store_true', default=False, help='Run dual ring all-reduce test and single/dual ring timing')
+    parser.add_argument('--allreduce_pipeline', action='store_true', default=False, help='Run all-reduce pipelining benchmark sweep')
+    parser.add_argument('--sequencer',  action='store_true', default=False, help='Run ring collectives with and without the collective sequencer')
+    parser.add_argument('--multicast',  action='store_true', default=False, help='Run broadcasts with and without multicast')
+    parser.add_argument('--allreduce_compressed', action='store_true', default=False, help='Run compressed all-reduce accuracy/throughput benchmark')
+    parser.add_argument('--stochastic_rounding', action='store_true', default=False, help='Requantize bf16 partial sums with stochastic rounding')
+    parser.add_argument('--q8_int_reduce', action='store_true', default=False, help='Reduce block-scaled int8 partial sums in the integer domain')
     parser.add_argument('--reduce_func', type=int,           default=0,     help='Function index for reduce')
     parser.add_argument('--tcp',        action='store_true', default=False, help='Run test using TCP')
 
@@ -296,7 +763,13 @@ if __name__ == "__main__":
         ranks.append({"ip": "127.0.0.1", "port": args.start_port+world_size+i, "session_id":i, "max_segment_size": args.rxbuf_size})
 
     #configure FPGA and CCLO cores with the default 16 RX buffers of size given by args.rxbuf_size
-    cclo_inst = accl(ranks, local_rank, bufsize=args.rxbuf_size, protocol=("TCP" if args.tcp else "UDP"), sim_sock="tcp://localhost:"+str(args.start_port+local_rank))
+    #the emulator provides all arithmetic plugins, including the reduction functions beyond SUM
+    arith_config = dict(ACCL_EXTENDED_ARITH_CONFIG)
+    if args.stochastic_rounding:
+        arith_config[('float32', 'bfloat16')] = ACCL_SR_ARITH_CONFIG[('float32', 'bfloat16')]
+    if args.q8_int_reduce:
+        arith_config[('float32', 'int8')] = ACCL_Q8_INT_ARITH_CONFIG[('float32', 'int8')]
+    cclo_inst = accl(ranks, local_rank, bufsize=args.rxbuf_size, protocol=("TCP" if args.tcp else "UDP"), arith_config=arith_config, sim_sock="tcp://localhost:"+str(args.start_port+local_rank))
     cclo_inst.set_timeout(10**8)
     #barrier here to make sure all the devices are configured before testing
     comm.barrier()
@@ -329,6 +802,44 @@ if __name__ == "__main__":
                 test_reduce_scatter(cclo_inst, world_size, local_rank, i, args.count, args.reduce_func)
             if args.allreduce:
                 test_allreduce(cclo_inst, world_size, local_rank, i, args.count, args.reduce_func)
+            if args.reduce_funcs:
+                test_reduce_funcs(cclo_inst, world_size, local_rank, args.count)
+            if args.allreduce_dual_ring:
+                test_allreduce_dual_ring(cclo_inst, world_size, local_rank, args.count, args.nruns)
+            if args.allreduce_pipeline:
+                test_allreduce_pipeline_sweep(cclo_inst, world_size, local_rank, args.nruns)
+            if args.sequencer:
+                test_sequencer(cclo_inst, world_size, local_rank, args.count, args.nruns)
+            if args.multicast:
+                test_multicast(cclo_inst, world_size, local_rank, args.count, args.nruns)
+            if args.allreduce_compressed:
+                test_allreduce_compressed(cclo_inst, world_size, local_rank, args.count, args.nruns)
+            if args.scatterv:
+                test_scatterv(cclo_inst, world_size, local_rank, i, args.count)
+            if args.gatherv:
+                test_gatherv(cclo_inst, world_size, local_rank, i, args.count)
+            if args.allgatherv:
+                test_allgatherv(cclo_inst, world_size, local_rank, args.count)
+            if args.reduce_scatterv:
+                test_reduce_scatterv(cclo_inst, world_size, local_rank, args.count, args.reduce_func)
+            if args.probe:
+                test_probe(cclo_inst, world_size, local_rank, args.count)
+            if args.recv_up_to:
+                test_recv_up_to(cclo_inst, world_size, local_rank, args.count)
+            if args.rendezvous:
+                test_sendrecv_rendezvous(cclo_inst, world_size, local_rank, args.count)
+            if args.rma:
+                test_rma(cclo_inst, world_size, local_rank, args.count)
+            if args.split:
+                test_split(cclo_inst, world_size, local_rank, args.count)
+            if args.hierarchical:
+                test_hierarchical(cclo_inst, world_size, local_rank, args.count)
+            if args.ring_order:
+                test_ring_order(cclo_inst, world_size, local_rank, args.count)
+            if args.open_con_bench:
+                test_open_con_bench(cclo_inst, args.nruns)
+            if args.sparse_allreduce:
+                test_sparse_allreduce(cclo_inst, world_size, local_rank, args.count)
 
     except KeyboardInterrupt:
         print("CTR^C")
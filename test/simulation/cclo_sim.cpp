@@ -420,7 +420,10 @@ int main(int argc, char **argv)
     string eth_type = argv[1];
     unsigned int starting_port = atoi(argv[2]);
 
-    zmq_intf_context ctx = zmq_intf(starting_port, local_rank, world_size);
+    //optional network model options follow, e.g. latency_us=5 drop_rate=0.01
+    network_model model = parse_network_model(argc, argv, 4);
+
+    zmq_intf_context ctx = zmq_intf(starting_port, local_rank, world_size, model);
 
     int status = 0;
 
@@ -20,12 +20,89 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <random>
 #include "ccl_offload_control.h"
 
 using namespace std;
 using namespace hlslib;
 
-zmq_intf_context zmq_intf(unsigned int starting_port, unsigned int local_rank, unsigned int world_size)
+network_model parse_network_model(int argc, char **argv, int first){
+    network_model model;
+    for(int i = first; i < argc; i++){
+        string arg = argv[i];
+        size_t pos = arg.find('=');
+        if(pos == string::npos){
+            cout << "Ignoring network option " << arg << endl;
+            continue;
+        }
+        string key = arg.substr(0, pos);
+        double val = stod(arg.substr(pos+1));
+        if(key == "bandwidth_gbps") model.bandwidth_gbps = val;
+        else if(key == "burst_bytes") model.burst_bytes = val;
+        else if(key == "latency_us") model.latency_us = val;
+        else if(key == "jitter_us") model.jitter_us = val;
+        else if(key == "drop_rate") model.drop_rate = val;
+        else if(key == "reorder_rate") model.reorder_rate = val;
+        else if(key == "reorder_us") model.reorder_us = val;
+        else if(key == "seed") model.seed = val;
+        else cout << "Ignoring network option " << arg << endl;
+    }
+    return model;
+}
+
+//moves packets through the token bucket of their link, then the delay queue, onto the socket
+void network_scheduler(network_state *net, zmqpp::socket *socket){
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    double bytes_per_us = net->model.bandwidth_gbps * 1000 / 8;
+    auto micros = [](double us){
+        return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, micro>(us));
+    };
+    auto burst_time = micros((bytes_per_us > 0) ? net->model.burst_bytes / bytes_per_us : 0);
+    while(true){
+        {
+            lock_guard<mutex> guard(net->lock);
+            auto now = chrono::steady_clock::now();
+            for(auto &entry : net->links){
+                network_link &link = entry.second;
+                //a packet leaves once the bucket holds tokens for it, the bucket refilling at the
+                //link bandwidth; release times are exact, whatever the period of the scheduler
+                while(!link.queue.empty()){
+                    network_packet pkt = link.queue.front();
+                    auto release = max(pkt.due, link.tat - burst_time);
+                    if(release > now){
+                        break;
+                    }
+                    link.queue.pop_front();
+                    link.tat = max(release, link.tat) + micros((bytes_per_us > 0) ? pkt.bytes / bytes_per_us : 0);
+                    //jitter does not reorder packets of a link, only reorder_rate does
+                    pkt.due = max(release + micros(net->model.latency_us + net->model.jitter_us * uniform(net->rng)), link.last_due);
+                    link.last_due = pkt.due;
+                    if(uniform(net->rng) < net->model.reorder_rate){
+                        pkt.due += micros(net->model.reorder_us);
+                        cout << "ETH Reorder packet to " << pkt.dest << endl;
+                    }
+                    pkt.seqn = net->nreleased++;
+                    net->delayed.push(pkt);
+                }
+            }
+            while(!net->delayed.empty() && net->delayed.top().due <= now){
+                const network_packet &pkt = net->delayed.top();
+                zmqpp::message message;
+                //first part of the message is the destination port ID
+                message << pkt.dest;
+                //second part of the message is the local rank of the sender
+                message << pkt.src;
+                //finally the data
+                message << pkt.data;
+                socket->send(message);
+                net->delayed.pop();
+            }
+        }
+        this_thread::sleep_for(chrono::microseconds(10));
+    }
+}
+
+zmq_intf_context zmq_intf(unsigned int starting_port, unsigned int local_rank, unsigned int world_size, network_model model)
 {
     zmq_intf_context ctx;
 
@@ -64,12 +141,19 @@ zmq_intf_context zmq_intf(unsigned int starting_port, unsigned int local_rank, u
 
     this_thread::sleep_for(chrono::milliseconds(1000));
 
+    cout << "Rank " << local_rank << " network: " << model.bandwidth_gbps << " Gbps (0 unlimited), "
+         << model.latency_us << " us latency, " << model.jitter_us << " us jitter, "
+         << model.drop_rate << " drop rate, " << model.reorder_rate << " reorder rate, seed " << model.seed << endl;
+    ctx.network = new network_state;
+    ctx.network->model = model;
+    ctx.network->rng.seed(model.seed + local_rank);
+    thread(network_scheduler, ctx.network, ctx.eth_tx_socket).detach();
+
     return ctx;
 }
 
 void eth_endpoint_egress_port(zmq_intf_context *ctx, Stream<stream_word > &in, unsigned int local_rank, bool remap_dest){
 
-    zmqpp::message message;
     Json::Value packet;
     Json::StreamWriterBuilder builder;
 
@@ -99,21 +183,24 @@ void eth_endpoint_egress_port(zmq_intf_context *ctx, Stream<stream_word > &in, u
             dest++;
         }
     }
-    //first part of the message is the destination port ID
-    message << to_string(dest);
-    //second part of the message is the local rank of the sender
-    message << to_string(local_rank);
-    //finally package the data
-    string str = Json::writeString(builder, packet);
-    message << str;
+    //hand the packet to the network model, which sends it after its link delay
+    network_packet pkt;
+    pkt.dest = to_string(dest);
+    pkt.src = to_string(local_rank);
+    pkt.data = Json::writeString(builder, packet);
+    pkt.bytes = idx;
+    lock_guard<mutex> guard(ctx->network->lock);
+    bernoulli_distribution drop(ctx->network->model.drop_rate);
+    if(drop(ctx->network->rng)){
+        cout << "ETH Drop " << idx << " bytes to " << dest << endl;
+        return;
+    }
     cout << "ETH Send " << idx << " bytes to " << dest << endl;
 #ifdef ZMQ_ETH_VERBOSE
-    cout << str << endl;
+    cout << pkt.data << endl;
 #endif
-    ctx->eth_tx_socket->send(message);
-    //add some spacing to encourage realistic
-    //interleaving between messsages in fabric
-    this_thread::sleep_for(chrono::milliseconds(10));
+    pkt.due = chrono::steady_clock::now();
+    ctx->network->links[pkt.dest].queue.push_back(pkt);
 }
 
 void eth_endpoint_ingress_port(zmq_intf_context *ctx, Stream<stream_word > &out){
@@ -21,17 +21,69 @@
 #include "ap_int.h"
 #include "ap_axi_sdata.h"
 #include <vector>
+#include <deque>
+#include <queue>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <random>
+
+//model of the emulated network, applied on egress to each link (destination) separately
+struct network_model{
+    double bandwidth_gbps = 0;//link bandwidth, 0 for unlimited
+    unsigned int burst_bytes = 16384;//depth of the token bucket of a link
+    double latency_us = 0;//base one-way latency
+    double jitter_us = 0;//extra latency, uniformly distributed up to this value
+    double drop_rate = 0;//fraction of packets dropped
+    double reorder_rate = 0;//fraction of packets held back, to be overtaken by later packets of their link
+    double reorder_us = 1000;//how long reordered packets are held back, on top of their latency
+    unsigned int seed = 0;//seed of the random drops, jitter and reordering, offset by the local rank
+};
+
+struct network_packet{
+    std::string dest;
+    std::string src;
+    std::string data;
+    unsigned int bytes;//bytes on the wire
+    std::chrono::steady_clock::time_point due;//when queued, then when delivered
+    unsigned long seqn;//order of release, breaks ties in the delay queue
+    bool operator>(const network_packet &other) const {
+        return (due > other.due) || (due == other.due && seqn > other.seqn);
+    }
+};
+
+//packets wait for tokens in the queue of their link, then for their delivery time in the delay queue;
+//both are served by a scheduler thread, the only one sending on the egress socket. The token bucket
+//is kept in its virtual scheduling form: the bucket is full again at tat, in the absence of traffic
+struct network_link{
+    std::deque<network_packet> queue;
+    std::chrono::steady_clock::time_point tat;
+    std::chrono::steady_clock::time_point last_due;
+};
+
+struct network_state{
+    network_model model;
+    std::mutex lock;
+    std::map<std::string, network_link> links;
+    std::priority_queue<network_packet, std::vector<network_packet>, std::greater<network_packet> > delayed;
+    unsigned long nreleased = 0;
+    std::mt19937 rng;//draws of the model, under lock
+};
 
 struct zmq_intf_context{
     zmqpp::context context;
     zmqpp::socket *cmd_socket;
     zmqpp::socket *eth_tx_socket;
     zmqpp::socket *eth_rx_socket;
+    network_state *network;
     bool stop = false;
     zmq_intf_context() : context() {}
 };
 
-zmq_intf_context zmq_intf(unsigned int starting_port, unsigned int local_rank, unsigned int world_size);
+//network model options, as key=value arguments (e.g. latency_us=5) starting at argv[first]
+network_model parse_network_model(int argc, char **argv, int first);
+zmq_intf_context zmq_intf(unsigned int starting_port, unsigned int local_rank, unsigned int world_size, network_model model = network_model());
 void serve_zmq(zmq_intf_context *ctx, uint32_t *cfgmem, std::vector<char> &devicemem, hlslib::Stream<ap_axiu<32,0,0,0> > &cmd, hlslib::Stream<ap_axiu<32,0,0,0> > &sts);
 void eth_endpoint_ingress_port(zmq_intf_context *ctx, hlslib::Stream<stream_word > &out);
 void eth_endpoint_egress_port(zmq_intf_context *ctx, hlslib::Stream<stream_word > &in, unsigned int local_rank, bool remap_dest);